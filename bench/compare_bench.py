@@ -0,0 +1,73 @@
+"""
+Compare two raspi_hw_bench JSON runs and flag regressions.
+
+Make a baseline and a new run with:
+    raspi_hw_bench --benchmark_out=baseline.json --benchmark_out_format=json
+    raspi_hw_bench --benchmark_out=current.json --benchmark_out_format=json
+Then:
+    python3 compare_bench.py baseline.json current.json --threshold 0.10
+
+Exits with 1 if any benchmark got slower by more than the threshold.
+"""
+import argparse
+import json
+import sys
+
+
+def load_times(path):
+    """
+    Read the time per iteration of every benchmark in a run.
+
+    :param path: The JSON file written by --benchmark_out.
+    :return: Dict of benchmark name to (time, unit). With repetitions only
+        the mean is kept.
+    """
+    with open(path) as f:
+        run = json.load(f)
+    times = {}
+    for bench in run["benchmarks"]:
+        if bench.get("run_type") == "aggregate" and bench.get("aggregate_name") != "mean":
+            continue
+        name = bench.get("run_name", bench["name"])
+        times[name] = (bench["real_time"], bench["time_unit"])
+    return times
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two raspi_hw_bench JSON runs.")
+    parser.add_argument("baseline", help="JSON file from the baseline run")
+    parser.add_argument("current", help="JSON file from the new run")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="Slowdown that counts as a regression, 0.10 is 10 percent")
+    args = parser.parse_args()
+
+    baseline = load_times(args.baseline)
+    current = load_times(args.current)
+    regressions = []
+    print(f"{'Benchmark':<48} {'Baseline':>14} {'Current':>14} {'Change':>9}")
+    for name, (base_time, unit) in baseline.items():
+        if name not in current:
+            print(f"{name:<48} {base_time:>11.3f} {unit:<2} {'missing':>14}")
+            continue
+        new_time, new_unit = current[name]
+        if new_unit != unit:
+            print(f"{name:<48} time units differ ({unit} vs {new_unit}), skipped")
+            continue
+        change = (new_time - base_time) / base_time if base_time > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions.append(name)
+        print(f"{name:<48} {base_time:>11.3f} {unit:<2} {new_time:>11.3f} {unit:<2} {change:>+8.1%}{flag}")
+    for name in current.keys() - baseline.keys():
+        print(f"{name:<48} {'new':>14} {current[name][0]:>11.3f} {current[name][1]:<2}")
+
+    if regressions:
+        print(f"\n{len(regressions)} regression(s) above {args.threshold:.0%}.")
+        return 1
+    print("\nNo regressions.")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
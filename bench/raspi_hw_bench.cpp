@@ -0,0 +1,818 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <benchmark/benchmark.h>
+#ifdef RASPI_HW_BENCH_HAVE_PNG
+#include <png.h>
+#endif
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+#include "camera_control.h"
+#include "hardware_control.h"
+#include "image.h"
+#include "image_ops.h"
+#include "image_thread_pool.h"
+#include "logger.h"
+#include "metrics.h"
+#include "motor_control.h"
+#include "qoi_codec.h"
+#include "simulated_camera_backend.h"
+#include "simulated_gpio_backend.h"
+
+using namespace std;
+
+namespace {
+
+struct Resolution {
+    unsigned int width;
+    unsigned int height;
+};
+
+// Sizes the camera is normally run at, indexed by the first benchmark argument.
+constexpr Resolution resolutions[] = {{320, 240}, {640, 480}, {1280, 960}, {1920, 1080}};
+// Camera encodings, indexed by the second benchmark argument.
+constexpr PixelFormat encodings[] = {PixelFormat::png, PixelFormat::jpeg, PixelFormat::rgb};
+
+/**
+ * Get the resolution picked by a benchmark argument.
+ *
+ * @param state The benchmark state.
+ * @param arg The argument index.
+ * @return The resolution.
+ */
+Resolution resolution_arg(const benchmark::State& state, const int arg = 0) {
+    return resolutions[state.range(arg)];
+}
+
+/**
+ * Get the size raspicam reports for a capture.
+ *
+ * @param resolution The image size.
+ * @return width*height*3+54 bytes.
+ */
+size_t capture_size(const Resolution& resolution) {
+    return static_cast<size_t>(resolution.width) * resolution.height * 3 + 54;
+}
+
+/**
+ * Make an rgb capture with the raspicam header still on it.
+ *
+ * @param resolution The image size.
+ * @return The image, filled with a gradient.
+ */
+Image make_capture(const Resolution& resolution) {
+    Image image(capture_size(resolution), resolution.width, resolution.height, PixelFormat::rgb, true);
+    for (size_t i = 0; i < image.get_size(); ++i) {
+        image.get_data()[i] = static_cast<unsigned char>(i * 7);
+    }
+    return image;
+}
+
+/**
+ * Label a benchmark with its resolution and encoding.
+ *
+ * @param state The benchmark state.
+ * @param resolution The image size.
+ * @param format The encoding, or none to leave it out.
+ */
+void set_label(benchmark::State& state, const Resolution& resolution, const PixelFormat format = PixelFormat::none) {
+    string label = to_string(resolution.width) + "x" + to_string(resolution.height);
+    if (format != PixelFormat::none) {
+        label += string(" ") + pixel_format_info(format).name;
+    }
+    state.SetLabel(label);
+}
+
+/**
+ * Get a directory for benchmark files, in memory when tmpfs is there
+ * so the disk does not dominate the numbers.
+ *
+ * @return The directory path.
+ */
+string get_bench_dir() {
+    const string base = filesystem::exists("/dev/shm") ? "/dev/shm" : filesystem::temp_directory_path().string();
+    const string dir = base + "/raspi_hw_bench";
+    filesystem::create_directories(dir);
+    return dir;
+}
+
+/**
+ * Make a motor on the simulated GPIO. Real-time scheduling is left off
+ * so the numbers are the same with and without root.
+ *
+ * @param gpio Set to the simulated backend the motor drives.
+ * @return The motor with its pins in output mode.
+ */
+unique_ptr<MotorController> make_simulated_motor(SimulatedGpioBackend** gpio = nullptr) {
+    auto backend = make_unique<SimulatedGpioBackend>();
+    if (gpio != nullptr) {
+        *gpio = backend.get();
+    }
+    MotionEngineConfig engine_config;
+    engine_config.pin_thread = false;
+    engine_config.realtime = false;
+    auto motor = make_unique<MotorController>(std::move(backend), engine_config);
+    motor->set_to_output_mode();
+    return motor;
+}
+
+/**
+ * Copying an image only shares the buffer.
+ */
+void BM_ImageCopy(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    const Image source = make_capture(resolution);
+    for (auto _ : state) {
+        Image copy(source);
+        benchmark::DoNotOptimize(copy.get_data());
+    }
+    set_label(state, resolution);
+}
+
+/**
+ * Cloning an image copies the pixels into a new buffer.
+ */
+void BM_ImageClone(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    const Image source = make_capture(resolution);
+    for (auto _ : state) {
+        Image copy = source.clone();
+        benchmark::DoNotOptimize(copy.get_data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * source.get_size()));
+    set_label(state, resolution);
+}
+
+/**
+ * copy_from() copies the pixels into a buffer that is already big enough.
+ */
+void BM_ImageCopyFrom(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    const Image source = make_capture(resolution);
+    Image copy = source.clone();
+    for (auto _ : state) {
+        copy.copy_from(source);
+        benchmark::DoNotOptimize(copy.get_data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * source.get_size()));
+    set_label(state, resolution);
+}
+
+/**
+ * Moving an image back and forth between two objects.
+ */
+void BM_ImageMove(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    Image first = make_capture(resolution);
+    Image second;
+    for (auto _ : state) {
+        second = std::move(first);
+        first = std::move(second);
+        benchmark::DoNotOptimize(first.get_data());
+    }
+    set_label(state, resolution);
+}
+
+/**
+ * Dropping the raspicam header from a fresh capture.
+ */
+void BM_RemoveRgbHeader(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    Image image = make_capture(resolution);
+    for (auto _ : state) {
+        state.PauseTiming();
+        image.reset(capture_size(resolution), resolution.width, resolution.height, PixelFormat::rgb, true);
+        state.ResumeTiming();
+        image.remove_rgb_header();
+        benchmark::DoNotOptimize(image.get_size());
+    }
+    set_label(state, resolution);
+}
+
+/**
+ * Mirroring an rgb image left to right in place.
+ */
+void BM_FlipRgbH(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    Image image = make_capture(resolution);
+    image.remove_rgb_header();
+    for (auto _ : state) {
+        image.flip_rgb_h();
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+    set_label(state, resolution);
+}
+
+/**
+ * Mirroring an rgb image top to bottom in place.
+ */
+void BM_FlipRgbV(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    Image image = make_capture(resolution);
+    image.remove_rgb_header();
+    for (auto _ : state) {
+        image.flip_rgb_v();
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+    set_label(state, resolution);
+}
+
+/**
+ * Making a crop view of the middle quarter. Nothing is copied, so this
+ * should not grow with resolution.
+ */
+void BM_Crop(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    Image image = make_capture(resolution);
+    image.remove_rgb_header();
+    for (auto _ : state) {
+        Image view = image.crop(resolution.width / 4, resolution.height / 4, resolution.width / 2,
+                                resolution.height / 2);
+        benchmark::DoNotOptimize(view.get_data());
+    }
+    set_label(state, resolution);
+}
+
+/**
+ * Shrinking an rgb image by a whole factor, 2 or 4 by the second argument.
+ */
+void BM_Downscale(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    const auto factor = static_cast<unsigned int>(state.range(1));
+    Image image = make_capture(resolution);
+    image.remove_rgb_header();
+    for (auto _ : state) {
+        Image scaled = image.downscale(factor);
+        benchmark::DoNotOptimize(scaled.get_data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+    set_label(state, resolution);
+}
+
+/**
+ * What downscaling cost before: copy the pixels out, as np.array() does,
+ * then shrink them with the reference loop. Compare with BM_Downscale.
+ */
+void BM_CopyThenDownscaleScalar(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    const auto factor = static_cast<unsigned int>(state.range(1));
+    Image image = make_capture(resolution);
+    image.remove_rgb_header();
+    const unsigned int new_width = resolution.width / factor;
+    const unsigned int new_height = resolution.height / factor;
+    vector<unsigned char> scaled(static_cast<size_t>(new_width) * new_height * 3);
+    for (auto _ : state) {
+        vector<unsigned char> copy(image.get_data(), image.get_data() + image.get_size());
+        downscale_box_scalar(copy.data(), resolution.width, resolution.height,
+                             static_cast<size_t>(resolution.width) * 3, 3, factor, scaled.data(),
+                             static_cast<size_t>(new_width) * 3);
+        benchmark::DoNotOptimize(scaled.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+    set_label(state, resolution);
+}
+
+/**
+ * Resizing an rgb image to 0.4 of its size, bilinear (0) or area (1).
+ */
+void BM_Resize(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    const ResizeFilter filter = state.range(1) == 0 ? ResizeFilter::bilinear : ResizeFilter::area;
+    Image image = make_capture(resolution);
+    image.remove_rgb_header();
+    for (auto _ : state) {
+        Image resized = image.resize(resolution.width * 2 / 5, resolution.height * 2 / 5, filter);
+        benchmark::DoNotOptimize(resized.get_data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+    state.SetLabel(to_string(resolution.width) + "x" + to_string(resolution.height) +
+                   (filter == ResizeFilter::bilinear ? " bilinear" : " area"));
+}
+
+/**
+ * Give the image thread pool 4 threads, whatever the core count, and
+ * label a scaling benchmark.
+ *
+ * @param state The benchmark state, resolution then thread count.
+ * @return The thread count to pass to the operation.
+ */
+unsigned int set_up_threads(benchmark::State& state) {
+    if (ImageThreadPool::instance().get_thread_count() != 4) {
+        ImageThreadPool::instance().set_thread_count(4);
+    }
+    const Resolution resolution = resolution_arg(state);
+    const auto threads = static_cast<unsigned int>(state.range(1));
+    state.SetLabel(to_string(resolution.width) + "x" + to_string(resolution.height) + " " + to_string(threads) +
+                   (threads == 1 ? " thread" : " threads"));
+    return threads;
+}
+
+/**
+ * Horizontal flip on 1, 2 and 4 threads.
+ */
+void BM_FlipRgbHThreads(benchmark::State& state) {
+    const unsigned int threads = set_up_threads(state);
+    Image image = make_capture(resolution_arg(state));
+    image.remove_rgb_header();
+    for (auto _ : state) {
+        image.flip_rgb_h(threads);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+}
+
+/**
+ * Vertical flip on 1, 2 and 4 threads.
+ */
+void BM_FlipRgbVThreads(benchmark::State& state) {
+    const unsigned int threads = set_up_threads(state);
+    Image image = make_capture(resolution_arg(state));
+    image.remove_rgb_header();
+    for (auto _ : state) {
+        image.flip_rgb_v(threads);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+}
+
+/**
+ * rgb to gray on 1, 2 and 4 threads.
+ */
+void BM_ConvertThreads(benchmark::State& state) {
+    const unsigned int threads = set_up_threads(state);
+    Image source = make_capture(resolution_arg(state));
+    source.remove_rgb_header();
+    Image image;
+    for (auto _ : state) {
+        state.PauseTiming();
+        image = source;
+        state.ResumeTiming();
+        image.convert_to(PixelFormat::gray, threads);
+        benchmark::DoNotOptimize(image.get_data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * source.get_size()));
+}
+
+/**
+ * Area resize to 0.4 of the size on 1, 2 and 4 threads.
+ */
+void BM_ResizeThreads(benchmark::State& state) {
+    const unsigned int threads = set_up_threads(state);
+    const Resolution resolution = resolution_arg(state);
+    Image image = make_capture(resolution);
+    image.remove_rgb_header();
+    for (auto _ : state) {
+        Image resized = image.resize(resolution.width * 2 / 5, resolution.height * 2 / 5, ResizeFilter::area, threads);
+        benchmark::DoNotOptimize(resized.get_data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+}
+
+/**
+ * Saving a capture to tmpfs, per resolution and encoding.
+ */
+void BM_Save(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    const PixelFormat format = encodings[state.range(1)];
+    Image image(capture_size(resolution), resolution.width, resolution.height, format, true);
+    if (format == PixelFormat::rgb) {
+        image.remove_rgb_header();
+    }
+    const string file_path = get_bench_dir() + "/save." + pixel_format_info(format).name;
+    for (auto _ : state) {
+        if (!image.save(file_path)) {
+            state.SkipWithError("Save failed.");
+            break;
+        }
+    }
+    remove(file_path.c_str());
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+    set_label(state, resolution, format);
+}
+
+/**
+ * Make a headerless rgb frame that compresses like a camera frame: a
+ * smooth gradient with a little sensor noise, rather than the repeating
+ * ramp of make_capture that any encoder shrinks to nothing.
+ *
+ * @param resolution The image size.
+ * @return The image.
+ */
+Image make_scene(const Resolution& resolution) {
+    Image image(static_cast<size_t>(resolution.width) * resolution.height * 3, resolution.width, resolution.height,
+                PixelFormat::rgb, false);
+    unsigned char* pixel = image.get_data();
+    uint32_t noise = 12345;
+    for (unsigned int y = 0; y < resolution.height; ++y) {
+        for (unsigned int x = 0; x < resolution.width; ++x) {
+            noise = noise * 1103515245 + 12345;
+            const unsigned int jitter = (noise >> 16) & 3;
+            *pixel++ = static_cast<unsigned char>(x * 255 / resolution.width + jitter);
+            *pixel++ = static_cast<unsigned char>(y * 255 / resolution.height + jitter);
+            *pixel++ = static_cast<unsigned char>((x + y) * 127 / (resolution.width + resolution.height) + 64);
+        }
+    }
+    return image;
+}
+
+/**
+ * QOI encoding into memory, per resolution. Reports the raw to encoded
+ * size ratio alongside the throughput.
+ */
+void BM_EncodeQoi(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    const Image image = make_scene(resolution);
+    size_t encoded_size = 0;
+    for (auto _ : state) {
+        Image encoded = encode_qoi(image);
+        encoded_size = encoded.get_size();
+        benchmark::DoNotOptimize(encoded.get_data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+    state.counters["ratio"] = encoded_size == 0 ? 0 : static_cast<double>(image.get_size()) / encoded_size;
+    set_label(state, resolution, PixelFormat::qoi);
+}
+
+/**
+ * QOI decoding back to rgb, per resolution.
+ */
+void BM_DecodeQoi(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    const Image image = make_scene(resolution);
+    const Image encoded = encode_qoi(image);
+    for (auto _ : state) {
+        Image decoded = decode_qoi(encoded);
+        benchmark::DoNotOptimize(decoded.get_data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+    set_label(state, resolution, PixelFormat::qoi);
+}
+
+/**
+ * Saving a headerless rgb frame to tmpfs, raw (0) or QOI encoded while
+ * writing (1), per resolution.
+ */
+void BM_SaveQoi(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    const bool encode = state.range(1) != 0;
+    const Image image = make_scene(resolution);
+    const string file_path = get_bench_dir() + (encode ? "/save.qoi" : "/save.rgb");
+    for (auto _ : state) {
+        if (!image.save(file_path)) {
+            state.SkipWithError("Save failed.");
+            break;
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+    state.counters["ratio"] = static_cast<double>(image.get_size()) / filesystem::file_size(file_path);
+    remove(file_path.c_str());
+    set_label(state, resolution, encode ? PixelFormat::qoi : PixelFormat::rgb);
+}
+
+#ifdef RASPI_HW_BENCH_HAVE_PNG
+/**
+ * PNG encoding into memory with libpng at its default settings, per
+ * resolution. The simulated camera hands back pre-made png bytes, so
+ * this stands in for what the camera's png path costs on the device.
+ */
+void BM_EncodePng(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    const Image image = make_scene(resolution);
+    vector<unsigned char> encoded;
+    encoded.reserve(image.get_size());
+    const auto append = [](png_structp png, png_bytep data, const png_size_t size) {
+        auto* out = static_cast<vector<unsigned char>*>(png_get_io_ptr(png));
+        out->insert(out->end(), data, data + size);
+    };
+    for (auto _ : state) {
+        encoded.clear();
+        png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+        png_infop info = png_create_info_struct(png);
+        if (png == nullptr || info == nullptr || setjmp(png_jmpbuf(png))) {
+            png_destroy_write_struct(&png, &info);
+            state.SkipWithError("PNG encode failed.");
+            break;
+        }
+        png_set_write_fn(png, &encoded, append, nullptr);
+        png_set_IHDR(png, info, resolution.width, resolution.height, 8, PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+                     PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+        png_write_info(png, info);
+        for (unsigned int y = 0; y < resolution.height; ++y) {
+            png_write_row(png, image.get_data() + static_cast<size_t>(y) * resolution.width * 3);
+        }
+        png_write_end(png, nullptr);
+        png_destroy_write_struct(&png, &info);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * image.get_size()));
+    state.counters["ratio"] = encoded.empty() ? 0 : static_cast<double>(image.get_size()) / encoded.size();
+    set_label(state, resolution, PixelFormat::png);
+}
+#endif
+
+/**
+ * Capturing into a reused Image from the simulated camera, per
+ * resolution and encoding.
+ */
+void BM_Capture(benchmark::State& state) {
+    const Resolution resolution = resolution_arg(state);
+    const PixelFormat format = encodings[state.range(1)];
+    CameraController camera(make_unique<SimulatedCameraBackend>());
+    camera.set_image_width(resolution.width);
+    camera.set_image_height(resolution.height);
+    camera.set_image_encoding(format);
+    camera.open_camera();
+    Image image;
+    for (auto _ : state) {
+        if (!camera.capture_image(image)) {
+            state.SkipWithError("Capture failed.");
+            break;
+        }
+        benchmark::DoNotOptimize(image.get_data());
+    }
+    camera.release_camera();
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * capture_size(resolution)));
+    set_label(state, resolution, format);
+}
+
+/**
+ * Capturing 8 rgb frames from the simulated camera, per resolution,
+ * one capture_image() call per frame (0) or as one burst (1).
+ */
+void BM_CaptureBurst(benchmark::State& state) {
+    constexpr size_t frame_count = 8;
+    const Resolution resolution = resolution_arg(state);
+    const bool burst_mode = state.range(1) != 0;
+    CameraController camera(make_unique<SimulatedCameraBackend>());
+    camera.set_image_width(resolution.width);
+    camera.set_image_height(resolution.height);
+    camera.set_image_encoding(PixelFormat::rgb);
+    camera.open_camera();
+    FrameBurst burst;
+    vector<Image> frames(frame_count);
+    for (auto _ : state) {
+        if (burst_mode) {
+            if (!camera.capture_burst(frame_count, burst)) {
+                state.SkipWithError("Burst failed.");
+                break;
+            }
+            benchmark::DoNotOptimize(burst.buffer.get());
+        } else {
+            for (Image& frame : frames) {
+                frame = camera.capture_image();
+                benchmark::DoNotOptimize(frame.get_data());
+            }
+        }
+    }
+    camera.release_camera();
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * frame_count * capture_size(resolution)));
+    set_label(state, resolution, PixelFormat::rgb);
+}
+
+/**
+ * Switching the simulated camera back and forth between two settings
+ * and capturing the first frame after each switch, with a 2 ms open.
+ * 0 changes the resolution with the setters and reopens, 1 changes it
+ * with profiles, and 2 switches profiles that only differ in iso and
+ * sharpness, which needs no reopen. Reports the mean first frame
+ * latency. Open and release messages are kept out of the output.
+ */
+void BM_CameraSwitch(benchmark::State& state) {
+    const int mode = static_cast<int>(state.range(0));
+    const LogLevel level = Logger::instance().get_level();
+    Logger::instance().set_level(LogLevel::warn);
+    auto backend = make_unique<SimulatedCameraBackend>();
+    backend->set_open_latency_us(2000);
+    CameraController camera(std::move(backend));
+    CameraConfig preview;
+    preview.image_width = 640;
+    preview.image_height = 480;
+    preview.encoding = PixelFormat::rgb;
+    CameraConfig full = preview;
+    if (mode == 2) {
+        full.iso = 100;
+        full.sharpness = 50;
+    } else {
+        full.image_width = 1920;
+        full.image_height = 1080;
+    }
+    camera.add_profile("preview", preview);
+    camera.add_profile("full", full);
+    camera.use_profile("preview");
+    camera.open_camera();
+    reset_metrics();
+    bool use_full = true;
+    for (auto _ : state) {
+        const CameraConfig& target = use_full ? full : preview;
+        if (mode == 0) {
+            camera.set_image_width(target.image_width);
+            camera.set_image_height(target.image_height);
+            camera.release_camera();
+            camera.open_camera();
+        } else if (!camera.use_profile(use_full ? "full" : "preview")) {
+            state.SkipWithError("Switch failed.");
+            break;
+        }
+        Image image = camera.capture_image();
+        benchmark::DoNotOptimize(image.get_data());
+        use_full = !use_full;
+    }
+    camera.release_camera();
+    Logger::instance().set_level(level);
+    state.counters["first_frame_us"] = get_metrics_snapshot().timers["first_frame"].mean_ns / 1000;
+}
+
+/**
+ * Cost of emitting steps to the simulated GPIO with 1 us between
+ * steps, so the time per step is the step overhead, per drive mode.
+ * Every step is one batched write.
+ */
+void BM_MotorStepEmission(benchmark::State& state) {
+    SimulatedGpioBackend* gpio = nullptr;
+    auto motor = make_simulated_motor(&gpio);
+    const auto mode = static_cast<DriveMode>(state.range(0));
+    motor->set_drive_mode(mode);
+    MotionProfileConfig profile;
+    profile.shape = ProfileShape::trapezoidal;
+    profile.start_velocity = 1e6;
+    profile.max_velocity = 1e6;
+    motor->set_motion_profile(profile);
+    const uint64_t writes_before = gpio->get_write_count();
+    for (auto _ : state) {
+        motor->rotate(360, 1);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(gpio->get_write_count() - writes_before));
+    state.SetLabel(mode == DriveMode::wave ? "wave" : mode == DriveMode::full_step ? "full_step" : "half_step");
+}
+
+/**
+ * Time for a 30 degree move with each profile shape. Constant is the
+ * old fixed delay loop.
+ */
+void BM_ProfileMove(benchmark::State& state) {
+    auto motor = make_simulated_motor();
+    const auto shape = static_cast<ProfileShape>(state.range(0));
+    MotionProfileConfig profile = motor->get_motion_profile();
+    profile.shape = shape;
+    motor->set_motion_profile(profile);
+    int direction = 1;
+    for (auto _ : state) {
+        motor->rotate(30, direction);
+        direction = -direction;
+    }
+    state.SetLabel(shape == ProfileShape::constant ? "constant" : shape == ProfileShape::trapezoidal ? "trapezoidal"
+        : "s_curve");
+}
+
+/**
+ * Eight 1280x960 captures 10 degrees apart with a 20 ms exposure, converted to
+ * bgr and saved. range(0) is 1 for HardwareController::scan(), which
+ * overlaps the moves with the rest, and 0 for the plain loop.
+ */
+void BM_Scan(benchmark::State& state) {
+    const bool pipelined = state.range(0) != 0;
+    HardwareController hardware_controller;
+    hardware_controller.initialize_all(make_unique<SimulatedCameraBackend>(20000), make_unique<SimulatedGpioBackend>());
+    CameraController& camera = *hardware_controller.camera_controller;
+    MotorController& motor = *hardware_controller.motor_controller;
+    camera.set_image_width(1280);
+    camera.set_image_height(960);
+    camera.set_image_encoding(PixelFormat::rgb);
+    camera.open_camera();
+    motor.set_to_output_mode();
+    vector<double> angles;
+    for (int i = 1; i <= 8; ++i) {
+        angles.push_back(i * 10.0);
+    }
+    ScanConfig scan_config;
+    scan_config.settle_ms = 10;
+    scan_config.output_format = PixelFormat::bgr;
+    scan_config.output_dir = get_bench_dir();
+    for (auto _ : state) {
+        if (pipelined) {
+            benchmark::DoNotOptimize(hardware_controller.scan(angles, scan_config));
+        } else {
+            vector<Image> frames;
+            for (size_t i = 0; i < angles.size(); ++i) {
+                motor.move_to(angles[i]);
+                this_thread::sleep_for(chrono::milliseconds(scan_config.settle_ms));
+                Image frame;
+                camera.capture_image(frame);
+                frame.remove_rgb_header();
+                frame.convert_to(scan_config.output_format);
+                char file_name[32];
+                snprintf(file_name, sizeof(file_name), "/scan_%04zu.", i);
+                benchmark::DoNotOptimize(frame.save(scan_config.output_dir + file_name + frame.get_encoding()));
+                frames.push_back(std::move(frame));
+            }
+        }
+        state.PauseTiming();
+        motor.move_to(0);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * angles.size()));
+    state.SetLabel(pipelined ? "scan" : "serial");
+}
+
+
+/**
+ * Cost of one latency sample, with metrics on (1) and off (0).
+ */
+void BM_RecordLatency(benchmark::State& state) {
+    set_metrics_enabled(state.range(0) != 0);
+    int64_t latency_ns = 0;
+    for (auto _ : state) {
+        record_latency(MetricTimer::capture, ++latency_ns);
+    }
+    set_metrics_enabled(true);
+    state.SetLabel(state.range(0) != 0 ? "on" : "off");
+}
+
+/**
+ * Cost of timing a scope, clock reads included, with metrics on (1)
+ * and off (0). This is what every instrumented call pays.
+ */
+void BM_ScopedLatency(benchmark::State& state) {
+    set_metrics_enabled(state.range(0) != 0);
+    for (auto _ : state) {
+        ScopedLatency latency(MetricTimer::flip);
+        benchmark::ClobberMemory();
+    }
+    set_metrics_enabled(true);
+    state.SetLabel(state.range(0) != 0 ? "on" : "off");
+}
+
+/**
+ * Cost of a debug log line when the level filters it out at run time.
+ */
+void BM_LogFiltered(benchmark::State& state) {
+    const LogLevel level = Logger::instance().get_level();
+    Logger::instance().set_level(LogLevel::info);
+    for (auto _ : state) {
+        RASPI_HW_LOG_DEBUG("Filtered " << state.iterations());
+        benchmark::ClobberMemory();
+    }
+    Logger::instance().set_level(level);
+}
+
+/**
+ * 320x240 rgb capture with metrics on (1) and off (0), to check the
+ * instrumentation stays small next to the work it measures.
+ */
+void BM_CaptureMetrics(benchmark::State& state) {
+    set_metrics_enabled(state.range(0) != 0);
+    CameraController camera(make_unique<SimulatedCameraBackend>());
+    camera.set_image_encoding(PixelFormat::rgb);
+    camera.open_camera();
+    Image image;
+    for (auto _ : state) {
+        camera.capture_image(image);
+        image.remove_rgb_header();
+        image.flip_rgb_v();
+    }
+    camera.release_camera();
+    set_metrics_enabled(true);
+    state.SetLabel(state.range(0) != 0 ? "on" : "off");
+}
+
+}
+
+BENCHMARK(BM_ImageCopy)->DenseRange(0, 3);
+BENCHMARK(BM_ImageClone)->DenseRange(0, 3);
+BENCHMARK(BM_ImageCopyFrom)->DenseRange(0, 3);
+BENCHMARK(BM_ImageMove)->DenseRange(0, 3);
+BENCHMARK(BM_RemoveRgbHeader)->DenseRange(0, 3);
+BENCHMARK(BM_FlipRgbH)->DenseRange(0, 3);
+BENCHMARK(BM_FlipRgbV)->DenseRange(0, 3);
+BENCHMARK(BM_Crop)->DenseRange(0, 3);
+BENCHMARK(BM_Downscale)->ArgsProduct({{0, 1, 2, 3}, {2, 4}});
+BENCHMARK(BM_CopyThenDownscaleScalar)->ArgsProduct({{0, 1, 2, 3}, {2, 4}});
+BENCHMARK(BM_Resize)->ArgsProduct({{0, 1, 2, 3}, {0, 1}});
+BENCHMARK(BM_FlipRgbHThreads)->ArgsProduct({{0, 1, 2, 3}, {1, 2, 4}})->UseRealTime();
+BENCHMARK(BM_FlipRgbVThreads)->ArgsProduct({{0, 1, 2, 3}, {1, 2, 4}})->UseRealTime();
+BENCHMARK(BM_ConvertThreads)->ArgsProduct({{0, 1, 2, 3}, {1, 2, 4}})->UseRealTime();
+BENCHMARK(BM_ResizeThreads)->ArgsProduct({{0, 1, 2, 3}, {1, 2, 4}})->UseRealTime();
+BENCHMARK(BM_Save)->ArgsProduct({{0, 1, 2, 3}, {0, 1, 2}});
+BENCHMARK(BM_EncodeQoi)->DenseRange(0, 3);
+BENCHMARK(BM_DecodeQoi)->DenseRange(0, 3);
+BENCHMARK(BM_SaveQoi)->ArgsProduct({{0, 1, 2, 3}, {0, 1}});
+#ifdef RASPI_HW_BENCH_HAVE_PNG
+BENCHMARK(BM_EncodePng)->DenseRange(0, 3);
+#endif
+BENCHMARK(BM_Capture)->ArgsProduct({{0, 1, 2, 3}, {0, 1, 2}});
+BENCHMARK(BM_CaptureBurst)->ArgsProduct({{0, 1, 2, 3}, {0, 1}});
+BENCHMARK(BM_CameraSwitch)->DenseRange(0, 2)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MotorStepEmission)->DenseRange(0, 2)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ProfileMove)->DenseRange(0, 2)->Iterations(2)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RecordLatency)->DenseRange(0, 1);
+BENCHMARK(BM_ScopedLatency)->DenseRange(0, 1);
+BENCHMARK(BM_LogFiltered);
+BENCHMARK(BM_CaptureMetrics)->DenseRange(0, 1);
+BENCHMARK(BM_Scan)->DenseRange(0, 1)->Iterations(2)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,61 @@
+"""
+Time cropping and shrinking a capture in C++ against the old way of
+copying it to numpy and resizing with PIL.
+
+Needs the py_raspi_hw_ctrl module, numpy and Pillow:
+    python3 resize_vs_pil.py --width 1920 --height 1080 --repeat 50
+"""
+import argparse
+import timeit
+
+import numpy as np
+from PIL import Image as PilImage
+from py_raspi_hw_ctrl import Image, PixelFormat, ResizeFilter
+
+
+def make_image(width, height):
+    """
+    Make an rgb image filled with noise.
+
+    :param width: The image width.
+    :param height: The image height.
+    :return: The image.
+    """
+    pixels = np.random.default_rng(0).integers(0, 256, (height, width, 3), dtype=np.uint8)
+    return Image(pixels, PixelFormat.rgb)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare Image.resize with numpy + PIL.")
+    parser.add_argument("--width", type=int, default=1920)
+    parser.add_argument("--height", type=int, default=1080)
+    parser.add_argument("--repeat", type=int, default=50)
+    args = parser.parse_args()
+
+    img = make_image(args.width, args.height)
+    half = (args.width // 2, args.height // 2)
+    quarter = (args.width // 4, args.height // 4)
+    roi = (args.width // 4, args.height // 4, args.width // 2, args.height // 2)
+    cases = {
+        "downscale 2x": (lambda: np.asarray(img.downscale(2)),
+                         lambda: PilImage.fromarray(np.array(img)).reduce(2)),
+        "downscale 4x": (lambda: np.asarray(img.downscale(4)),
+                         lambda: PilImage.fromarray(np.array(img)).reduce(4)),
+        "bilinear 1/2": (lambda: np.asarray(img.resize(*half, ResizeFilter.bilinear)),
+                         lambda: PilImage.fromarray(np.array(img)).resize(half, PilImage.BILINEAR)),
+        "area 1/4": (lambda: np.asarray(img.resize(*quarter, ResizeFilter.area)),
+                     lambda: PilImage.fromarray(np.array(img)).resize(quarter, PilImage.BOX)),
+        "crop + area": (lambda: np.asarray(img.crop(*roi).resize(*quarter)),
+                        lambda: PilImage.fromarray(np.array(img)).crop(
+                            (roi[0], roi[1], roi[0] + roi[2], roi[1] + roi[3])).resize(quarter, PilImage.BOX)),
+    }
+    print(f"{args.width}x{args.height}, best of {args.repeat}")
+    print(f"{'Case':<16} {'C++ (ms)':>10} {'numpy+PIL (ms)':>16} {'Speedup':>9}")
+    for name, (ours, theirs) in cases.items():
+        ours_ms = min(timeit.repeat(ours, number=1, repeat=args.repeat)) * 1000
+        theirs_ms = min(timeit.repeat(theirs, number=1, repeat=args.repeat)) * 1000
+        print(f"{name:<16} {ours_ms:>10.3f} {theirs_ms:>16.3f} {theirs_ms / ours_ms:>8.1f}x")
+
+
+if __name__ == "__main__":
+    main()
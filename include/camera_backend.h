@@ -0,0 +1,43 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef CAMERA_BACKEND_H
+#define CAMERA_BACKEND_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "pixel_format.h"
+
+/**
+ * Device level camera interface used by CameraController. The raspicam
+ * backend talks to the Pi camera and the simulated backend produces
+ * synthetic frames so capture code can run on any machine. The raspicam
+ * backend is only built when raspicam is found.
+ */
+class CameraBackend {
+
+public:
+    virtual ~CameraBackend() = default;
+    virtual bool open() = 0;
+    virtual void release() = 0;
+    virtual void set_width(unsigned int width) = 0;
+    virtual void set_height(unsigned int height) = 0;
+    virtual void set_encoding(PixelFormat encoding) = 0;
+    virtual void set_sharpness(int sharpness) = 0;
+    virtual void set_contrast(int contrast) = 0;
+    virtual void set_brightness(unsigned int brightness) = 0;
+    virtual void set_saturation(int saturation) = 0;
+    virtual void set_iso(int iso) = 0;
+    virtual void set_exposure_auto() = 0;
+    virtual void set_exposure_locked(bool locked) = 0;
+    [[nodiscard]] virtual size_t get_image_buffer_size() const = 0;
+    [[nodiscard]] virtual size_t get_image_buffer_size(unsigned int width, unsigned int height,
+                                                       PixelFormat encoding) const = 0;
+    virtual bool grab_retrieve(unsigned char* data, size_t size) = 0;
+};
+
+std::unique_ptr<CameraBackend> make_camera_backend(const std::string& name);
+std::string get_default_camera_backend_name();
+
+#endif //CAMERA_BACKEND_H
@@ -3,7 +3,7 @@
 //
 #ifndef CAMERA_CONFIG_H
 #define CAMERA_CONFIG_H
-#include <string>
+#include "pixel_format.h"
 
 struct CameraConfig {
     CameraConfig();
@@ -14,7 +14,9 @@ struct CameraConfig {
     int iso;
     unsigned int image_width;
     unsigned int image_height;
-    std::string encoding;
+    PixelFormat encoding;
 };
 
+void check_camera_config(const CameraConfig& config);
+
 #endif //CAMERA_CONFIG_H
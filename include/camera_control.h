@@ -4,27 +4,78 @@
 #ifndef CAMERA_CONTROL_H
 #define CAMERA_CONTROL_H
 
-#include "raspicam/raspicam_still.h"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "camera_backend.h"
 #include "camera_config.h"
 #include "image.h"
 
+/**
+ * Frames from one burst. The frames are views into one contiguous
+ * buffer, frame_stride bytes apart, and each has its capture time in
+ * its frame info.
+ */
+struct FrameBurst {
+    std::shared_ptr<unsigned char> buffer;
+    size_t capacity = 0;
+    size_t frame_stride = 0;
+    std::vector<Image> frames;
+};
+
+/**
+ * Captures from one camera backend. Named profiles hold complete camera
+ * settings that are checked and sized once when added, so switching
+ * between them only sends the camera the settings that differ and only
+ * reopens it when the resolution or encoding changes.
+ */
 class CameraController {
 
 public:
     CameraController();
+    explicit CameraController(std::unique_ptr<CameraBackend> backend);
     void open_camera();
     Image capture_image();
+    bool capture_image(Image& image);
+    bool capture_image(unsigned char* buffer, size_t buffer_size);
+    FrameBurst capture_burst(size_t count, bool lock_exposure = true);
+    bool capture_burst(size_t count, FrameBurst& burst, bool lock_exposure = true);
     void release_camera();
     void set_image_width(unsigned int new_width);
     void set_image_height(unsigned int new_height);
     void set_image_encoding(const std::string& new_encoding);
+    void set_image_encoding(PixelFormat new_encoding);
     [[nodiscard]] unsigned int get_image_width() const;
     [[nodiscard]] unsigned int get_image_height() const;
     [[nodiscard]] std::string get_image_encoding() const;
+    [[nodiscard]] PixelFormat get_image_format() const;
+    [[nodiscard]] size_t get_image_buffer_size() const;
+    [[nodiscard]] const CameraConfig& get_config() const;
+    [[nodiscard]] bool get_is_open() const;
+    void add_profile(const std::string& name, const CameraConfig& profile_config, size_t prewarm_count = 2);
+    void remove_profile(const std::string& name);
+    bool use_profile(const std::string& name);
+    [[nodiscard]] bool has_profile(const std::string& name) const;
+    [[nodiscard]] std::vector<std::string> get_profile_names() const;
+    [[nodiscard]] size_t get_profile_buffer_size(const std::string& name) const;
+    [[nodiscard]] std::string get_profile_name() const;
 
 private:
+    struct Profile {
+        CameraConfig config;
+        size_t buffer_size;
+    };
     CameraConfig config;
-    raspicam::RaspiCam_Still camera;
+    std::unique_ptr<CameraBackend> camera;
+    std::map<std::string, Profile> profiles;
+    std::string profile_name;
+    bool is_open;
+    int64_t first_frame_start_ns;
+    bool apply_config(const CameraConfig& new_config, bool apply_all);
+    bool reopen();
+    bool grab_frame(unsigned char* data, size_t size);
 };
 
 #endif //CAMERA_CONTROL_H
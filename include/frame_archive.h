@@ -0,0 +1,90 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef FRAME_ARCHIVE_H
+#define FRAME_ARCHIVE_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "image.h"
+
+/**
+ * Append-only file holding a whole capture session. Layout:
+ *   header (64 bytes) | index (capacity * 64 bytes) | frames
+ * Each frame starts on a 4096 byte boundary so views over a mapping
+ * of the file are page aligned. The header frame count is updated
+ * after the frame and its index entry are written, so a reader never
+ * sees a half written frame.
+ */
+struct FrameArchiveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t capacity;
+    uint64_t frame_count;
+    uint64_t index_offset;
+    uint64_t data_offset;
+    uint64_t data_end;
+    uint8_t reserved[16];
+};
+
+struct FrameArchiveEntry {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+    uint8_t format;
+    uint8_t has_header;
+    uint8_t has_motor_position;
+    uint8_t reserved[5];
+    uint64_t sequence;
+    int64_t timestamp_ns;
+    int64_t motor_position;
+    uint8_t padding[8];
+};
+
+static_assert(sizeof(FrameArchiveHeader) == 64, "Archive header layout changed.");
+static_assert(sizeof(FrameArchiveEntry) == 64, "Archive index entry layout changed.");
+
+class FrameArchiveWriter {
+
+public:
+    FrameArchiveWriter(const std::string& file_path, uint32_t capacity);
+    ~FrameArchiveWriter();
+    FrameArchiveWriter(const FrameArchiveWriter&) = delete;
+    FrameArchiveWriter& operator=(const FrameArchiveWriter&) = delete;
+    bool append(const Image& frame);
+    void close();
+    [[nodiscard]] uint64_t get_frame_count() const;
+    [[nodiscard]] uint32_t get_capacity() const;
+
+private:
+    mutable std::mutex mutex;
+    int fd;
+    FrameArchiveHeader header;
+};
+
+/**
+ * Read only view of an archive. The whole file is mapped once and
+ * frames come back as images pointing into the mapping, without copying.
+ * The mapping is private, so changing a frame never changes the file,
+ * and it stays alive while any frame image is alive.
+ */
+class FrameArchiveReader {
+
+public:
+    explicit FrameArchiveReader(const std::string& file_path);
+    [[nodiscard]] uint64_t get_frame_count() const;
+    [[nodiscard]] const FrameArchiveEntry& get_entry(uint64_t index) const;
+    [[nodiscard]] Image get_frame(uint64_t index) const;
+
+private:
+    struct Mapping;
+    std::shared_ptr<Mapping> mapping;
+    const FrameArchiveHeader* header;
+    const FrameArchiveEntry* index;
+    uint64_t frame_count;
+};
+
+#endif //FRAME_ARCHIVE_H
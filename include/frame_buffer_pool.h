@@ -0,0 +1,64 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef FRAME_BUFFER_POOL_H
+#define FRAME_BUFFER_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct FrameBufferPoolStats {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long releases;
+    unsigned long frees;
+    size_t bytes_allocated;
+    size_t bytes_pooled;
+};
+
+/**
+ * Process wide pool of image buffers. Buffers are grouped in slabs by
+ * byte size, which is fixed by the resolution and encoding, so frames
+ * from the same camera settings recycle the same memory. The free
+ * buffers of all sizes together are kept under a byte cap. When a
+ * release goes over it, the least recently used slabs are freed first,
+ * so sizes from old settings do not pile up.
+ */
+class FrameBufferPool {
+
+public:
+    static FrameBufferPool& instance();
+    FrameBufferPool(const FrameBufferPool&) = delete;
+    FrameBufferPool& operator=(const FrameBufferPool&) = delete;
+    std::shared_ptr<unsigned char> acquire(size_t size);
+    void reserve(size_t size, size_t count);
+    void clear();
+    void set_max_free_per_size(size_t new_max_free);
+    [[nodiscard]] size_t get_max_free_per_size() const;
+    void set_max_free_bytes(size_t new_max_free_bytes);
+    [[nodiscard]] size_t get_max_free_bytes() const;
+    [[nodiscard]] FrameBufferPoolStats get_stats() const;
+    void reset_stats();
+
+private:
+    struct Slab {
+        std::vector<unsigned char*> buffers;
+        unsigned long last_used = 0;
+    };
+    FrameBufferPool();
+    void release(unsigned char* buffer, size_t size);
+    void evict_locked(size_t keep_size);
+    static unsigned char* allocate(size_t size);
+    static void deallocate(unsigned char* buffer);
+    mutable std::mutex mutex;
+    std::unordered_map<size_t, Slab> free_buffers;
+    size_t max_free_per_size;
+    size_t max_free_bytes;
+    unsigned long use_clock;
+    FrameBufferPoolStats stats;
+};
+
+#endif //FRAME_BUFFER_POOL_H
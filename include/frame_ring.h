@@ -0,0 +1,78 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "image.h"
+
+/**
+ * What to do with a new frame when the ring is full.
+ * drop_oldest overwrites the oldest unread frame, drop_newest
+ * discards the new frame.
+ */
+enum class DropPolicy {
+    drop_oldest,
+    drop_newest
+};
+
+/**
+ * Single producer, single consumer ring of preallocated frames. Neither
+ * side takes a lock. Each slot carries a version so the consumer can tell
+ * when the producer overwrote a frame while it was being copied out
+ * (drop_oldest only), in which case the frame counts as dropped. The
+ * consumer only copies plain data and bytes out of a buffer the slot
+ * owns for its whole life, never the producer's Image, so a copy torn
+ * by the producer is thrown away instead of touching freed memory.
+ */
+class FrameRing {
+
+public:
+    FrameRing(size_t slot_count, size_t frame_size, DropPolicy policy);
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+    Image* begin_write();
+    void commit_write();
+    void abort_write();
+    bool pop_next(Image& frame);
+    bool pop_latest(Image& frame);
+    [[nodiscard]] size_t get_slot_count() const;
+    [[nodiscard]] DropPolicy get_drop_policy() const;
+    [[nodiscard]] uint64_t get_written_count() const;
+    [[nodiscard]] uint64_t get_dropped_count() const;
+    [[nodiscard]] size_t get_available() const;
+
+private:
+    // Description of the frame in a slot, copied out with its bytes.
+    struct SlotInfo {
+        size_t size = 0;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        PixelFormat format = PixelFormat::none;
+        bool has_header = false;
+        FrameInfo frame_info;
+    };
+    struct Slot {
+        // Filled by the producer only, always over buffer.
+        Image frame;
+        std::shared_ptr<unsigned char> buffer;
+        SlotInfo info;
+        std::atomic<uint64_t> version{0};
+    };
+    void attach_buffer(Slot& slot) const;
+    bool read_slot(uint64_t position, Image& frame);
+    std::unique_ptr<Slot[]> slots;
+    size_t slot_count;
+    size_t frame_size;
+    DropPolicy policy;
+    // Next position the producer writes, owned by the producer.
+    alignas(64) std::atomic<uint64_t> head;
+    // Next position the consumer reads, owned by the consumer.
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<uint64_t> dropped;
+};
+
+#endif //FRAME_RING_H
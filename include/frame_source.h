@@ -0,0 +1,60 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include <chrono>
+#include <string>
+#include "image.h"
+
+class CameraController;
+
+/**
+ * Something that produces frames one at a time for streaming capture.
+ * read_frame() fills an image that was sized with get_frame_size() and
+ * is called from the capture thread only.
+ */
+class FrameSource {
+
+public:
+    virtual ~FrameSource() = default;
+    [[nodiscard]] virtual size_t get_frame_size() const = 0;
+    virtual bool read_frame(Image& frame) = 0;
+};
+
+/**
+ * Frames from a camera controller. The controller must stay alive and
+ * should not be used for single captures while streaming.
+ */
+class CameraFrameSource : public FrameSource {
+
+public:
+    explicit CameraFrameSource(CameraController& camera_controller);
+    [[nodiscard]] size_t get_frame_size() const override;
+    bool read_frame(Image& frame) override;
+
+private:
+    CameraController& camera_controller;
+};
+
+/**
+ * Synthetic rgb frames produced at a fixed interval, for running the
+ * streaming code without a camera.
+ */
+class SyntheticFrameSource : public FrameSource {
+
+public:
+    SyntheticFrameSource(unsigned int width, unsigned int height, unsigned int frame_interval_us);
+    [[nodiscard]] size_t get_frame_size() const override;
+    bool read_frame(Image& frame) override;
+
+private:
+    unsigned int width;
+    unsigned int height;
+    std::chrono::microseconds frame_interval;
+    std::chrono::steady_clock::time_point next_frame_time;
+    unsigned long frame_count;
+};
+
+#endif //FRAME_SOURCE_H
@@ -0,0 +1,49 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef GPIO_BACKEND_H
+#define GPIO_BACKEND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+enum class PinMode : uint8_t {
+    input,
+    output
+};
+
+/**
+ * Device level GPIO interface used by MotorController. Every backend
+ * takes wiringPi pin numbers, so the same MotorConfig works with all of
+ * them. write_outputs() sets several pins at once, in one call to the
+ * device where the backend allows it. The simulated backend keeps pin
+ * levels in memory so motor code can run on any machine. The wiringPi
+ * backend is only built when wiringPi is found.
+ */
+class GpioBackend {
+
+public:
+    virtual ~GpioBackend() = default;
+    virtual bool setup() = 0;
+    virtual void set_mode(unsigned int pin, PinMode mode) = 0;
+    virtual void write(unsigned int pin, bool level) = 0;
+    virtual void write_outputs(const unsigned int* pins, size_t count, uint32_t levels);
+};
+
+/**
+ * wiringPi pin numbers 0-31 on the 40 pin header and their BCM
+ * numbers, for backends that talk to the SoC directly.
+ */
+inline constexpr unsigned int wiringpi_to_bcm_table[] = {
+    17, 18, 27, 22, 23, 24, 25, 4, 2, 3, 8, 7, 10, 9, 11, 14,
+    15, 28, 29, 30, 31, 5, 6, 13, 19, 26, 12, 16, 20, 21, 0, 1
+};
+
+bool is_wiringpi_pin(unsigned int pin);
+unsigned int wiringpi_to_bcm(unsigned int pin);
+std::unique_ptr<GpioBackend> make_gpio_backend(const std::string& name);
+std::string get_default_gpio_backend_name();
+
+#endif //GPIO_BACKEND_H
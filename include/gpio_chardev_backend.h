@@ -0,0 +1,43 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef GPIO_CHARDEV_BACKEND_H
+#define GPIO_CHARDEV_BACKEND_H
+
+#include <array>
+#include <string>
+#include <vector>
+#include "gpio_backend.h"
+
+/**
+ * GPIO through the Linux GPIO character device (uAPI v2). All output
+ * pins share one line request, so write_outputs() sets any of them
+ * with a single ioctl. Pin modes should not change while the motion
+ * thread is writing.
+ */
+class GpioChardevBackend : public GpioBackend {
+
+public:
+    explicit GpioChardevBackend(std::string chip_path = "/dev/gpiochip0");
+    ~GpioChardevBackend() override;
+    GpioChardevBackend(const GpioChardevBackend&) = delete;
+    GpioChardevBackend& operator=(const GpioChardevBackend&) = delete;
+    bool setup() override;
+    void set_mode(unsigned int pin, PinMode mode) override;
+    void write(unsigned int pin, bool level) override;
+    void write_outputs(const unsigned int* pins, size_t count, uint32_t levels) override;
+
+private:
+    static constexpr unsigned int max_lines = 64;
+    bool request_outputs();
+    bool request_input(unsigned int line);
+    void set_values(uint64_t bits, uint64_t mask);
+    std::string chip_path;
+    int chip_fd;
+    int request_fd;
+    std::vector<unsigned int> output_lines;
+    std::array<int, max_lines> line_index;
+    bool write_error_reported;
+};
+
+#endif //GPIO_CHARDEV_BACKEND_H
@@ -0,0 +1,33 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef GPIOMEM_BACKEND_H
+#define GPIOMEM_BACKEND_H
+
+#include <string>
+#include "gpio_backend.h"
+
+/**
+ * GPIO by writing the SoC registers through /dev/gpiomem, which needs
+ * no root. write_outputs() is one store to GPSET0 and one to GPCLR0
+ * for any number of pins. Only for BCM2835-BCM2711 based Pis, the Pi 5
+ * has a different GPIO block.
+ */
+class GpioMemBackend : public GpioBackend {
+
+public:
+    explicit GpioMemBackend(std::string device_path = "/dev/gpiomem");
+    ~GpioMemBackend() override;
+    GpioMemBackend(const GpioMemBackend&) = delete;
+    GpioMemBackend& operator=(const GpioMemBackend&) = delete;
+    bool setup() override;
+    void set_mode(unsigned int pin, PinMode mode) override;
+    void write(unsigned int pin, bool level) override;
+    void write_outputs(const unsigned int* pins, size_t count, uint32_t levels) override;
+
+private:
+    std::string device_path;
+    volatile uint32_t* registers;
+};
+
+#endif //GPIOMEM_BACKEND_H
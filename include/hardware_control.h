@@ -4,16 +4,39 @@
 #ifndef HARDWARE_CONTROL_H
 #define HARDWARE_CONTROL_H
 
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "camera_backend.h"
 #include "camera_control.h"
+#include "gpio_backend.h"
 #include "motor_control.h"
 
+/**
+ * Settings for scan(). After each move the motor rests for settle_ms
+ * before the capture. Frames are converted to output_format unless it
+ * is none, and saved into output_dir as scan_<index>.<format> when it
+ * is not empty. With qoi, rgb frames are passed on raw and encoded on
+ * the writer thread.
+ */
+struct ScanConfig {
+    unsigned int settle_ms = 100;
+    PixelFormat output_format = PixelFormat::none;
+    std::string output_dir;
+};
+
 class HardwareController {
 
 public:
     HardwareController();
     ~HardwareController();
     void initialize_all();
+    void initialize_all(std::unique_ptr<CameraBackend> camera_backend, std::unique_ptr<GpioBackend> gpio_backend);
     void cleanup_all();
+    std::vector<Image> scan(const std::vector<double>& angles, const ScanConfig& scan_config = ScanConfig());
+    void scan(const std::vector<double>& angles, const ScanConfig& scan_config,
+              const std::function<void(Image&)>& on_frame);
     CameraController* camera_controller;
     MotorController* motor_controller;
 
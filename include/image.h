@@ -6,38 +6,98 @@
 
 #include <iostream>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "pixel_format.h"
+
+/**
+ * Where a frame came from. The sequence number counts frames from
+ * one source and the timestamp is steady clock time in nanoseconds.
+ * The motor position is in steps and only valid when has_motor_position.
+ */
+struct FrameInfo {
+    uint64_t sequence = 0;
+    int64_t timestamp_ns = 0;
+    int64_t motor_position = 0;
+    bool has_motor_position = false;
+};
+
+/**
+ * How Image::resize() computes each new pixel. box averages whole
+ * blocks and needs an exact integer factor, bilinear blends the four
+ * nearest pixels, and area averages everything a new pixel covers.
+ */
+enum class ResizeFilter : uint8_t {
+    box,
+    bilinear,
+    area
+};
 
 class Image {
 
 public:
     Image();
+    explicit Image(size_t size, unsigned int width, unsigned int height, PixelFormat format, bool has_header);
     explicit Image(size_t size, unsigned int width, unsigned int height, const std::string &encoding, bool has_header);
+    Image(const unsigned char* src_data, size_t size, unsigned int width, unsigned int height,
+          PixelFormat format, bool has_header);
     Image(const unsigned char* src_data, size_t size, unsigned int width, unsigned int height,
           const std::string &encoding, bool has_header);
+    Image(std::shared_ptr<unsigned char> shared_data, size_t size, unsigned int width, unsigned int height,
+          PixelFormat format, bool has_header);
     ~Image();
     Image(const Image& other);
     Image& operator=(const Image& other);
     Image(Image&& other) noexcept;
     Image& operator=(Image&& other) noexcept;
+    [[nodiscard]] Image clone() const;
     [[nodiscard]] unsigned char* get_data() const;
     [[nodiscard]] size_t get_size() const;
     [[nodiscard]] unsigned int get_width() const;
     [[nodiscard]] unsigned int get_height() const;
     [[nodiscard]] std::string get_encoding() const;
+    [[nodiscard]] PixelFormat get_format() const;
     [[nodiscard]] bool get_has_header() const;
+    [[nodiscard]] size_t get_capacity() const;
+    [[nodiscard]] bool is_shared() const;
+    [[nodiscard]] size_t get_stride() const;
+    [[nodiscard]] bool is_contiguous() const;
+    [[nodiscard]] const FrameInfo& get_frame_info() const;
+    void set_frame_info(const FrameInfo& new_info);
+    void reset(size_t new_size, unsigned int new_width, unsigned int new_height, PixelFormat new_format,
+               bool new_has_header);
+    void copy_from(const Image& other);
     [[nodiscard]] bool save(const std::string& file_path) const;
+    [[nodiscard]] bool check_save_extension(const std::string& file_path) const;
     void remove_rgb_header();
-    void flip_rgb_h() const;
-    void flip_rgb_v() const;
+    void flip_rgb_h(unsigned int max_threads = 0);
+    void flip_rgb_v(unsigned int max_threads = 0);
+    void rotate_rgb_90();
+    void rotate_rgb_180();
+    void rotate_rgb_270();
+    void transpose_rgb();
+    bool convert_to(PixelFormat new_format, unsigned int max_threads = 0);
+    [[nodiscard]] Image crop(unsigned int x, unsigned int y, unsigned int crop_width, unsigned int crop_height) const;
+    [[nodiscard]] Image resize(unsigned int new_width, unsigned int new_height,
+                               ResizeFilter filter = ResizeFilter::area, unsigned int max_threads = 0) const;
+    [[nodiscard]] Image downscale(unsigned int factor, unsigned int max_threads = 0) const;
 
 private:
-    unsigned char* data;
+    std::shared_ptr<unsigned char> data;
     size_t size;
+    size_t capacity;
     unsigned int width;
     unsigned int height;
-    std::string encoding;
-    [[nodiscard]] bool check_save_extension(const std::string& file_path) const;
+    // Distance between rows in bytes for crop views, 0 when rows are packed.
+    size_t stride;
+    PixelFormat format;
     bool has_header;
+    FrameInfo info;
+    void detach();
+    void compact();
+    [[nodiscard]] bool check_resize(const char* op_name) const;
+    [[nodiscard]] bool check_rgb_transform(const char* op_name, const char* verb) const;
+    void replace_data(std::shared_ptr<unsigned char> new_data, unsigned int new_width, unsigned int new_height);
 };
 
 #endif //IMAGE_DATA_H
@@ -0,0 +1,68 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef IMAGE_OPS_H
+#define IMAGE_OPS_H
+
+#include <cstddef>
+
+/**
+ * Pixel kernels behind the Image operations. The flip and rotate kernels
+ * work on packed 3 byte pixels (rgb), the resize kernels on packed pixels
+ * of any channel count. Rows are stride bytes apart. The plain versions
+ * use NEON or SSSE3 when the build enables them; the _scalar versions are
+ * the simple reference they are checked against.
+ */
+
+[[nodiscard]] const char* get_simd_backend_name();
+
+void copy_rows(const unsigned char* src, size_t src_stride, unsigned char* dst, size_t dst_stride, size_t row_size,
+               size_t height);
+
+void flip_rgb_h_kernel(unsigned char* data, size_t width, size_t height, size_t stride);
+void flip_rgb_h_scalar(unsigned char* data, size_t width, size_t height, size_t stride);
+
+void flip_rows_v_kernel(unsigned char* data, size_t row_size, size_t height, size_t stride);
+void flip_rows_v_scalar(unsigned char* data, size_t row_size, size_t height, size_t stride);
+void flip_rows_v_pairs_kernel(unsigned char* data, size_t row_size, size_t height, size_t stride, size_t first_pair,
+                              size_t last_pair);
+
+void rotate_rgb_180_kernel(unsigned char* data, size_t width, size_t height, size_t stride);
+void rotate_rgb_180_scalar(unsigned char* data, size_t width, size_t height, size_t stride);
+
+// Out of place, the destination is height pixels wide and width rows high.
+void rotate_rgb_90_kernel(const unsigned char* src, size_t width, size_t height, size_t src_stride,
+                          unsigned char* dst, size_t dst_stride);
+void rotate_rgb_90_scalar(const unsigned char* src, size_t width, size_t height, size_t src_stride,
+                          unsigned char* dst, size_t dst_stride);
+void rotate_rgb_270_kernel(const unsigned char* src, size_t width, size_t height, size_t src_stride,
+                           unsigned char* dst, size_t dst_stride);
+void rotate_rgb_270_scalar(const unsigned char* src, size_t width, size_t height, size_t src_stride,
+                           unsigned char* dst, size_t dst_stride);
+void transpose_rgb_kernel(const unsigned char* src, size_t width, size_t height, size_t src_stride,
+                          unsigned char* dst, size_t dst_stride);
+void transpose_rgb_scalar(const unsigned char* src, size_t width, size_t height, size_t src_stride,
+                          unsigned char* dst, size_t dst_stride);
+
+// Average factor x factor blocks. The destination is width / factor by height / factor.
+void downscale_box_kernel(const unsigned char* src, size_t width, size_t height, size_t src_stride, size_t channels,
+                          size_t factor, unsigned char* dst, size_t dst_stride);
+void downscale_box_scalar(const unsigned char* src, size_t width, size_t height, size_t src_stride, size_t channels,
+                          size_t factor, unsigned char* dst, size_t dst_stride);
+
+// Resize to any size. Area averages every source pixel a destination pixel covers.
+void resize_bilinear_kernel(const unsigned char* src, size_t width, size_t height, size_t src_stride,
+                            size_t channels, unsigned char* dst, size_t dst_width, size_t dst_height,
+                            size_t dst_stride);
+void resize_area_kernel(const unsigned char* src, size_t width, size_t height, size_t src_stride, size_t channels,
+                        unsigned char* dst, size_t dst_width, size_t dst_height, size_t dst_stride);
+
+// Only destination rows first_row up to last_row, for splitting one resize across threads.
+void resize_bilinear_rows_kernel(const unsigned char* src, size_t width, size_t height, size_t src_stride,
+                                 size_t channels, unsigned char* dst, size_t dst_width, size_t dst_height,
+                                 size_t dst_stride, size_t first_row, size_t last_row);
+void resize_area_rows_kernel(const unsigned char* src, size_t width, size_t height, size_t src_stride,
+                             size_t channels, unsigned char* dst, size_t dst_width, size_t dst_height,
+                             size_t dst_stride, size_t first_row, size_t last_row);
+
+#endif //IMAGE_OPS_H
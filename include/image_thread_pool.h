@@ -0,0 +1,64 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef IMAGE_THREAD_POOL_H
+#define IMAGE_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Process wide threads that split Image operations into bands of rows.
+ * The calling thread works on bands too, so with a thread count of 4
+ * three workers are started. Frames smaller than the minimum size run
+ * on the calling thread only, where waking workers would cost more
+ * than it saves. Only one operation uses the workers at a time; others
+ * run serially meanwhile.
+ */
+class ImageThreadPool {
+
+public:
+    static ImageThreadPool& instance();
+    ImageThreadPool(const ImageThreadPool&) = delete;
+    ImageThreadPool& operator=(const ImageThreadPool&) = delete;
+    ~ImageThreadPool();
+    void run(size_t rows, size_t bytes, unsigned int max_threads,
+             const std::function<void(size_t first_row, size_t last_row)>& band);
+    [[nodiscard]] unsigned int get_band_count(size_t rows, size_t bytes, unsigned int max_threads) const;
+    void set_thread_count(unsigned int count);
+    [[nodiscard]] unsigned int get_thread_count() const;
+    void set_min_parallel_bytes(size_t bytes);
+    [[nodiscard]] size_t get_min_parallel_bytes() const;
+
+private:
+    ImageThreadPool();
+    void start_workers(unsigned int count);
+    void stop_workers();
+    void worker_loop();
+    void run_bands();
+    std::atomic<unsigned int> thread_count;
+    std::atomic<size_t> min_parallel_bytes;
+    // Held by the operation using the workers.
+    std::mutex run_mutex;
+    // Guards the workers and the current operation below.
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    std::vector<std::thread> workers;
+    bool stopping;
+    unsigned long generation;
+    const std::function<void(size_t, size_t)>* current_band;
+    size_t band_rows;
+    size_t total_rows;
+    unsigned int band_count;
+    std::atomic<unsigned int> next_band;
+    std::atomic<unsigned int> finished_bands;
+    unsigned int active_workers;
+};
+
+#endif //IMAGE_THREAD_POOL_H
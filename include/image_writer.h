@@ -0,0 +1,86 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef IMAGE_WRITER_H
+#define IMAGE_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "image.h"
+
+/**
+ * When written files are flushed to the storage device.
+ * per_batch syncs each file system once after every batch a writer
+ * thread takes, and fails the batch's files on a file system that did
+ * not sync.
+ */
+enum class FsyncPolicy {
+    none,
+    per_file,
+    per_batch
+};
+
+struct ImageWriterConfig {
+    size_t thread_count = 1;
+    size_t queue_capacity = 16;
+    size_t max_batch = 8;
+    FsyncPolicy fsync_policy = FsyncPolicy::none;
+    bool direct_io = false;
+};
+
+/**
+ * Saves images on writer threads so a slow SD card does not stall the
+ * capture loop. Queued images share their buffer with the caller, so
+ * queuing does not copy pixels. When the queue is full, save_async()
+ * waits for room.
+ */
+class ImageWriter {
+
+public:
+    explicit ImageWriter(const ImageWriterConfig& config = ImageWriterConfig());
+    ~ImageWriter();
+    ImageWriter(const ImageWriter&) = delete;
+    ImageWriter& operator=(const ImageWriter&) = delete;
+    std::future<bool> save_async(const Image& image, const std::string& file_path);
+    void save_async(const Image& image, const std::string& file_path, std::function<void(bool)> callback);
+    bool try_save_async(const Image& image, const std::string& file_path, std::function<void(bool)> callback);
+    void flush();
+    [[nodiscard]] size_t get_queued_count() const;
+    [[nodiscard]] unsigned long get_saved_count() const;
+    [[nodiscard]] unsigned long get_failed_count() const;
+    [[nodiscard]] unsigned long long get_bytes_written() const;
+    [[nodiscard]] const ImageWriterConfig& get_config() const;
+
+private:
+    struct Job {
+        Image image;
+        std::string file_path;
+        std::promise<bool> promise;
+        std::function<void(bool)> callback;
+    };
+    void enqueue(Job job);
+    void writer_loop();
+    void write_batch(std::vector<Job>& batch);
+    bool write_file(const Job& job, int& fd, size_t& written) const;
+    ImageWriterConfig config;
+    mutable std::mutex mutex;
+    std::condition_variable job_ready;
+    std::condition_variable space_ready;
+    std::condition_variable idle;
+    std::deque<Job> queue;
+    size_t in_flight;
+    bool stopping;
+    std::vector<std::thread> threads;
+    std::atomic<unsigned long> saved;
+    std::atomic<unsigned long> failed;
+    std::atomic<unsigned long long> bytes_written;
+};
+
+#endif //IMAGE_WRITER_H
@@ -0,0 +1,86 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+enum class LogLevel : uint8_t {
+    debug,
+    info,
+    warn,
+    error,
+    off
+};
+
+/**
+ * Lowest level compiled in, 0 (debug) to 4 (off). Log lines below it
+ * are removed by the preprocessor, so per frame and per step debug
+ * lines cost nothing in builds that do not want them.
+ */
+#ifndef RASPI_HW_LOG_MIN_LEVEL
+#define RASPI_HW_LOG_MIN_LEVEL 0
+#endif
+
+/**
+ * Leveled logger. debug and info go to stdout, warn and error to
+ * stderr, one line per message. The level starts at info, or at
+ * RASPI_HW_LOG_LEVEL (debug, info, warn, error or off) when set.
+ */
+class Logger {
+
+public:
+    static Logger& instance();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+    void set_level(LogLevel new_level);
+    [[nodiscard]] LogLevel get_level() const;
+    [[nodiscard]] bool is_enabled(const LogLevel message_level) const {
+        return static_cast<uint8_t>(message_level) >= level.load(std::memory_order_relaxed);
+    }
+    void write(LogLevel message_level, const std::string& message);
+
+private:
+    Logger();
+    std::atomic<uint8_t> level;
+};
+
+LogLevel log_level_from_name(const std::string& name);
+const char* log_level_name(LogLevel level);
+
+// The message is only formatted when the level is enabled.
+#define RASPI_HW_LOG(level, message) \
+    do { \
+        if (Logger::instance().is_enabled(level)) { \
+            std::ostringstream raspi_hw_log_stream; \
+            raspi_hw_log_stream << message; \
+            Logger::instance().write(level, raspi_hw_log_stream.str()); \
+        } \
+    } while (0)
+
+#if RASPI_HW_LOG_MIN_LEVEL <= 0
+#define RASPI_HW_LOG_DEBUG(message) RASPI_HW_LOG(LogLevel::debug, message)
+#else
+#define RASPI_HW_LOG_DEBUG(message) do {} while (0)
+#endif
+#if RASPI_HW_LOG_MIN_LEVEL <= 1
+#define RASPI_HW_LOG_INFO(message) RASPI_HW_LOG(LogLevel::info, message)
+#else
+#define RASPI_HW_LOG_INFO(message) do {} while (0)
+#endif
+#if RASPI_HW_LOG_MIN_LEVEL <= 2
+#define RASPI_HW_LOG_WARN(message) RASPI_HW_LOG(LogLevel::warn, message)
+#else
+#define RASPI_HW_LOG_WARN(message) do {} while (0)
+#endif
+#if RASPI_HW_LOG_MIN_LEVEL <= 3
+#define RASPI_HW_LOG_ERROR(message) RASPI_HW_LOG(LogLevel::error, message)
+#else
+#define RASPI_HW_LOG_ERROR(message) do {} while (0)
+#endif
+
+#endif //LOGGER_H
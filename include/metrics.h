@@ -0,0 +1,116 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "realtime_thread.h"
+
+enum class MetricTimer : uint8_t {
+    capture,
+    camera_open,
+    camera_switch,
+    first_frame,
+    header_strip,
+    flip,
+    save,
+    encode,
+    step,
+    move,
+    step_lateness,
+    count
+};
+
+enum class MetricCounter : uint8_t {
+    frames_captured,
+    capture_failures,
+    frames_dropped,
+    allocated_bytes,
+    steps,
+    count
+};
+
+/**
+ * Latency histogram with power of two buckets. Bucket i counts samples
+ * from 2^i up to 2^(i+1) nanoseconds, bucket 0 also takes anything
+ * below 1 ns. Recording only touches relaxed atomics.
+ */
+class LatencyHistogram {
+
+public:
+    static constexpr size_t bucket_count = 40;
+    LatencyHistogram();
+    void record(int64_t latency_ns);
+    void reset();
+    [[nodiscard]] uint64_t get_count() const;
+    [[nodiscard]] int64_t get_sum_ns() const;
+    [[nodiscard]] int64_t get_min_ns() const;
+    [[nodiscard]] int64_t get_max_ns() const;
+    [[nodiscard]] uint64_t get_bucket(size_t bucket) const;
+
+private:
+    std::atomic<uint64_t> count;
+    std::atomic<int64_t> sum_ns;
+    std::atomic<int64_t> min_ns;
+    std::atomic<int64_t> max_ns;
+    std::atomic<uint64_t> buckets[bucket_count];
+};
+
+/**
+ * Copy of one histogram. Percentiles are the upper edge of the bucket
+ * they fall in, so they are within a factor of two.
+ */
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    int64_t sum_ns = 0;
+    int64_t min_ns = 0;
+    int64_t max_ns = 0;
+    double mean_ns = 0;
+    int64_t p50_ns = 0;
+    int64_t p90_ns = 0;
+    int64_t p99_ns = 0;
+    std::vector<uint64_t> buckets;
+};
+
+struct MetricsSnapshot {
+    std::map<std::string, HistogramSnapshot> timers;
+    std::map<std::string, uint64_t> counters;
+};
+
+void record_latency(MetricTimer timer, int64_t latency_ns);
+void add_to_counter(MetricCounter counter, uint64_t amount = 1);
+MetricsSnapshot get_metrics_snapshot();
+void reset_metrics();
+void set_metrics_enabled(bool enabled);
+bool get_metrics_enabled();
+const char* metric_timer_name(MetricTimer timer);
+const char* metric_counter_name(MetricCounter counter);
+
+/**
+ * Records the time from construction to destruction. Reads the clock
+ * only when metrics are enabled.
+ */
+class ScopedLatency {
+
+public:
+    explicit ScopedLatency(const MetricTimer timer)
+        : timer(timer), start_ns(get_metrics_enabled() ? monotonic_now_ns() : 0) {}
+    ~ScopedLatency() {
+        if (start_ns != 0) {
+            record_latency(timer, monotonic_now_ns() - start_ns);
+        }
+    }
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    MetricTimer timer;
+    int64_t start_ns;
+};
+
+#endif //METRICS_H
@@ -0,0 +1,119 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef MOTION_ENGINE_H
+#define MOTION_ENGINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using StepFunction = std::function<void(int direction, uint64_t step_index)>;
+
+/**
+ * A run of steps in one direction. Steps are step_interval_us apart,
+ * unless step_delays_us is given with one delay per step, as made by
+ * build_step_delays. Each step moves the position by position_increment.
+ * on_step, if set, is called for each step instead of the engine's step
+ * function, so a command can carry its own state.
+ */
+struct StepCommand {
+    uint32_t steps = 0;
+    int direction = 1;
+    uint32_t step_interval_us = 2000;
+    std::vector<uint32_t> step_delays_us;
+    uint32_t position_increment = 1;
+    StepFunction on_step;
+};
+
+/**
+ * How the motion thread is scheduled. cpu_core -1 means the last core,
+ * which is the one least used by everything else on a Pi.
+ */
+struct MotionEngineConfig {
+    bool pin_thread = true;
+    int cpu_core = -1;
+    bool realtime = true;
+    int realtime_priority = 80;
+};
+
+/**
+ * How late steps fired compared to their deadlines. A step is an
+ * overrun if it fired more than half its delay late.
+ */
+struct JitterStats {
+    uint64_t sample_count = 0;
+    int64_t min_ns = 0;
+    int64_t max_ns = 0;
+    double mean_ns = 0;
+    uint64_t overrun_count = 0;
+};
+
+/**
+ * Runs queued step commands on a dedicated thread. Each step has an
+ * absolute deadline on the monotonic clock, so a late wake up does not
+ * push back the steps after it. The thread is pinned to a core and runs
+ * SCHED_FIFO when the process is allowed to, and falls back to normal
+ * scheduling otherwise. Step functions run on the motion thread.
+ * The position counts every step taken, forward for direction 1 and
+ * backward otherwise, so it stays right when a move is stopped.
+ * A step function that throws ends its command, and the exception is
+ * logged and handed to the command's future.
+ */
+class MotionEngine {
+
+public:
+    explicit MotionEngine(StepFunction step, const MotionEngineConfig& config = MotionEngineConfig());
+    ~MotionEngine();
+    MotionEngine(const MotionEngine&) = delete;
+    MotionEngine& operator=(const MotionEngine&) = delete;
+    std::future<bool> queue(StepCommand command);
+    void stop();
+    void wait_idle();
+    [[nodiscard]] bool is_idle() const;
+    [[nodiscard]] int64_t get_position() const;
+    void set_position(int64_t new_position);
+    [[nodiscard]] bool get_is_pinned() const;
+    [[nodiscard]] bool get_is_realtime() const;
+    [[nodiscard]] uint64_t get_step_count() const;
+    [[nodiscard]] uint64_t get_error_count() const;
+    [[nodiscard]] JitterStats get_jitter_stats() const;
+    void reset_jitter_stats();
+
+private:
+    struct Job {
+        StepCommand command;
+        std::promise<bool> promise;
+    };
+    void motion_loop();
+    bool run_command(const StepCommand& command);
+    void record_lateness(int64_t lateness_ns, int64_t delay_ns);
+    StepFunction step;
+    MotionEngineConfig config;
+    mutable std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable idle;
+    std::deque<Job> jobs;
+    bool busy;
+    bool stopping;
+    std::atomic<bool> stop_requested;
+    std::atomic<bool> cancel_requested;
+    std::atomic<int64_t> position;
+    std::atomic<bool> is_pinned;
+    std::atomic<bool> is_realtime;
+    std::atomic<uint64_t> step_count;
+    std::atomic<uint64_t> error_count;
+    int64_t next_deadline_ns;
+    mutable std::mutex stats_mutex;
+    JitterStats stats;
+    int64_t lateness_sum_ns;
+    std::thread motion_thread;
+};
+
+#endif //MOTION_ENGINE_H
@@ -0,0 +1,35 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include <cstdint>
+#include <vector>
+
+enum class ProfileShape : uint8_t {
+    constant,
+    trapezoidal,
+    s_curve
+};
+
+/**
+ * Speed limits for a move, in steps per second. constant runs every
+ * step at start_velocity, with no ramp. trapezoidal ramps from
+ * start_velocity up to max_velocity at max_acceleration. s_curve also limits how fast the acceleration
+ * changes with max_jerk, which is gentler on the gear train. The
+ * motor must be able to start at start_velocity without ramping.
+ */
+struct MotionProfileConfig {
+    ProfileShape shape = ProfileShape::constant;
+    double start_velocity = 300;
+    double max_velocity = 500;
+    double max_acceleration = 2000;
+    double max_jerk = 20000;
+};
+
+std::vector<uint32_t> build_step_delays(uint32_t steps, const MotionProfileConfig& config);
+uint32_t get_step_interval_us(const MotionProfileConfig& config);
+uint64_t get_move_time_us(const std::vector<uint32_t>& step_delays_us);
+
+#endif //MOTION_PROFILE_H
@@ -5,13 +5,18 @@
 #define MOTOR_CONFIG_H
 
 #include <array>
+#include <string>
+#include "motion_profile.h"
+#include "step_table.h"
 
 struct MotorConfig {
     MotorConfig();
     unsigned int steps_per_rev;
     unsigned int step_delay_ms;
+    MotionProfileConfig profile;
     std::array<unsigned int, 4> w_pi_pins;
-    std::array<std::array<unsigned int, 4>, 8> step_sequence;
+    DriveMode drive_mode;
+    std::string position_file;
 };
 
 #endif //MOTOR_CONFIG_H
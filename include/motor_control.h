@@ -4,21 +4,65 @@
 #ifndef MOTOR_CONTROL_H
 #define MOTOR_CONTROL_H
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "gpio_backend.h"
+#include "motion_engine.h"
 #include "motor_config.h"
+#include "step_table.h"
 
 class MotorController {
 
 public:
     MotorController();
+    explicit MotorController(std::unique_ptr<GpioBackend> backend,
+                             const MotionEngineConfig& engine_config = MotionEngineConfig());
     void set_to_output_mode() const;
     void cleanup() const;
-    void rotate(unsigned int degrees, int direction) const;
+    void rotate(unsigned int degrees, int direction);
+    std::future<bool> rotate_async(unsigned int degrees, int direction);
+    void move_by(double degrees);
+    std::future<bool> move_by_async(double degrees);
+    void move_to(double angle);
+    std::future<bool> move_to_async(double angle);
+    bool home(const std::function<bool()>& at_home, unsigned int max_degrees = 360, int direction = -1);
+    void set_home();
+    void stop();
+    void wait() const;
+    [[nodiscard]] bool is_moving() const;
+    [[nodiscard]] int64_t get_position() const;
+    [[nodiscard]] double get_angle() const;
+    void set_position_file(const std::string& file_path);
+    [[nodiscard]] bool save_position(const std::string& file_path) const;
+    bool load_position(const std::string& file_path);
     void set_pins(unsigned int pin1, unsigned int pin2, unsigned int pin3, unsigned int pin4);
+    void set_drive_mode(DriveMode mode);
+    [[nodiscard]] DriveMode get_drive_mode() const;
+    void set_motion_profile(const MotionProfileConfig& profile);
+    [[nodiscard]] MotionProfileConfig get_motion_profile() const;
+    [[nodiscard]] JitterStats get_jitter_stats() const;
+    void reset_jitter_stats() const;
+    [[nodiscard]] bool get_is_realtime() const;
 
 private:
     MotorConfig config;
-    void clockwise_step(unsigned int semi_step) const;
-    void counter_clockwise_step(unsigned int semi_step) const;
+    std::unique_ptr<GpioBackend> gpio;
+    StepSequence sequence;
+    std::atomic<uint32_t> phase;
+    mutable std::mutex plan_mutex;
+    double target_position;
+    int64_t planned_position;
+    uint32_t planned_phase;
+    std::unique_ptr<MotionEngine> engine;
+    std::future<bool> move_by_locked(double degrees);
+    void align_phase_locked(int direction);
+    std::future<bool> queue_steps(const StepSequence& step_sequence, int64_t half_steps);
+    void step(int direction, const StepSequence& step_sequence, const std::array<unsigned int, 4>& pins);
 };
 
 #endif //MOTOR_CONTROL_H
@@ -0,0 +1,75 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef MULTI_AXIS_CONTROL_H
+#define MULTI_AXIS_CONTROL_H
+
+#include <array>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+#include "gpio_backend.h"
+#include "motion_engine.h"
+#include "motion_profile.h"
+#include "step_table.h"
+
+/**
+ * One stepper of a multi-axis rig. steps_per_rev counts half steps,
+ * like MotorConfig.
+ */
+struct AxisConfig {
+    std::array<unsigned int, 4> w_pi_pins{25, 24, 23, 22};
+    unsigned int steps_per_rev = 4096;
+    DriveMode drive_mode = DriveMode::half_step;
+};
+
+/**
+ * Drives several steppers from one motion thread so they start and
+ * finish together. The axis with the most steps in a move sets the
+ * timing, following the motion profile, and the other axes step on the
+ * same ticks spread out Bresenham style, each taking its last step on
+ * the final tick. All pins that change on a tick are set in one GPIO
+ * write. Each axis keeps its coil phase between moves. Add every axis
+ * before the first move.
+ */
+class MultiAxisController {
+
+public:
+    static constexpr size_t max_axes = 8;
+    explicit MultiAxisController(std::unique_ptr<GpioBackend> backend,
+                                 const MotionEngineConfig& engine_config = MotionEngineConfig());
+    size_t add_axis(const AxisConfig& axis_config);
+    [[nodiscard]] size_t get_axis_count() const;
+    void set_to_output_mode() const;
+    void cleanup() const;
+    void move_linear(const std::vector<double>& degrees) const;
+    std::future<bool> move_linear_async(const std::vector<double>& degrees) const;
+    void stop() const;
+    void wait() const;
+    [[nodiscard]] bool is_moving() const;
+    [[nodiscard]] int64_t get_position(size_t axis) const;
+    [[nodiscard]] std::vector<int64_t> get_positions() const;
+    void set_motion_profile(const MotionProfileConfig& new_profile);
+    [[nodiscard]] const MotionProfileConfig& get_motion_profile() const;
+
+private:
+    struct Axis {
+        AxisConfig config;
+        StepSequence sequence;
+        uint32_t phase = 0;
+        std::atomic<int64_t> position{0};
+    };
+    struct LinearMove {
+        std::array<int64_t, max_axes> steps{};
+        std::array<uint64_t, max_axes> error{};
+        uint64_t major_steps = 0;
+    };
+    void tick(LinearMove& move) const;
+    std::unique_ptr<GpioBackend> gpio;
+    MotionProfileConfig profile;
+    std::vector<std::unique_ptr<Axis>> axes;
+    std::unique_ptr<MotionEngine> engine;
+};
+
+#endif //MULTI_AXIS_CONTROL_H
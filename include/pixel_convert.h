@@ -0,0 +1,31 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef PIXEL_CONVERT_H
+#define PIXEL_CONVERT_H
+
+#include <cstddef>
+#include "pixel_format.h"
+
+/**
+ * Convert raw pixels between rgb, bgr, rgba, gray and yuv420. Conversions
+ * to a format no larger than the source can run in place (src == dst);
+ * otherwise src and dst must not overlap. Frames are packed without
+ * row padding.
+ *
+ * @return true if the conversion is supported, else false.
+ */
+bool convert_pixels(const unsigned char* src, PixelFormat src_format, unsigned char* dst, PixelFormat dst_format,
+                    size_t width, size_t height);
+
+/**
+ * Same as convert_pixels() without the NEON or SSSE3 kernels. The
+ * reference the vector kernels are checked against.
+ */
+bool convert_pixels_scalar(const unsigned char* src, PixelFormat src_format, unsigned char* dst,
+                           PixelFormat dst_format, size_t width, size_t height);
+
+[[nodiscard]] bool can_convert_in_place(PixelFormat src_format, PixelFormat dst_format, size_t width,
+                                        size_t height);
+
+#endif //PIXEL_CONVERT_H
@@ -0,0 +1,87 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef PIXEL_FORMAT_H
+#define PIXEL_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Image encodings. png and jpeg are compressed files from the camera,
+ * qoi is a lossless file made from rgb or rgba by encode_qoi(), the
+ * rest are raw pixel layouts. yuv420 is planar I420: a full size Y
+ * plane followed by U and V planes at half width and half height.
+ * none is an image without data.
+ */
+enum class PixelFormat : uint8_t {
+    none,
+    png,
+    jpeg,
+    rgb,
+    bgr,
+    rgba,
+    gray,
+    yuv420,
+    qoi
+};
+
+/**
+ * Fixed facts about a pixel format. bytes_per_pixel is for the packed
+ * (or luma) plane and 0 for compressed formats. header_size is the
+ * trailing header raspicam adds to captures. Rows are width *
+ * bytes_per_pixel bytes with no padding.
+ */
+struct PixelFormatInfo {
+    const char* name;
+    uint8_t bytes_per_pixel;
+    uint8_t planes;
+    uint8_t header_size;
+    bool is_raw;
+    bool camera_output;
+};
+
+inline constexpr PixelFormatInfo pixel_format_table[] = {
+    {"", 0, 0, 0, false, false},
+    {"png", 0, 0, 0, false, true},
+    {"jpeg", 0, 0, 0, false, true},
+    {"rgb", 3, 1, 54, true, true},
+    {"bgr", 3, 1, 0, true, false},
+    {"rgba", 4, 1, 0, true, false},
+    {"gray", 1, 1, 0, true, false},
+    {"yuv420", 1, 3, 0, true, false},
+    {"qoi", 0, 0, 0, false, false},
+};
+
+constexpr const PixelFormatInfo& pixel_format_info(const PixelFormat format) {
+    return pixel_format_table[static_cast<size_t>(format)];
+}
+
+constexpr const char* pixel_format_name(const PixelFormat format) {
+    return pixel_format_info(format).name;
+}
+
+constexpr bool pixel_format_is_raw(const PixelFormat format) {
+    return pixel_format_info(format).is_raw;
+}
+
+constexpr size_t pixel_format_row_size(const PixelFormat format, const size_t width) {
+    return width * pixel_format_info(format).bytes_per_pixel;
+}
+
+/**
+ * Get the size of a raw frame without header, or 0 for compressed formats.
+ */
+constexpr size_t pixel_format_frame_size(const PixelFormat format, const size_t width, const size_t height) {
+    const size_t plane_size = pixel_format_row_size(format, width) * height;
+    if (format == PixelFormat::yuv420) {
+        return plane_size + 2 * ((width + 1) / 2) * ((height + 1) / 2);
+    }
+    return plane_size;
+}
+
+[[nodiscard]] bool pixel_format_from_name(const std::string& name, PixelFormat& format);
+[[nodiscard]] PixelFormat pixel_format_from_name(const std::string& name);
+
+#endif //PIXEL_FORMAT_H
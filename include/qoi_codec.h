@@ -0,0 +1,48 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef QOI_CODEC_H
+#define QOI_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "image.h"
+
+/**
+ * Lossless QOI (https://qoiformat.org) encoding of rgb and rgba frames.
+ * It runs in one pass over the pixels with no entropy coder, so it is
+ * fast enough to keep up with the camera, and files open in common
+ * viewers. The encoder takes rows in chunks so a file can be written
+ * while it is encoded without holding the whole output in memory.
+ */
+class QoiEncoder {
+
+public:
+    static constexpr size_t header_size = 14;
+    static constexpr size_t end_size = 8;
+    QoiEncoder(unsigned int width, unsigned int height, unsigned int channels);
+    size_t write_header(unsigned char* out) const;
+    size_t encode_rows(const unsigned char* rows, size_t row_count, size_t stride, unsigned char* out);
+    size_t finish(unsigned char* out);
+    [[nodiscard]] size_t get_max_encoded_size(size_t row_count) const;
+
+private:
+    unsigned int width;
+    unsigned int height;
+    unsigned int channels;
+    uint32_t index[64];
+    uint32_t previous;
+    unsigned int run;
+};
+
+[[nodiscard]] bool can_encode_qoi(const Image& image);
+[[nodiscard]] bool has_qoi_extension(const std::string& file_path);
+bool encode_qoi(const Image& image, const std::function<bool(const unsigned char* data, size_t size)>& sink);
+[[nodiscard]] Image encode_qoi(const Image& image);
+[[nodiscard]] Image decode_qoi(const unsigned char* data, size_t size);
+[[nodiscard]] Image decode_qoi(const Image& encoded);
+[[nodiscard]] Image load_qoi(const std::string& file_path);
+
+#endif //QOI_CODEC_H
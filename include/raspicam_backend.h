@@ -0,0 +1,34 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef RASPICAM_BACKEND_H
+#define RASPICAM_BACKEND_H
+
+#include "raspicam/raspicam_still.h"
+#include "camera_backend.h"
+
+class RaspiCamBackend : public CameraBackend {
+
+public:
+    bool open() override;
+    void release() override;
+    void set_width(unsigned int width) override;
+    void set_height(unsigned int height) override;
+    void set_encoding(PixelFormat encoding) override;
+    void set_sharpness(int sharpness) override;
+    void set_contrast(int contrast) override;
+    void set_brightness(unsigned int brightness) override;
+    void set_saturation(int saturation) override;
+    void set_iso(int iso) override;
+    void set_exposure_auto() override;
+    void set_exposure_locked(bool locked) override;
+    [[nodiscard]] size_t get_image_buffer_size() const override;
+    [[nodiscard]] size_t get_image_buffer_size(unsigned int width, unsigned int height,
+                                               PixelFormat encoding) const override;
+    bool grab_retrieve(unsigned char* data, size_t size) override;
+
+private:
+    raspicam::RaspiCam_Still camera;
+};
+
+#endif //RASPICAM_BACKEND_H
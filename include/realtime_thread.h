@@ -0,0 +1,19 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef REALTIME_THREAD_H
+#define REALTIME_THREAD_H
+
+#include <cstdint>
+
+/**
+ * Helpers for threads with hard timing needs. All of them act on the
+ * calling thread and report failure instead of throwing, since
+ * realtime scheduling usually needs root or CAP_SYS_NICE.
+ */
+bool pin_current_thread(int core);
+bool set_current_thread_fifo(int priority);
+int64_t monotonic_now_ns();
+void sleep_until_ns(int64_t deadline_ns);
+
+#endif //REALTIME_THREAD_H
@@ -0,0 +1,17 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef SIMD_H
+#define SIMD_H
+
+// Pick the SIMD instruction set the kernels are built with. CMake enables
+// NEON on the Pi and SSSE3 on x86 when RASPI_HW_ENABLE_SIMD is on.
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RASPI_HW_NEON 1
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#define RASPI_HW_SSSE3 1
+#endif
+
+#endif //SIMD_H
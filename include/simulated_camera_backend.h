@@ -0,0 +1,59 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef SIMULATED_CAMERA_BACKEND_H
+#define SIMULATED_CAMERA_BACKEND_H
+
+#include "camera_backend.h"
+
+/**
+ * Stand-in camera that fills buffers with a synthetic gradient. Keeps
+ * count of the captures and remembers the last buffer written so callers
+ * can check that frames landed in their own storage. A capture latency
+ * makes each capture take about as long as a real exposure, and an open
+ * latency makes opening take about as long as starting the real camera.
+ */
+class SimulatedCameraBackend : public CameraBackend {
+
+public:
+    explicit SimulatedCameraBackend(unsigned long capture_latency_us = 0);
+    bool open() override;
+    void release() override;
+    void set_width(unsigned int new_width) override;
+    void set_height(unsigned int new_height) override;
+    void set_encoding(PixelFormat new_encoding) override;
+    void set_sharpness(int) override {}
+    void set_contrast(int) override {}
+    void set_brightness(unsigned int) override {}
+    void set_saturation(int) override {}
+    void set_iso(int) override {}
+    void set_exposure_auto() override {}
+    void set_exposure_locked(bool locked) override;
+    [[nodiscard]] size_t get_image_buffer_size() const override;
+    [[nodiscard]] size_t get_image_buffer_size(unsigned int new_width, unsigned int new_height,
+                                               PixelFormat new_encoding) const override;
+    bool grab_retrieve(unsigned char* data, size_t size) override;
+    void set_capture_latency_us(unsigned long new_capture_latency_us);
+    [[nodiscard]] unsigned long get_capture_latency_us() const;
+    void set_open_latency_us(unsigned long new_open_latency_us);
+    [[nodiscard]] unsigned long get_open_latency_us() const;
+    [[nodiscard]] bool get_is_open() const;
+    [[nodiscard]] bool get_exposure_locked() const;
+    [[nodiscard]] unsigned long get_grab_count() const;
+    [[nodiscard]] unsigned long get_open_count() const;
+    [[nodiscard]] const unsigned char* get_last_buffer() const;
+
+private:
+    unsigned int width;
+    unsigned int height;
+    PixelFormat encoding;
+    unsigned long capture_latency_us;
+    unsigned long open_latency_us;
+    bool is_open;
+    bool exposure_locked;
+    unsigned long grab_count;
+    unsigned long open_count;
+    const unsigned char* last_buffer;
+};
+
+#endif //SIMULATED_CAMERA_BACKEND_H
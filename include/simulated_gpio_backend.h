@@ -0,0 +1,61 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef SIMULATED_GPIO_BACKEND_H
+#define SIMULATED_GPIO_BACKEND_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "gpio_backend.h"
+
+/**
+ * Levels of all pins right after one device write.
+ */
+struct GpioEvent {
+    int64_t timestamp_ns;
+    uint64_t levels;
+};
+
+/**
+ * Stand-in GPIO that keeps pin modes and levels in memory. Keeps count
+ * of the device writes, where write_outputs() counts once like on the
+ * batched backends, so tests can check how many steps reached the pins.
+ * Pins 0-63 are supported. Safe to read from another thread while the
+ * motion thread writes. While recording, every write also appends a
+ * timestamped GpioEvent so step timing can be checked off the Pi.
+ */
+class SimulatedGpioBackend : public GpioBackend {
+
+public:
+    static constexpr unsigned int pin_count = 64;
+    SimulatedGpioBackend();
+    bool setup() override;
+    void set_mode(unsigned int pin, PinMode mode) override;
+    void write(unsigned int pin, bool level) override;
+    void write_outputs(const unsigned int* pins, size_t count, uint32_t new_levels) override;
+    [[nodiscard]] bool get_is_setup() const;
+    [[nodiscard]] PinMode get_mode(unsigned int pin) const;
+    [[nodiscard]] bool get_level(unsigned int pin) const;
+    [[nodiscard]] uint64_t get_levels() const;
+    [[nodiscard]] uint64_t get_write_count() const;
+    void start_recording(size_t max_events = 1 << 20);
+    void stop_recording();
+    [[nodiscard]] bool get_is_recording() const;
+    [[nodiscard]] std::vector<GpioEvent> get_timeline() const;
+    void clear_timeline();
+
+private:
+    static uint64_t pin_bit(unsigned int pin);
+    void record(uint64_t new_levels);
+    std::atomic<bool> is_setup;
+    std::atomic<uint64_t> output_pins;
+    std::atomic<uint64_t> levels;
+    std::atomic<uint64_t> write_count;
+    std::atomic<bool> is_recording;
+    mutable std::mutex timeline_mutex;
+    std::vector<GpioEvent> timeline;
+    size_t max_timeline_events;
+};
+
+#endif //SIMULATED_GPIO_BACKEND_H
@@ -0,0 +1,101 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef STEP_TABLE_H
+#define STEP_TABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Coil patterns for a 4 coil unipolar stepper. wave drives one coil at
+ * a time, full_step drives two for more torque, and half_step alternates
+ * between one and two for twice the resolution. steps_per_rev in
+ * MotorConfig counts half steps, so wave and full_step take half as many.
+ * Microstepping needs PWM current control, which the on/off ULN2003
+ * driver cannot do, so it is not offered.
+ */
+enum class DriveMode : uint8_t {
+    wave,
+    full_step,
+    half_step
+};
+
+/**
+ * Pin masks for one drive mode, built at compile time. Bit i of a mask
+ * is the level of pin i. Walking forward through the table turns the
+ * motor clockwise and walking backward turns it counter-clockwise, so
+ * taking a step is one table read with no arithmetic on the pattern.
+ * Tables are indexed by coil phase in half steps shifted by
+ * phase_shift: full steps sit on the even half steps and wave steps on
+ * the odd ones, as phase_parity says. A phase on the other parity is
+ * half a step off the table, so after a drive mode change the motor
+ * takes one half step to get back on it, see MotorController.
+ */
+template <DriveMode Mode>
+struct StepTable {
+    static constexpr size_t length = Mode == DriveMode::half_step ? 8 : 4;
+    static constexpr unsigned int half_steps_per_step = Mode == DriveMode::half_step ? 1 : 2;
+    static constexpr unsigned int phase_shift = Mode == DriveMode::half_step ? 0 : 1;
+    static constexpr unsigned int phase_parity = Mode == DriveMode::wave ? 1 : 0;
+
+    static constexpr std::array<uint8_t, length> make_forward() {
+        std::array<uint8_t, length> masks{};
+        for (size_t i = 0; i < length; ++i) {
+            if constexpr (Mode == DriveMode::wave) {
+                masks[i] = static_cast<uint8_t>(1u << i);
+            } else if constexpr (Mode == DriveMode::full_step) {
+                masks[i] = static_cast<uint8_t>(1u << i | 1u << (i + 3) % 4);
+            } else {
+                // Even half steps pair the coil before with the current one, odd ones use it alone.
+                const size_t coil = i / 2;
+                masks[i] = static_cast<uint8_t>(i % 2 == 0 ? 1u << coil | 1u << (coil + 3) % 4 : 1u << coil);
+            }
+        }
+        return masks;
+    }
+
+    static constexpr std::array<uint8_t, length> forward = make_forward();
+};
+
+// The half step table is the sequence the motor has always used.
+static_assert(StepTable<DriveMode::half_step>::forward[0] == 0b1001);
+static_assert(StepTable<DriveMode::half_step>::forward[1] == 0b0001);
+static_assert(StepTable<DriveMode::half_step>::forward[2] == 0b0011);
+static_assert(StepTable<DriveMode::half_step>::forward[7] == 0b1000);
+static_assert(StepTable<DriveMode::full_step>::forward[1] == StepTable<DriveMode::half_step>::forward[2]);
+static_assert(StepTable<DriveMode::wave>::forward[1] == StepTable<DriveMode::half_step>::forward[3]);
+
+/**
+ * The table of the drive mode chosen at run time. The mask for a coil
+ * phase is forward[(phase >> phase_shift) & index_mask], since table
+ * lengths are powers of two.
+ */
+struct StepSequence {
+    const uint8_t* forward;
+    uint32_t index_mask;
+    unsigned int half_steps_per_step;
+    unsigned int phase_shift;
+    unsigned int phase_parity;
+};
+
+template <DriveMode Mode>
+constexpr StepSequence make_step_sequence() {
+    using Table = StepTable<Mode>;
+    return {Table::forward.data(), static_cast<uint32_t>(Table::length - 1), Table::half_steps_per_step,
+            Table::phase_shift, Table::phase_parity};
+}
+
+constexpr StepSequence step_sequence_for(const DriveMode mode) {
+    switch (mode) {
+        case DriveMode::wave:
+            return make_step_sequence<DriveMode::wave>();
+        case DriveMode::full_step:
+            return make_step_sequence<DriveMode::full_step>();
+        default:
+            return make_step_sequence<DriveMode::half_step>();
+    }
+}
+
+#endif //STEP_TABLE_H
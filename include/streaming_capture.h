@@ -0,0 +1,45 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef STREAMING_CAPTURE_H
+#define STREAMING_CAPTURE_H
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "frame_ring.h"
+#include "frame_source.h"
+
+/**
+ * Continuous capture on a dedicated thread. The thread keeps reading
+ * frames from the source into a ring of preallocated frames, and the
+ * consumer pulls the next or the latest frame without blocking the thread.
+ */
+class StreamingCapture {
+
+public:
+    explicit StreamingCapture(std::unique_ptr<FrameSource> source, size_t slot_count = 4,
+                              DropPolicy policy = DropPolicy::drop_oldest);
+    ~StreamingCapture();
+    StreamingCapture(const StreamingCapture&) = delete;
+    StreamingCapture& operator=(const StreamingCapture&) = delete;
+    void start();
+    void stop();
+    [[nodiscard]] bool is_running() const;
+    bool get_next_frame(Image& frame);
+    bool get_latest_frame(Image& frame);
+    bool wait_next_frame(Image& frame, unsigned int timeout_ms);
+    [[nodiscard]] uint64_t get_captured_count() const;
+    [[nodiscard]] uint64_t get_dropped_count() const;
+    [[nodiscard]] uint64_t get_failed_count() const;
+
+private:
+    void capture_loop();
+    std::unique_ptr<FrameSource> source;
+    FrameRing ring;
+    std::thread capture_thread;
+    std::atomic<bool> running;
+    std::atomic<uint64_t> failed;
+};
+
+#endif //STREAMING_CAPTURE_H
@@ -0,0 +1,17 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef WIRINGPI_BACKEND_H
+#define WIRINGPI_BACKEND_H
+
+#include "gpio_backend.h"
+
+class WiringPiBackend : public GpioBackend {
+
+public:
+    bool setup() override;
+    void set_mode(unsigned int pin, PinMode mode) override;
+    void write(unsigned int pin, bool level) override;
+};
+
+#endif //WIRINGPI_BACKEND_H
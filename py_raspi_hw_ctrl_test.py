@@ -1,4 +1,4 @@
-from py_raspi_hw_ctrl import HardwareController
+from py_raspi_hw_ctrl import HardwareController, PixelFormat, FrameArchiveWriter, FrameArchiveReader, ScanConfig, get_metrics_snapshot
 from PIL import Image
 import io
 import numpy as np
@@ -22,10 +22,40 @@ if __name__ == "__main__":
     # cc.set_image_encoding("rgb")
     # cc.open_camera()
     # img = cc.capture_image()
+    # arr = np.asarray(img)  # (height, width, 3), no copy, header left out, same as img.get_array()
     # img.remove_rgb_header()
-    # img.flip_rgb_v()
-    # arr = np.frombuffer(img.get_data(), dtype=np.uint8)
-    # arr = arr.reshape((img.get_height(), img.get_width(), 3))
+    # img.flip_rgb_v()  # img copies its pixels first, so arr keeps the old frame and stays valid
+    # Gray or yuv420 without converting in python
+    # img.convert_to(PixelFormat.gray)
+    # gray = np.asarray(img)  # (height, width)
+    # Wrap an existing array, the flip happens in the array's memory
+    # from py_raspi_hw_ctrl import Image as HwImage
+    # wrapped = HwImage(np.zeros((240, 320, 3), dtype=np.uint8))
+    # wrapped.flip_rgb_h()
+    # Crop without copying and shrink in C++ instead of in PIL
+    # from py_raspi_hw_ctrl import ResizeFilter
+    # roi = img.crop(80, 60, 160, 120)  # shares pixels with img, np.asarray(roi) has its row stride
+    # half = img.downscale(2)  # (120, 160, 3)
+    # thumb = roi.resize(64, 48, ResizeFilter.area)
+    # Several frames back to back with the exposure of the first, as one (8, 240, 320, 3) array
+    # frames, timestamps_ns = cc.capture_burst(8)
+    # denoised = frames.mean(axis=0)
+    # Switch between named settings, reopening only when the resolution or encoding changes
+    # from py_raspi_hw_ctrl import CameraConfig
+    # full = CameraConfig()
+    # full.image_width, full.image_height, full.encoding = 1280, 960, PixelFormat.rgb
+    # cc.add_profile("full", full)
+    # cc.use_profile("full")
+    # Lossless and much faster than png, read back with load_qoi
+    # img.save("./test_img.qoi")
+    # from py_raspi_hw_ctrl import load_qoi
+    # same = load_qoi("./test_img.qoi")
+    # Many frames in one archive file, read back as arrays over the mapped file
+    # writer = FrameArchiveWriter("./scan.rhw", 360)
+    # writer.append(img)
+    # writer.close()
+    # reader = FrameArchiveReader("./scan.rhw")
+    # arr = reader.get_array(0)
 
     # For motor control
     mc = hw.motor_controller
@@ -33,5 +63,24 @@ if __name__ == "__main__":
     mc.set_to_output_mode()
     mc.rotate(90, 1)
     mc.rotate(90, -1)
+    # Or move in the background while capturing
+    # move = mc.rotate_async(90, 1)
+    # img = cc.capture_image()
+    # move.get()
+    # print(mc.get_position())
+    # Or move to angles from home, keeping the position across restarts
+    # mc.set_position_file("./motor_position.txt")
+    # mc.move_to(45.5)
+    # print(mc.get_angle())
+
+    # Or capture at several angles, moving while the last frame is saved
+    # config = ScanConfig()
+    # config.output_dir = "./scan"
+    # config.output_format = PixelFormat.qoi  # with rgb encoding, compressed on the writer threads
+    # frames = hw.scan([0, 10, 20, 30], config)
+
+    # Latency histograms and counters for everything above
+    # metrics = get_metrics_snapshot()
+    # print(metrics.timers["capture"].p99_ns, metrics.counters["frames_captured"])
 
     hw.cleanup_all()
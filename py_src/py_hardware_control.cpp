@@ -2,20 +2,199 @@
 // Created by Joe Pettinelli on 2/18/25.
 //
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
 #include "image.h"
+#include "image_thread_pool.h"
+#include "frame_buffer_pool.h"
 #include "camera_control.h"
 #include "motor_control.h"
+#include "multi_axis_control.h"
+#include "simulated_gpio_backend.h"
+#include "simulated_camera_backend.h"
 #include "hardware_control.h"
+#include "streaming_capture.h"
+#include "image_writer.h"
+#include "frame_archive.h"
+#include "logger.h"
+#include "metrics.h"
+#include "qoi_codec.h"
+#include <future>
+#include <memory>
+#include <optional>
 #include <vector>
 
 namespace py = pybind11;
 
+namespace {
+
+/**
+ * Get the numpy shape of an image. Packed raw formats are (height,
+ * width, channels), or (height, width) for gray. Any rgb header trails
+ * the pixels, so it is left out. Everything else is flat bytes.
+ *
+ * @param image The image.
+ * @return The shape.
+ */
+std::vector<ssize_t> get_array_shape(const Image& image) {
+    const PixelFormatInfo& info = pixel_format_info(image.get_format());
+    const size_t height = image.get_height();
+    const size_t width = image.get_width();
+    const size_t channels = info.bytes_per_pixel;
+    if (info.is_raw && info.planes == 1 && height * width > 0 && image.get_size() >= height * width * channels) {
+        std::vector<ssize_t> shape = {static_cast<ssize_t>(height), static_cast<ssize_t>(width)};
+        if (channels > 1) {
+            shape.push_back(static_cast<ssize_t>(channels));
+        }
+        return shape;
+    }
+    return {static_cast<ssize_t>(image.get_size())};
+}
+
+/**
+ * Get the numpy strides that go with get_array_shape(). Rows are
+ * get_stride() bytes apart, so crop views need no copy.
+ *
+ * @param image The image.
+ * @param shape The shape from get_array_shape().
+ * @return The strides in bytes.
+ */
+std::vector<ssize_t> get_array_strides(const Image& image, const std::vector<ssize_t>& shape) {
+    if (shape.size() == 1) {
+        return {1};
+    }
+    std::vector<ssize_t> strides = {static_cast<ssize_t>(image.get_stride()), 1};
+    if (shape.size() == 3) {
+        strides[1] = shape[2];
+        strides.push_back(1);
+    }
+    return strides;
+}
+
+/**
+ * Get a numpy array over the pixels of an image without copying. The
+ * array keeps its own reference to the buffer, so it stays valid after
+ * the image is changed or deleted. The image copies the buffer before
+ * its next pixel change instead of writing under the array.
+ *
+ * @param image The image.
+ * @param readonly Whether the array is read only.
+ * @return The array.
+ */
+py::array make_image_array(const Image& image, const bool readonly) {
+    auto owner_image = new Image(image);
+    py::capsule owner(owner_image, [](void* p) { delete static_cast<Image*>(p); });
+    const std::vector<ssize_t> shape = get_array_shape(*owner_image);
+    py::array_t<unsigned char> array(shape, get_array_strides(*owner_image, shape), owner_image->get_data(), owner);
+    if (readonly) {
+        array.attr("flags").attr("writeable") = false;
+    }
+    return array;
+}
+
+/**
+ * Get one numpy array over all frames of a burst without copying,
+ * (count, height, width, channels) for rgb and (count, bytes) for png
+ * and jpeg. Frames are frame_stride bytes apart, so each rgb header is
+ * skipped. The array keeps its own reference to the burst buffer.
+ *
+ * @param burst The burst.
+ * @return The array.
+ */
+py::array make_burst_array(const FrameBurst& burst) {
+    auto owner_buffer = new std::shared_ptr<unsigned char>(burst.buffer);
+    py::capsule owner(owner_buffer, [](void* p) { delete static_cast<std::shared_ptr<unsigned char>*>(p); });
+    std::vector<ssize_t> shape = {static_cast<ssize_t>(burst.frames.size())};
+    std::vector<ssize_t> strides = {static_cast<ssize_t>(burst.frame_stride)};
+    if (burst.frames.empty()) {
+        shape.push_back(0);
+        strides.push_back(1);
+    } else {
+        const std::vector<ssize_t> frame_shape = get_array_shape(burst.frames[0]);
+        const std::vector<ssize_t> frame_strides = get_array_strides(burst.frames[0], frame_shape);
+        shape.insert(shape.end(), frame_shape.begin(), frame_shape.end());
+        strides.insert(strides.end(), frame_strides.begin(), frame_strides.end());
+    }
+    return py::array_t<unsigned char>(shape, strides, owner_buffer->get(), owner);
+}
+
+/**
+ * Wrap a numpy array in an Image without copying. The image keeps the
+ * array alive and changes pixels in place, so the array sees them.
+ *
+ * @param array A C contiguous, writeable uint8 array, (height, width) for gray
+ *              or (height, width, channels) for rgb, bgr, or rgba.
+ * @param format The encoding, or none to pick it from the channel count.
+ * @return The image.
+ * @throws std::invalid_argument if the array layout does not fit the encoding.
+ */
+Image image_from_array(py::array_t<unsigned char> array, PixelFormat format) {
+    if (!(array.flags() & py::array::c_style) || !array.writeable()) {
+        throw std::invalid_argument("Use a C contiguous, writeable uint8 array, or copy it first.");
+    }
+    const ssize_t channels = array.ndim() == 3 ? array.shape(2) : 1;
+    if (format == PixelFormat::none) {
+        format = channels == 4 ? PixelFormat::rgba : channels == 3 ? PixelFormat::rgb : PixelFormat::gray;
+    }
+    const PixelFormatInfo& info = pixel_format_info(format);
+    if (array.ndim() < 2 || array.ndim() > 3 || !info.is_raw || info.planes != 1 ||
+        info.bytes_per_pixel != channels) {
+        throw std::invalid_argument("Use (height, width) for gray or (height, width, channels) for rgb, bgr, or rgba.");
+    }
+    // The deleter can run on a writer thread, so it takes the GIL to drop the array.
+    unsigned char* pixels = array.mutable_data();
+    auto array_ref = new py::object(array);
+    std::shared_ptr<unsigned char> data(pixels, [array_ref](unsigned char*) {
+        py::gil_scoped_acquire acquire;
+        delete array_ref;
+    });
+    return Image(std::move(data), static_cast<size_t>(array.nbytes()), static_cast<unsigned int>(array.shape(1)),
+                 static_cast<unsigned int>(array.shape(0)), format, false);
+}
+
+}
+
 PYBIND11_MODULE(py_raspi_hw_ctrl, m) {
 
+    py::enum_<PixelFormat>(m, "PixelFormat")
+        .value("none", PixelFormat::none)
+        .value("png", PixelFormat::png)
+        .value("jpeg", PixelFormat::jpeg)
+        .value("rgb", PixelFormat::rgb)
+        .value("bgr", PixelFormat::bgr)
+        .value("rgba", PixelFormat::rgba)
+        .value("gray", PixelFormat::gray)
+        .value("yuv420", PixelFormat::yuv420)
+        .value("qoi", PixelFormat::qoi);
+
+    py::enum_<ResizeFilter>(m, "ResizeFilter")
+        .value("box", ResizeFilter::box)
+        .value("bilinear", ResizeFilter::bilinear)
+        .value("area", ResizeFilter::area);
+
     py::class_<Image>(m, "Image")
         .def(py::init<>(), "Constructor 1")
         .def(py::init<size_t, unsigned int, unsigned int, std::string, bool>(), "Constructor 2")
+        .def(py::init<size_t, unsigned int, unsigned int, PixelFormat, bool>(), "Constructor 2 with pixel format")
         .def(py::init<const unsigned char*, size_t, int, int, std::string, bool>(), "Constructor 3")
+        .def(py::init(&image_from_array), "Wrap a numpy array without copying",
+             py::arg("array").noconvert(), py::arg("format") = PixelFormat::none)
+        // np.asarray(image) comes here rather than through the buffer protocol, which can only keep the
+        // Python object alive. Like get_array(), the array holds its own reference to the buffer, so it
+        // stays valid when the image is resized, converted or deleted. Read only while other images share it.
+        .def("__array__", [](const Image& self, const py::object& dtype, const py::object& copy) {
+            py::object array = make_image_array(self, self.is_shared());
+            if (!dtype.is_none()) {
+                array = array.attr("astype")(dtype, py::arg("copy") = false);
+            }
+            if (!copy.is_none() && copy.cast<bool>()) {
+                array = array.attr("copy")();
+            }
+            return array;
+        }, py::arg("dtype") = py::none(), py::arg("copy") = py::none())
+        .def("get_array", [](const Image& self) {
+            return make_image_array(self, false);
+        })
         .def("get_data", [](const Image& self) {
             void* ptr = self.get_data();
             ssize_t item_size = 1;
@@ -26,36 +205,433 @@ PYBIND11_MODULE(py_raspi_hw_ctrl, m) {
             return py::memoryview::from_buffer(ptr, item_size, format, shape, strides, readonly);
         })
         .def("get_size", &Image::get_size)
+        .def("get_capacity", &Image::get_capacity)
+        .def("is_shared", &Image::is_shared)
+        .def("get_stride", &Image::get_stride)
+        .def("is_contiguous", &Image::is_contiguous)
+        .def("clone", &Image::clone)
+        .def("get_frame_info", &Image::get_frame_info)
+        .def("set_frame_info", &Image::set_frame_info)
         .def("get_width", &Image::get_width)
         .def("get_height", &Image::get_height)
         .def("get_encoding", &Image::get_encoding)
+        .def("get_format", &Image::get_format)
         .def("save", &Image::save)
         .def("remove_rgb_header", &Image::remove_rgb_header)
-        .def("flip_rgb_h", &Image::flip_rgb_h)
-        .def("flip_rgb_v", &Image::flip_rgb_v);
+        .def("flip_rgb_h", &Image::flip_rgb_h, py::arg("max_threads") = 0)
+        .def("flip_rgb_v", &Image::flip_rgb_v, py::arg("max_threads") = 0)
+        .def("rotate_rgb_90", &Image::rotate_rgb_90)
+        .def("rotate_rgb_180", &Image::rotate_rgb_180)
+        .def("rotate_rgb_270", &Image::rotate_rgb_270)
+        .def("transpose_rgb", &Image::transpose_rgb)
+        .def("convert_to", &Image::convert_to, py::arg("new_format"), py::arg("max_threads") = 0)
+        // The crop shares pixels with this image, like a numpy slice.
+        .def("crop", &Image::crop, py::arg("x"), py::arg("y"), py::arg("width"), py::arg("height"))
+        .def("resize", &Image::resize, py::arg("width"), py::arg("height"), py::arg("filter") = ResizeFilter::area,
+             py::arg("max_threads") = 0)
+        .def("downscale", &Image::downscale, py::arg("factor"), py::arg("max_threads") = 0);
+
+    py::class_<FrameBufferPoolStats>(m, "FrameBufferPoolStats")
+        .def_readonly("hits", &FrameBufferPoolStats::hits)
+        .def_readonly("misses", &FrameBufferPoolStats::misses)
+        .def_readonly("releases", &FrameBufferPoolStats::releases)
+        .def_readonly("frees", &FrameBufferPoolStats::frees)
+        .def_readonly("bytes_allocated", &FrameBufferPoolStats::bytes_allocated)
+        .def_readonly("bytes_pooled", &FrameBufferPoolStats::bytes_pooled);
+
+    py::class_<FrameBufferPool, std::unique_ptr<FrameBufferPool, py::nodelete>>(m, "FrameBufferPool")
+        .def_static("instance", &FrameBufferPool::instance, py::return_value_policy::reference)
+        .def("reserve", &FrameBufferPool::reserve)
+        .def("clear", &FrameBufferPool::clear)
+        .def("set_max_free_per_size", &FrameBufferPool::set_max_free_per_size)
+        .def("get_max_free_per_size", &FrameBufferPool::get_max_free_per_size)
+        .def("set_max_free_bytes", &FrameBufferPool::set_max_free_bytes)
+        .def("get_max_free_bytes", &FrameBufferPool::get_max_free_bytes)
+        .def("get_stats", &FrameBufferPool::get_stats)
+        .def("reset_stats", &FrameBufferPool::reset_stats);
+
+    py::class_<CameraConfig>(m, "CameraConfig")
+        .def(py::init<>())
+        .def_readwrite("sharpness", &CameraConfig::sharpness)
+        .def_readwrite("contrast", &CameraConfig::contrast)
+        .def_readwrite("brightness", &CameraConfig::brightness)
+        .def_readwrite("saturation", &CameraConfig::saturation)
+        .def_readwrite("iso", &CameraConfig::iso)
+        .def_readwrite("image_width", &CameraConfig::image_width)
+        .def_readwrite("image_height", &CameraConfig::image_height)
+        .def_readwrite("encoding", &CameraConfig::encoding);
 
     py::class_<CameraController>(m, "CameraController")
         .def(py::init<>())
         .def("open_camera", &CameraController::open_camera)
-        .def("capture_image", &CameraController::capture_image)
+        .def("capture_image", py::overload_cast<>(&CameraController::capture_image))
+        .def("capture_image", py::overload_cast<Image&>(&CameraController::capture_image))
+        // One array over the whole burst plus the steady clock time of each frame in nanoseconds.
+        .def("capture_burst", [](CameraController& self, const size_t count, const bool lock_exposure) {
+            FrameBurst burst;
+            {
+                py::gil_scoped_release release;
+                self.capture_burst(count, burst, lock_exposure);
+            }
+            std::vector<int64_t> timestamps_ns;
+            timestamps_ns.reserve(burst.frames.size());
+            for (const Image& frame : burst.frames) {
+                timestamps_ns.push_back(frame.get_frame_info().timestamp_ns);
+            }
+            return py::make_tuple(make_burst_array(burst), timestamps_ns);
+        }, py::arg("count"), py::arg("lock_exposure") = true)
         .def("release_camera", &CameraController::release_camera)
         .def("set_image_width", &CameraController::set_image_width)
         .def("set_image_height", &CameraController::set_image_height)
-        .def("set_image_encoding", &CameraController::set_image_encoding)
+        .def("set_image_encoding", py::overload_cast<const std::string&>(&CameraController::set_image_encoding))
+        .def("set_image_encoding", py::overload_cast<PixelFormat>(&CameraController::set_image_encoding))
         .def("get_image_width", &CameraController::get_image_width)
         .def("get_image_height", &CameraController::get_image_height)
-        .def("get_image_encoding", &CameraController::get_image_encoding);
+        .def("get_image_encoding", &CameraController::get_image_encoding)
+        .def("get_image_format", &CameraController::get_image_format)
+        .def("get_image_buffer_size", &CameraController::get_image_buffer_size)
+        .def("get_config", &CameraController::get_config)
+        .def("get_is_open", &CameraController::get_is_open)
+        .def("add_profile", &CameraController::add_profile, py::arg("name"), py::arg("profile_config"),
+             py::arg("prewarm_count") = 2)
+        .def("remove_profile", &CameraController::remove_profile)
+        .def("use_profile", &CameraController::use_profile)
+        .def("has_profile", &CameraController::has_profile)
+        .def("get_profile_names", &CameraController::get_profile_names)
+        .def("get_profile_buffer_size", &CameraController::get_profile_buffer_size)
+        .def("get_profile_name", &CameraController::get_profile_name);
+
+    py::class_<FrameInfo>(m, "FrameInfo")
+        .def(py::init<>())
+        .def_readwrite("sequence", &FrameInfo::sequence)
+        .def_readwrite("timestamp_ns", &FrameInfo::timestamp_ns)
+        .def_readwrite("motor_position", &FrameInfo::motor_position)
+        .def_readwrite("has_motor_position", &FrameInfo::has_motor_position);
+
+    py::enum_<DropPolicy>(m, "DropPolicy")
+        .value("drop_oldest", DropPolicy::drop_oldest)
+        .value("drop_newest", DropPolicy::drop_newest);
+
+    py::class_<StreamingCapture>(m, "StreamingCapture")
+        .def(py::init([](CameraController& camera_controller, const size_t slot_count, const DropPolicy policy) {
+            return std::make_unique<StreamingCapture>(std::make_unique<CameraFrameSource>(camera_controller),
+                                                      slot_count, policy);
+        }), py::arg("camera_controller"), py::arg("slot_count") = 4, py::arg("policy") = DropPolicy::drop_oldest,
+            py::keep_alive<1, 2>())
+        .def_static("synthetic", [](const unsigned int width, const unsigned int height,
+                                    const unsigned int frame_interval_us, const size_t slot_count,
+                                    const DropPolicy policy) {
+            return std::make_unique<StreamingCapture>(
+                std::make_unique<SyntheticFrameSource>(width, height, frame_interval_us), slot_count, policy);
+        }, py::arg("width"), py::arg("height"), py::arg("frame_interval_us"), py::arg("slot_count") = 4,
+            py::arg("policy") = DropPolicy::drop_oldest)
+        .def("start", &StreamingCapture::start)
+        .def("stop", &StreamingCapture::stop, py::call_guard<py::gil_scoped_release>())
+        .def("is_running", &StreamingCapture::is_running)
+        .def("get_next_frame", [](StreamingCapture& self) -> std::optional<Image> {
+            Image frame;
+            if (self.get_next_frame(frame)) {
+                return frame;
+            }
+            return std::nullopt;
+        })
+        .def("get_latest_frame", [](StreamingCapture& self) -> std::optional<Image> {
+            Image frame;
+            if (self.get_latest_frame(frame)) {
+                return frame;
+            }
+            return std::nullopt;
+        })
+        .def("wait_next_frame", [](StreamingCapture& self, const unsigned int timeout_ms) -> std::optional<Image> {
+            Image frame;
+            bool got_frame;
+            {
+                py::gil_scoped_release release;
+                got_frame = self.wait_next_frame(frame, timeout_ms);
+            }
+            if (got_frame) {
+                return frame;
+            }
+            return std::nullopt;
+        })
+        .def("get_captured_count", &StreamingCapture::get_captured_count)
+        .def("get_dropped_count", &StreamingCapture::get_dropped_count)
+        .def("get_failed_count", &StreamingCapture::get_failed_count);
+
+    py::enum_<FsyncPolicy>(m, "FsyncPolicy")
+        .value("none", FsyncPolicy::none)
+        .value("per_file", FsyncPolicy::per_file)
+        .value("per_batch", FsyncPolicy::per_batch);
+
+    py::class_<ImageWriterConfig>(m, "ImageWriterConfig")
+        .def(py::init<>())
+        .def_readwrite("thread_count", &ImageWriterConfig::thread_count)
+        .def_readwrite("queue_capacity", &ImageWriterConfig::queue_capacity)
+        .def_readwrite("max_batch", &ImageWriterConfig::max_batch)
+        .def_readwrite("fsync_policy", &ImageWriterConfig::fsync_policy)
+        .def_readwrite("direct_io", &ImageWriterConfig::direct_io);
+
+    py::class_<std::shared_future<bool>>(m, "SaveFuture")
+        .def("get", [](const std::shared_future<bool>& self) { return self.get(); },
+             py::call_guard<py::gil_scoped_release>())
+        .def("ready", [](const std::shared_future<bool>& self) {
+            return self.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        });
+
+    // Motor moves return the same future type.
+    m.attr("MoveFuture") = m.attr("SaveFuture");
+
+    py::class_<ImageWriter>(m, "ImageWriter")
+        .def(py::init<>())
+        .def(py::init<const ImageWriterConfig&>())
+        .def("save_async", [](ImageWriter& self, const Image& image, const std::string& file_path) {
+            py::gil_scoped_release release;
+            return self.save_async(image, file_path).share();
+        })
+        .def("save_async", [](ImageWriter& self, const Image& image, const std::string& file_path,
+                              py::function callback) {
+            // The callback runs on a writer thread, so take the GIL to call it and to release it.
+            auto held_callback = std::shared_ptr<py::function>(new py::function(std::move(callback)),
+                                                               [](py::function* f) {
+                py::gil_scoped_acquire acquire;
+                delete f;
+            });
+            py::gil_scoped_release release;
+            self.save_async(image, file_path, [held_callback](const bool saved) {
+                py::gil_scoped_acquire acquire;
+                (*held_callback)(saved);
+            });
+        })
+        .def("flush", &ImageWriter::flush, py::call_guard<py::gil_scoped_release>())
+        .def("get_queued_count", &ImageWriter::get_queued_count)
+        .def("get_saved_count", &ImageWriter::get_saved_count)
+        .def("get_failed_count", &ImageWriter::get_failed_count)
+        .def("get_bytes_written", &ImageWriter::get_bytes_written);
+
+    py::class_<FrameArchiveEntry>(m, "FrameArchiveEntry")
+        .def_readonly("offset", &FrameArchiveEntry::offset)
+        .def_readonly("size", &FrameArchiveEntry::size)
+        .def_readonly("width", &FrameArchiveEntry::width)
+        .def_readonly("height", &FrameArchiveEntry::height)
+        .def_property_readonly("format", [](const FrameArchiveEntry& self) {
+            return static_cast<PixelFormat>(self.format);
+        })
+        .def_property_readonly("has_header", [](const FrameArchiveEntry& self) { return self.has_header != 0; })
+        .def_readonly("sequence", &FrameArchiveEntry::sequence)
+        .def_readonly("timestamp_ns", &FrameArchiveEntry::timestamp_ns)
+        .def_readonly("motor_position", &FrameArchiveEntry::motor_position)
+        .def_property_readonly("has_motor_position", [](const FrameArchiveEntry& self) {
+            return self.has_motor_position != 0;
+        });
+
+    py::class_<FrameArchiveWriter>(m, "FrameArchiveWriter")
+        .def(py::init<const std::string&, uint32_t>(), py::arg("file_path"), py::arg("capacity"))
+        .def("append", &FrameArchiveWriter::append, py::call_guard<py::gil_scoped_release>())
+        .def("close", &FrameArchiveWriter::close)
+        .def("get_frame_count", &FrameArchiveWriter::get_frame_count)
+        .def("get_capacity", &FrameArchiveWriter::get_capacity);
+
+    py::class_<FrameArchiveReader>(m, "FrameArchiveReader")
+        .def(py::init<const std::string&>())
+        .def("get_frame_count", &FrameArchiveReader::get_frame_count)
+        .def("__len__", &FrameArchiveReader::get_frame_count)
+        .def("get_entry", &FrameArchiveReader::get_entry, py::return_value_policy::reference_internal)
+        .def("get_frame", &FrameArchiveReader::get_frame)
+        .def("get_array", [](const FrameArchiveReader& self, const uint64_t index) {
+            // Frames from the same archive share memory, so hand out read only arrays.
+            return make_image_array(self.get_frame(index), true);
+        });
+
+    py::enum_<DriveMode>(m, "DriveMode")
+        .value("wave", DriveMode::wave)
+        .value("full_step", DriveMode::full_step)
+        .value("half_step", DriveMode::half_step);
+
+    py::enum_<ProfileShape>(m, "ProfileShape")
+        .value("constant", ProfileShape::constant)
+        .value("trapezoidal", ProfileShape::trapezoidal)
+        .value("s_curve", ProfileShape::s_curve);
+
+    py::class_<MotionProfileConfig>(m, "MotionProfileConfig")
+        .def(py::init<>())
+        .def_readwrite("shape", &MotionProfileConfig::shape)
+        .def_readwrite("start_velocity", &MotionProfileConfig::start_velocity)
+        .def_readwrite("max_velocity", &MotionProfileConfig::max_velocity)
+        .def_readwrite("max_acceleration", &MotionProfileConfig::max_acceleration)
+        .def_readwrite("max_jerk", &MotionProfileConfig::max_jerk);
+
+    m.def("get_default_camera_backend_name", &get_default_camera_backend_name);
+    m.def("get_default_gpio_backend_name", &get_default_gpio_backend_name);
+    m.def("build_step_delays", &build_step_delays);
+    m.def("get_move_time_us", &get_move_time_us);
+
+    py::class_<JitterStats>(m, "JitterStats")
+        .def_readonly("sample_count", &JitterStats::sample_count)
+        .def_readonly("min_ns", &JitterStats::min_ns)
+        .def_readonly("max_ns", &JitterStats::max_ns)
+        .def_readonly("mean_ns", &JitterStats::mean_ns)
+        .def_readonly("overrun_count", &JitterStats::overrun_count);
+
+    py::enum_<LogLevel>(m, "LogLevel")
+        .value("debug", LogLevel::debug)
+        .value("info", LogLevel::info)
+        .value("warn", LogLevel::warn)
+        .value("error", LogLevel::error)
+        .value("off", LogLevel::off);
+    m.def("set_log_level", [](const LogLevel level) {
+        Logger::instance().set_level(level);
+    });
+    m.def("get_log_level", [] {
+        return Logger::instance().get_level();
+    });
+
+    py::class_<HistogramSnapshot>(m, "HistogramSnapshot")
+        .def_readonly("count", &HistogramSnapshot::count)
+        .def_readonly("sum_ns", &HistogramSnapshot::sum_ns)
+        .def_readonly("min_ns", &HistogramSnapshot::min_ns)
+        .def_readonly("max_ns", &HistogramSnapshot::max_ns)
+        .def_readonly("mean_ns", &HistogramSnapshot::mean_ns)
+        .def_readonly("p50_ns", &HistogramSnapshot::p50_ns)
+        .def_readonly("p90_ns", &HistogramSnapshot::p90_ns)
+        .def_readonly("p99_ns", &HistogramSnapshot::p99_ns)
+        .def_readonly("buckets", &HistogramSnapshot::buckets);
+
+    py::class_<MetricsSnapshot>(m, "MetricsSnapshot")
+        .def_readonly("timers", &MetricsSnapshot::timers)
+        .def_readonly("counters", &MetricsSnapshot::counters);
+    m.def("get_metrics_snapshot", &get_metrics_snapshot);
+    m.def("reset_metrics", &reset_metrics);
+    m.def("set_metrics_enabled", &set_metrics_enabled);
+    m.def("get_metrics_enabled", &get_metrics_enabled);
+
+    m.def("encode_qoi", py::overload_cast<const Image&>(&encode_qoi), py::arg("image"));
+    m.def("decode_qoi", py::overload_cast<const Image&>(&decode_qoi), py::arg("encoded"));
+    m.def("decode_qoi", [](const py::bytes& data) {
+        const std::string_view view(data);
+        return decode_qoi(reinterpret_cast<const unsigned char*>(view.data()), view.size());
+    }, py::arg("data"));
+    m.def("load_qoi", &load_qoi, py::arg("file_path"));
+
+    // Threads used by large image operations, counting the calling thread.
+    m.def("set_image_threads", [](const unsigned int count) {
+        ImageThreadPool::instance().set_thread_count(count);
+    });
+    m.def("get_image_threads", [] {
+        return ImageThreadPool::instance().get_thread_count();
+    });
+    m.def("set_image_min_parallel_bytes", [](const size_t bytes) {
+        ImageThreadPool::instance().set_min_parallel_bytes(bytes);
+    });
+    m.def("get_image_min_parallel_bytes", [] {
+        return ImageThreadPool::instance().get_min_parallel_bytes();
+    });
 
     py::class_<MotorController>(m, "MotorController")
         .def(py::init<>())
+        .def(py::init([](const std::string& gpio_backend) {
+            return std::make_unique<MotorController>(make_gpio_backend(gpio_backend));
+        }), py::arg("gpio_backend"))
+        .def_static("simulated", [] {
+            return std::make_unique<MotorController>(std::make_unique<SimulatedGpioBackend>());
+        })
         .def("set_to_output_mode", &MotorController::set_to_output_mode)
         .def("cleanup", &MotorController::cleanup)
-        .def("rotate", &MotorController::rotate)
-        .def("set_pins", &MotorController::set_pins);
+        .def("rotate", &MotorController::rotate, py::call_guard<py::gil_scoped_release>())
+        .def("rotate_async", [](MotorController& self, const unsigned int degrees, const int direction) {
+            return self.rotate_async(degrees, direction).share();
+        })
+        .def("move_by", &MotorController::move_by, py::call_guard<py::gil_scoped_release>())
+        .def("move_by_async", [](MotorController& self, const double degrees) {
+            return self.move_by_async(degrees).share();
+        })
+        .def("move_to", &MotorController::move_to, py::call_guard<py::gil_scoped_release>())
+        .def("move_to_async", [](MotorController& self, const double angle) {
+            return self.move_to_async(angle).share();
+        })
+        .def("home", [](MotorController& self, const py::function& at_home, const unsigned int max_degrees,
+                        const int direction) {
+            py::gil_scoped_release release;
+            return self.home([&at_home] {
+                py::gil_scoped_acquire acquire;
+                return at_home().cast<bool>();
+            }, max_degrees, direction);
+        }, py::arg("at_home"), py::arg("max_degrees") = 360, py::arg("direction") = -1)
+        .def("set_home", &MotorController::set_home)
+        .def("get_angle", &MotorController::get_angle)
+        .def("set_position_file", &MotorController::set_position_file)
+        .def("save_position", &MotorController::save_position)
+        .def("load_position", &MotorController::load_position)
+        .def("stop", &MotorController::stop, py::call_guard<py::gil_scoped_release>())
+        .def("wait", &MotorController::wait, py::call_guard<py::gil_scoped_release>())
+        .def("is_moving", &MotorController::is_moving)
+        .def("get_position", &MotorController::get_position)
+        .def("set_pins", &MotorController::set_pins)
+        .def("set_drive_mode", &MotorController::set_drive_mode)
+        .def("get_drive_mode", &MotorController::get_drive_mode)
+        .def("set_motion_profile", &MotorController::set_motion_profile)
+        .def("get_motion_profile", &MotorController::get_motion_profile)
+        .def("get_jitter_stats", &MotorController::get_jitter_stats)
+        .def("reset_jitter_stats", &MotorController::reset_jitter_stats)
+        .def("get_is_realtime", &MotorController::get_is_realtime);
+
+    py::class_<AxisConfig>(m, "AxisConfig")
+        .def(py::init<>())
+        .def_readwrite("w_pi_pins", &AxisConfig::w_pi_pins)
+        .def_readwrite("steps_per_rev", &AxisConfig::steps_per_rev)
+        .def_readwrite("drive_mode", &AxisConfig::drive_mode);
+
+    py::class_<MultiAxisController>(m, "MultiAxisController")
+        .def(py::init([](const std::string& gpio_backend) {
+            return std::make_unique<MultiAxisController>(make_gpio_backend(gpio_backend));
+        }), py::arg("gpio_backend") = get_default_gpio_backend_name())
+        .def_static("simulated", [] {
+            return std::make_unique<MultiAxisController>(std::make_unique<SimulatedGpioBackend>());
+        })
+        .def("add_axis", &MultiAxisController::add_axis)
+        .def("get_axis_count", &MultiAxisController::get_axis_count)
+        .def("set_to_output_mode", &MultiAxisController::set_to_output_mode)
+        .def("cleanup", &MultiAxisController::cleanup, py::call_guard<py::gil_scoped_release>())
+        .def("move_linear", &MultiAxisController::move_linear, py::call_guard<py::gil_scoped_release>())
+        .def("move_linear_async", [](const MultiAxisController& self, const std::vector<double>& degrees) {
+            return self.move_linear_async(degrees).share();
+        })
+        .def("stop", &MultiAxisController::stop, py::call_guard<py::gil_scoped_release>())
+        .def("wait", &MultiAxisController::wait, py::call_guard<py::gil_scoped_release>())
+        .def("is_moving", &MultiAxisController::is_moving)
+        .def("get_position", &MultiAxisController::get_position)
+        .def("get_positions", &MultiAxisController::get_positions)
+        .def("set_motion_profile", &MultiAxisController::set_motion_profile)
+        .def("get_motion_profile", &MultiAxisController::get_motion_profile);
+
+    py::class_<ScanConfig>(m, "ScanConfig")
+        .def(py::init<>())
+        .def_readwrite("settle_ms", &ScanConfig::settle_ms)
+        .def_readwrite("output_format", &ScanConfig::output_format)
+        .def_readwrite("output_dir", &ScanConfig::output_dir);
 
     py::class_<HardwareController>(m, "HardwareController")
         .def(py::init<>())
-        .def("initialize_all", &HardwareController::initialize_all)
+        .def("initialize_all", py::overload_cast<>(&HardwareController::initialize_all))
+        .def("initialize_all", [](HardwareController& self, const std::string& camera_backend,
+                                  const std::string& gpio_backend) {
+            self.initialize_all(make_camera_backend(camera_backend), make_gpio_backend(gpio_backend));
+        }, py::arg("camera_backend"), py::arg("gpio_backend"))
+        .def("initialize_simulated", [](HardwareController& self) {
+            self.initialize_all(std::make_unique<SimulatedCameraBackend>(), std::make_unique<SimulatedGpioBackend>());
+        })
+        .def("scan", [](HardwareController& self, const std::vector<double>& angles, const ScanConfig& scan_config) {
+            py::gil_scoped_release release;
+            return self.scan(angles, scan_config);
+        }, py::arg("angles"), py::arg("scan_config") = ScanConfig())
+        .def("scan", [](HardwareController& self, const std::vector<double>& angles, const ScanConfig& scan_config,
+                        const py::function& on_frame) {
+            py::gil_scoped_release release;
+            self.scan(angles, scan_config, [&on_frame](Image& frame) {
+                py::gil_scoped_acquire acquire;
+                // Hand Python its own image, sharing the buffer, since the frame goes away after this.
+                on_frame(Image(frame));
+            });
+        })
         .def("cleanup_all", &HardwareController::cleanup_all)
         .def_readwrite("camera_controller", &HardwareController::camera_controller)
         .def_readwrite("motor_controller", &HardwareController::motor_controller);
@@ -0,0 +1,50 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <cstdlib>
+#include <stdexcept>
+#include "camera_backend.h"
+#include "simulated_camera_backend.h"
+#ifdef RASPI_HW_HAVE_RASPICAM
+#include "raspicam_backend.h"
+#endif
+
+#ifndef RASPI_HW_DEFAULT_CAMERA
+#define RASPI_HW_DEFAULT_CAMERA "simulated"
+#endif
+
+using namespace std;
+
+/**
+ * Create a camera backend by name. The simulated camera waits
+ * RASPI_HW_CAMERA_LATENCY_US microseconds per capture if it is set.
+ *
+ * @param name raspicam or simulated.
+ * @return The backend, not opened yet.
+ * @throws std::invalid_argument if the name is unknown or the backend was not built.
+ */
+unique_ptr<CameraBackend> make_camera_backend(const string& name) {
+    if (name == "raspicam") {
+#ifdef RASPI_HW_HAVE_RASPICAM
+        return make_unique<RaspiCamBackend>();
+#else
+        throw invalid_argument("Built without raspicam. Use simulated instead.");
+#endif
+    }
+    if (name == "simulated") {
+        const char* latency = getenv("RASPI_HW_CAMERA_LATENCY_US");
+        return make_unique<SimulatedCameraBackend>(latency != nullptr ? strtoul(latency, nullptr, 10) : 0);
+    }
+    throw invalid_argument("Use raspicam or simulated instead.");
+}
+
+/**
+ * Get the camera backend used when none is given. RASPI_HW_CAMERA
+ * overrides the one chosen at build time.
+ *
+ * @return The backend name.
+ */
+string get_default_camera_backend_name() {
+    const char* name = getenv("RASPI_HW_CAMERA");
+    return name != nullptr && *name != '\0' ? name : RASPI_HW_DEFAULT_CAMERA;
+}
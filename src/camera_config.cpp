@@ -1,8 +1,11 @@
 //
 // Created by Joe Pettinelli on 2/17/25.
 //
+#include <stdexcept>
 #include "camera_config.h"
 
+using namespace std;
+
 /**
  * Github: https://github.com/cedricve/raspicam/blob/master/src/raspicam_still.cpp
  */
@@ -14,6 +17,30 @@ CameraConfig::CameraConfig()
       iso(700), // 100 - 800
       image_width(320), // Should be multiple of 320
       image_height(240),  // make multiple of 240
-      encoding("png")
+      encoding(PixelFormat::png)
 {
 }
+
+/**
+ * Check that every setting is in the range the camera takes, so a bad
+ * profile fails when it is added instead of when it is used.
+ *
+ * @param config The settings.
+ * @throws std::invalid_argument if a setting is out of range or the
+ *         encoding is not png, jpeg, or rgb.
+ */
+void check_camera_config(const CameraConfig& config) {
+    if (config.image_width == 0 || config.image_height == 0) {
+        throw invalid_argument("Image width and height must be positive.");
+    }
+    if (config.sharpness < -100 || config.sharpness > 100 || config.contrast < -100 || config.contrast > 100 ||
+        config.saturation < -100 || config.saturation > 100 || config.brightness > 100) {
+        throw invalid_argument("Use -100 - 100 for sharpness, contrast, saturation and 0 - 100 for brightness.");
+    }
+    if (config.iso < 100 || config.iso > 800) {
+        throw invalid_argument("Use an iso of 100 - 800.");
+    }
+    if (!pixel_format_info(config.encoding).camera_output) {
+        throw invalid_argument("Use png, jpeg, or rgb instead.");
+    }
+}
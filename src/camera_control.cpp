@@ -1,66 +1,248 @@
 //
 // Created by Joe Pettinelli on 2/17/25.
 //
-#include <iostream>
-#include "raspicam/raspicam_still.h"
+#include <chrono>
+#include <stdexcept>
 #include "camera_control.h"
+#include "frame_buffer_pool.h"
+#include "logger.h"
+#include "metrics.h"
 #include "image.h"
 
 using namespace std;
 
 /**
  * Initialize the camera configuration once at beginning
- * of the program and open the camera.
+ * of the program using the default camera backend, the raspberry
+ * pi camera unless the build or RASPI_HW_CAMERA says otherwise.
  */
-CameraController::CameraController() {
-    camera.setWidth(config.image_width);
-    camera.setHeight(config.image_height);
-    camera.setSharpness(config.sharpness);
-    camera.setContrast(config.contrast);
-    camera.setBrightness(config.brightness);
-    camera.setSaturation(config.saturation);
-    camera.setISO(config.iso);
-    camera.setEncoding(raspicam::RASPICAM_ENCODING_PNG);
-    camera.setExposure(raspicam::RASPICAM_EXPOSURE_AUTO);
-    cout << "Initialize camera success." << endl;
+CameraController::CameraController() : CameraController(make_camera_backend(get_default_camera_backend_name())) {
+}
+
+/**
+ * Initialize the camera configuration once at beginning
+ * of the program using the given camera backend.
+ *
+ * @param backend The camera device to capture from.
+ */
+CameraController::CameraController(std::unique_ptr<CameraBackend> backend)
+    : camera(std::move(backend)), is_open(false), first_frame_start_ns(0) {
+    apply_config(config, true);
+    camera->set_exposure_auto();
+    RASPI_HW_LOG_INFO("Initialize camera success.");
 }
 
 /**
  * Open the camera. Should not be called until user sets
- * desired image width, height, and encoding.
+ * desired image width, height, and encoding, or picks a profile.
  */
 void CameraController::open_camera() {
-    if (camera.open()) {
-        cout << "Camera open success." << endl;
+    ScopedLatency latency(MetricTimer::camera_open);
+    first_frame_start_ns = monotonic_now_ns();
+    is_open = camera->open();
+    if (is_open) {
+        RASPI_HW_LOG_INFO("Camera open success.");
     } else {
-        cout << "Camera open failed." << endl;
+        first_frame_start_ns = 0;
+        RASPI_HW_LOG_ERROR("Camera open failed.");
     }
 }
 
 /**
- * Capture data for image using raspberry pi camera.
+ * Capture data for image using raspberry pi camera. The camera writes
+ * straight into the buffer owned by the returned image.
  *
  * @return The 1D bytes representing the image + the header + padding which
  *          changes depending on the encoding being used. png is RGBA
  *          and jpeg is RGB.
  */
 Image CameraController::capture_image() {
-    cout << "Take single image." << endl;
+    RASPI_HW_LOG_DEBUG("Take single image.");
     // size is Header + Image Data + Padding
-    const unsigned int size = camera.getImageBufferSize();
-    const auto data = new unsigned char[size];
-    camera.grab_retrieve(data, size);
-    Image image(data, size, config.image_width, config.image_height, config.encoding, true);
-    delete[] data;
+    const size_t size = camera->get_image_buffer_size();
+    Image image(size, config.image_width, config.image_height, config.encoding, true);
+    if (!grab_frame(image.get_data(), size)) {
+        RASPI_HW_LOG_WARN("Capture image failed.");
+    }
     return image;
 }
 
+/**
+ * Capture data into an existing image. The image buffer is reused
+ * when it is big enough, so capturing repeatedly into the same image
+ * does not allocate.
+ *
+ * @param image The image to fill.
+ * @return true if the capture succeeded, else false.
+ */
+bool CameraController::capture_image(Image& image) {
+    const size_t size = camera->get_image_buffer_size();
+    image.reset(size, config.image_width, config.image_height, config.encoding, true);
+    return grab_frame(image.get_data(), size);
+}
+
+/**
+ * Capture data into a caller provided buffer.
+ *
+ * @param buffer The buffer to fill.
+ * @param buffer_size The size of the buffer. Must be at least get_image_buffer_size().
+ * @return true if the capture succeeded, else false.
+ */
+bool CameraController::capture_image(unsigned char* buffer, const size_t buffer_size) {
+    const size_t size = camera->get_image_buffer_size();
+    if (buffer == nullptr || buffer_size < size) {
+        RASPI_HW_LOG_WARN("Abort capture: Buffer is too small.");
+        return false;
+    }
+    return grab_frame(buffer, size);
+}
+
+/**
+ * Capture several frames back to back into one buffer.
+ *
+ * @param count The number of frames.
+ * @param lock_exposure true to hold the exposure and white balance of the first frame for the rest.
+ * @return The burst. Holds fewer than count frames if a capture failed.
+ * @throws std::invalid_argument if count is 0.
+ */
+FrameBurst CameraController::capture_burst(const size_t count, const bool lock_exposure) {
+    FrameBurst burst;
+    capture_burst(count, burst, lock_exposure);
+    return burst;
+}
+
+/**
+ * Capture several frames back to back into one contiguous buffer,
+ * without logging or allocating between frames. The buffer comes from
+ * the frame buffer pool, and the buffer of the last burst is reused
+ * when nothing else holds it, so repeated bursts do not allocate. With
+ * lock_exposure, the exposure and white balance are held after the
+ * first frame so the rest match it, then set back to auto.
+ *
+ * @param count The number of frames.
+ * @param burst The burst to fill. Its old frames are dropped.
+ * @param lock_exposure true to hold the exposure and white balance of the first frame for the rest.
+ * @return true if all frames were captured, else false with the frames captured so far.
+ * @throws std::invalid_argument if count is 0.
+ */
+bool CameraController::capture_burst(const size_t count, FrameBurst& burst, const bool lock_exposure) {
+    if (count == 0) {
+        throw std::invalid_argument("Burst needs at least one frame.");
+    }
+    const size_t size = camera->get_image_buffer_size();
+    burst.frames.clear();
+    if (burst.buffer == nullptr || burst.buffer.use_count() != 1 || burst.capacity < count * size) {
+        burst.buffer = FrameBufferPool::instance().acquire(count * size);
+        burst.capacity = count * size;
+    }
+    burst.frame_stride = size;
+    burst.frames.reserve(count);
+    bool locked = false;
+    for (size_t i = 0; i < count; ++i) {
+        unsigned char* frame_data = burst.buffer.get() + i * size;
+        if (!grab_frame(frame_data, size)) {
+            RASPI_HW_LOG_WARN("Abort burst: Capture of frame " << i << " failed.");
+            break;
+        }
+        const auto now = chrono::steady_clock::now().time_since_epoch();
+        Image frame(std::shared_ptr<unsigned char>(burst.buffer, frame_data), size, config.image_width,
+                    config.image_height, config.encoding, true);
+        frame.set_frame_info({i, chrono::duration_cast<chrono::nanoseconds>(now).count()});
+        burst.frames.push_back(std::move(frame));
+        if (i == 0 && lock_exposure && count > 1) {
+            camera->set_exposure_locked(true);
+            locked = true;
+        }
+    }
+    if (locked) {
+        camera->set_exposure_locked(false);
+    }
+    return burst.frames.size() == count;
+}
+
+/**
+ * Capture into a buffer and record the capture time and result.
+ *
+ * @param data The buffer to fill.
+ * @param size The size of the capture.
+ * @return true if the capture succeeded, else false.
+ */
+bool CameraController::grab_frame(unsigned char* data, const size_t size) {
+    ScopedLatency latency(MetricTimer::capture);
+    const bool captured = camera->grab_retrieve(data, size);
+    add_to_counter(captured ? MetricCounter::frames_captured : MetricCounter::capture_failures);
+    if (captured && first_frame_start_ns != 0) {
+        record_latency(MetricTimer::first_frame, monotonic_now_ns() - first_frame_start_ns);
+        first_frame_start_ns = 0;
+    }
+    return captured;
+}
+
+/**
+ * Send the camera the settings that differ from the current ones.
+ *
+ * @param new_config The settings to use. Should already be checked.
+ * @param apply_all true to send every setting, even unchanged ones.
+ * @return true if the width, height, or encoding changed, which the
+ *         camera only picks up when it is opened again.
+ */
+bool CameraController::apply_config(const CameraConfig& new_config, const bool apply_all) {
+    bool format_changed = apply_all;
+    if (apply_all || new_config.image_width != config.image_width) {
+        camera->set_width(new_config.image_width);
+        format_changed = true;
+    }
+    if (apply_all || new_config.image_height != config.image_height) {
+        camera->set_height(new_config.image_height);
+        format_changed = true;
+    }
+    if (apply_all || new_config.sharpness != config.sharpness) {
+        camera->set_sharpness(new_config.sharpness);
+    }
+    if (apply_all || new_config.contrast != config.contrast) {
+        camera->set_contrast(new_config.contrast);
+    }
+    if (apply_all || new_config.brightness != config.brightness) {
+        camera->set_brightness(new_config.brightness);
+    }
+    if (apply_all || new_config.saturation != config.saturation) {
+        camera->set_saturation(new_config.saturation);
+    }
+    if (apply_all || new_config.iso != config.iso) {
+        camera->set_iso(new_config.iso);
+    }
+    if (apply_all || new_config.encoding != config.encoding) {
+        camera->set_encoding(new_config.encoding);
+        format_changed = true;
+    }
+    config = new_config;
+    return format_changed;
+}
+
+/**
+ * Release and open the camera so it picks up a new width, height, or
+ * encoding.
+ *
+ * @return true if the camera opened again, else false.
+ */
+bool CameraController::reopen() {
+    ScopedLatency latency(MetricTimer::camera_open);
+    camera->release();
+    is_open = camera->open();
+    if (!is_open) {
+        RASPI_HW_LOG_ERROR("Camera reopen failed.");
+    }
+    return is_open;
+}
+
 /**
  * After done using the camera, release it.
  */
 void CameraController::release_camera() {
-    camera.release();
-    cout << "Cleanup camera success." << endl;
+    is_open = false;
+    first_frame_start_ns = 0;
+    camera->release();
+    RASPI_HW_LOG_INFO("Cleanup camera success.");
 }
 
 /**
@@ -70,7 +252,8 @@ void CameraController::release_camera() {
  */
 void CameraController::set_image_width(const unsigned int new_width) {
     config.image_width = new_width;
-    camera.setWidth(new_width);
+    profile_name.clear();
+    camera->set_width(new_width);
 }
 
 /**
@@ -80,7 +263,8 @@ void CameraController::set_image_width(const unsigned int new_width) {
  */
 void CameraController::set_image_height(const unsigned int new_height) {
     config.image_height = new_height;
-    camera.setHeight(new_height);
+    profile_name.clear();
+    camera->set_height(new_height);
 }
 
 /**
@@ -89,16 +273,22 @@ void CameraController::set_image_height(const unsigned int new_height) {
  * @param new_encoding The new image encoding. Only allow png, jpeg, or rgb.
  */
 void CameraController::set_image_encoding(const std::string& new_encoding) {
-    if (new_encoding == "png") {
-        camera.setEncoding(raspicam::RASPICAM_ENCODING_PNG);
-    } else if (new_encoding == "jpeg") {
-        camera.setEncoding(raspicam::RASPICAM_ENCODING_JPEG);
-    } else if (new_encoding == "rgb") {
-        camera.setEncoding(raspicam::RASPICAM_ENCODING_RGB);
-    } else {
+    PixelFormat format;
+    if (!pixel_format_from_name(new_encoding, format)) {
         throw std::invalid_argument("Use png, jpeg, or rgb instead.");
     }
+    set_image_encoding(format);
+}
+
+/**
+ * Set the image encoding.
+ *
+ * @param new_encoding The new image encoding. Only allow png, jpeg, or rgb.
+ */
+void CameraController::set_image_encoding(const PixelFormat new_encoding) {
+    camera->set_encoding(new_encoding);
     config.encoding = new_encoding;
+    profile_name.clear();
 }
 
 /**
@@ -125,5 +315,169 @@ unsigned int CameraController::get_image_height() const {
  * @return The image encoding. Should only be png, jpeg, or rgb.
  */
 std::string CameraController::get_image_encoding() const {
+    return pixel_format_name(config.encoding);
+}
+
+/**
+ * Get the current image encoding.
+ *
+ * @return The pixel format. Should only be png, jpeg, or rgb.
+ */
+PixelFormat CameraController::get_image_format() const {
     return config.encoding;
 }
+
+/**
+ * Get the buffer size needed to capture one image with the
+ * current configuration.
+ *
+ * @return Header + Image Data + Padding in bytes.
+ */
+size_t CameraController::get_image_buffer_size() const {
+    return camera->get_image_buffer_size();
+}
+
+/**
+ * Get all current camera settings.
+ *
+ * @return The settings.
+ */
+const CameraConfig& CameraController::get_config() const {
+    return config;
+}
+
+/**
+ * Get whether the camera is open.
+ *
+ * @return true if the last open succeeded and the camera was not released since, else false.
+ */
+bool CameraController::get_is_open() const {
+    return is_open;
+}
+
+/**
+ * Add or replace a named profile. The settings are checked and the
+ * capture buffer size worked out now, and buffers of that size are put
+ * in the frame buffer pool so the first captures after a switch do not
+ * allocate.
+ *
+ * @param name The profile name, for example preview or full.
+ * @param profile_config The settings of the profile.
+ * @param prewarm_count The number of capture buffers to keep ready, 0 for none.
+ * @throws std::invalid_argument if the name is empty or a setting is out of range.
+ */
+void CameraController::add_profile(const std::string& name, const CameraConfig& profile_config,
+                                   const size_t prewarm_count) {
+    if (name.empty()) {
+        throw std::invalid_argument("Camera profile name must not be empty.");
+    }
+    check_camera_config(profile_config);
+    const size_t buffer_size =
+        camera->get_image_buffer_size(profile_config.image_width, profile_config.image_height, profile_config.encoding);
+    FrameBufferPool::instance().reserve(buffer_size, prewarm_count);
+    profiles[name] = Profile{profile_config, buffer_size};
+    if (name == profile_name) {
+        // The camera still has the old settings until the profile is used again.
+        profile_name.clear();
+    }
+}
+
+/**
+ * Remove a named profile. The camera keeps its current settings.
+ *
+ * @param name The profile name.
+ * @throws std::invalid_argument if there is no profile with that name.
+ */
+void CameraController::remove_profile(const std::string& name) {
+    if (profiles.erase(name) == 0) {
+        throw std::invalid_argument("No camera profile named " + name + ".");
+    }
+    if (name == profile_name) {
+        profile_name.clear();
+    }
+}
+
+/**
+ * Switch to a named profile. Only settings that differ from the current
+ * ones are sent to the camera, and an open camera is only reopened when
+ * the width, height, or encoding changes. Switching to the profile in
+ * use does nothing. The next capture is timed as the first frame.
+ *
+ * @param name The profile name.
+ * @return true if the camera is ready to capture with the profile, else
+ *         false when reopening failed.
+ * @throws std::invalid_argument if there is no profile with that name.
+ */
+bool CameraController::use_profile(const std::string& name) {
+    const auto found = profiles.find(name);
+    if (found == profiles.end()) {
+        throw std::invalid_argument("No camera profile named " + name + ".");
+    }
+    if (name == profile_name) {
+        return true;
+    }
+    ScopedLatency latency(MetricTimer::camera_switch);
+    const int64_t start_ns = monotonic_now_ns();
+    const bool format_changed = apply_config(found->second.config, false);
+    profile_name = name;
+    RASPI_HW_LOG_DEBUG("Switch to camera profile " << name << (format_changed && is_open ? ", reopening." : "."));
+    if (!is_open) {
+        return true;
+    }
+    if (format_changed && !reopen()) {
+        first_frame_start_ns = 0;
+        return false;
+    }
+    first_frame_start_ns = start_ns;
+    return true;
+}
+
+/**
+ * Get whether a named profile exists.
+ *
+ * @param name The profile name.
+ * @return true if it exists, else false.
+ */
+bool CameraController::has_profile(const std::string& name) const {
+    return profiles.count(name) != 0;
+}
+
+/**
+ * Get the names of all profiles.
+ *
+ * @return The names, sorted.
+ */
+std::vector<std::string> CameraController::get_profile_names() const {
+    std::vector<std::string> names;
+    names.reserve(profiles.size());
+    for (const auto& [name, profile] : profiles) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+/**
+ * Get the buffer size one capture with a profile needs, for callers
+ * that capture into their own buffers.
+ *
+ * @param name The profile name.
+ * @return Header + Image Data + Padding in bytes.
+ * @throws std::invalid_argument if there is no profile with that name.
+ */
+size_t CameraController::get_profile_buffer_size(const std::string& name) const {
+    const auto found = profiles.find(name);
+    if (found == profiles.end()) {
+        throw std::invalid_argument("No camera profile named " + name + ".");
+    }
+    return found->second.buffer_size;
+}
+
+/**
+ * Get the profile in use.
+ *
+ * @return The profile name, or empty if no profile was used or a
+ *         setting was changed since.
+ */
+std::string CameraController::get_profile_name() const {
+    return profile_name;
+}
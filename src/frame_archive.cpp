@@ -0,0 +1,257 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "frame_archive.h"
+#include "logger.h"
+
+using namespace std;
+
+namespace {
+
+constexpr char archive_magic[8] = {'R', 'H', 'W', 'F', 'A', 'R', 'C', '1'};
+constexpr uint32_t archive_version = 1;
+constexpr uint64_t frame_alignment = 4096;
+
+uint64_t align_up(const uint64_t value) {
+    return (value + frame_alignment - 1) / frame_alignment * frame_alignment;
+}
+
+/**
+ * Write the whole buffer at the given offset, retrying short writes.
+ *
+ * @return true if every byte was written, else false.
+ */
+bool pwrite_all(const int fd, const void* buffer, size_t length, off_t offset) {
+    auto bytes = static_cast<const unsigned char*>(buffer);
+    while (length > 0) {
+        const ssize_t written = pwrite(fd, bytes, length, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += written;
+        length -= static_cast<size_t>(written);
+        offset += written;
+    }
+    return true;
+}
+
+}
+
+/**
+ * Create a new archive, replacing any file at the path. The index
+ * is sized for capacity frames up front.
+ *
+ * @param file_path The path of the archive file.
+ * @param capacity The most frames the archive can hold.
+ * @throws std::runtime_error if the file cannot be created.
+ */
+FrameArchiveWriter::FrameArchiveWriter(const string& file_path, const uint32_t capacity) : header{} {
+    fd = open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw runtime_error("Failed to create frame archive " + file_path + ": " + strerror(errno));
+    }
+    memcpy(header.magic, archive_magic, sizeof(archive_magic));
+    header.version = archive_version;
+    header.capacity = capacity;
+    header.index_offset = sizeof(FrameArchiveHeader);
+    header.data_offset = align_up(header.index_offset + static_cast<uint64_t>(capacity) * sizeof(FrameArchiveEntry));
+    header.data_end = header.data_offset;
+    if (ftruncate(fd, static_cast<off_t>(header.data_offset)) != 0 || !pwrite_all(fd, &header, sizeof(header), 0)) {
+        ::close(fd);
+        throw runtime_error("Failed to write frame archive header " + file_path);
+    }
+}
+
+/**
+ * Close the archive file.
+ */
+FrameArchiveWriter::~FrameArchiveWriter() {
+    close();
+}
+
+/**
+ * Append a frame. The pixel data is written straight from the image
+ * buffer, then its index entry, then the new frame count.
+ *
+ * @param image The frame to append.
+ * @return true if appended, false if the archive is full, closed, or the write failed.
+ */
+bool FrameArchiveWriter::append(const Image& frame) {
+    // Crop views are packed first so the archive holds one block of pixels.
+    const Image image = frame.is_contiguous() ? frame : frame.clone();
+    lock_guard lock(mutex);
+    if (fd < 0 || header.frame_count >= header.capacity) {
+        return false;
+    }
+    const FrameInfo& info = image.get_frame_info();
+    FrameArchiveEntry entry{};
+    entry.offset = header.data_end;
+    entry.size = image.get_size();
+    entry.width = image.get_width();
+    entry.height = image.get_height();
+    entry.format = static_cast<uint8_t>(image.get_format());
+    entry.has_header = image.get_has_header();
+    entry.has_motor_position = info.has_motor_position;
+    entry.sequence = info.sequence;
+    entry.timestamp_ns = info.timestamp_ns;
+    entry.motor_position = info.motor_position;
+    const off_t entry_offset = static_cast<off_t>(header.index_offset + header.frame_count * sizeof(entry));
+    if (!pwrite_all(fd, image.get_data(), entry.size, static_cast<off_t>(entry.offset)) ||
+        !pwrite_all(fd, &entry, sizeof(entry), entry_offset)) {
+        return false;
+    }
+    FrameArchiveHeader updated = header;
+    updated.frame_count += 1;
+    updated.data_end = align_up(entry.offset + entry.size);
+    if (!pwrite_all(fd, &updated, sizeof(updated), 0)) {
+        return false;
+    }
+    header = updated;
+    return true;
+}
+
+/**
+ * Pad the file to the end of the last frame and close it.
+ * Appending after this fails.
+ */
+void FrameArchiveWriter::close() {
+    lock_guard lock(mutex);
+    if (fd < 0) {
+        return;
+    }
+    if (ftruncate(fd, static_cast<off_t>(header.data_end)) != 0) {
+        // Only padding is missing, the frames and index are already written.
+        RASPI_HW_LOG_WARN("Failed to pad frame archive: " << strerror(errno));
+    }
+    ::close(fd);
+    fd = -1;
+}
+
+/**
+ * Get the number of frames written.
+ *
+ * @return The frame count.
+ */
+uint64_t FrameArchiveWriter::get_frame_count() const {
+    lock_guard lock(mutex);
+    return header.frame_count;
+}
+
+/**
+ * Get the most frames the archive can hold.
+ *
+ * @return The capacity.
+ */
+uint32_t FrameArchiveWriter::get_capacity() const {
+    return header.capacity;
+}
+
+/**
+ * Owns the mapping of the archive file.
+ */
+struct FrameArchiveReader::Mapping {
+    unsigned char* address = nullptr;
+    size_t length = 0;
+
+    ~Mapping() {
+        if (address != nullptr) {
+            munmap(address, length);
+        }
+    }
+};
+
+/**
+ * Map an archive and check its header and index.
+ *
+ * @param file_path The path of the archive file.
+ * @throws std::runtime_error if the file cannot be mapped or is not a valid archive.
+ */
+FrameArchiveReader::FrameArchiveReader(const string& file_path) : mapping(make_shared<Mapping>()) {
+    const int fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw runtime_error("Failed to open frame archive " + file_path + ": " + strerror(errno));
+    }
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(FrameArchiveHeader)) {
+        ::close(fd);
+        throw runtime_error("Frame archive is too small: " + file_path);
+    }
+    mapping->length = static_cast<size_t>(file_stat.st_size);
+    // Private and writable so frames can be changed in memory without touching the file.
+    void* address = mmap(nullptr, mapping->length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        throw runtime_error("Failed to map frame archive " + file_path + ": " + strerror(errno));
+    }
+    mapping->address = static_cast<unsigned char*>(address);
+    header = reinterpret_cast<const FrameArchiveHeader*>(mapping->address);
+    if (memcmp(header->magic, archive_magic, sizeof(archive_magic)) != 0 || header->version != archive_version) {
+        throw runtime_error("Not a frame archive: " + file_path);
+    }
+    const uint64_t index_end = header->index_offset + static_cast<uint64_t>(header->capacity) * sizeof(FrameArchiveEntry);
+    if (index_end > mapping->length || header->frame_count > header->capacity) {
+        throw runtime_error("Frame archive index is truncated: " + file_path);
+    }
+    index = reinterpret_cast<const FrameArchiveEntry*>(mapping->address + header->index_offset);
+    // Only count valid frames whose data is fully inside the file.
+    frame_count = 0;
+    while (frame_count < header->frame_count &&
+           index[frame_count].offset + index[frame_count].size <= mapping->length &&
+           index[frame_count].format <= static_cast<uint8_t>(PixelFormat::qoi)) {
+        ++frame_count;
+    }
+}
+
+/**
+ * Get the number of complete frames in the archive.
+ *
+ * @return The frame count.
+ */
+uint64_t FrameArchiveReader::get_frame_count() const {
+    return frame_count;
+}
+
+/**
+ * Get the index entry of a frame.
+ *
+ * @param index The frame index.
+ * @return The entry.
+ * @throws std::out_of_range if the index is past the last frame.
+ */
+const FrameArchiveEntry& FrameArchiveReader::get_entry(const uint64_t index) const {
+    if (index >= frame_count) {
+        throw out_of_range("Frame index out of range.");
+    }
+    return this->index[index];
+}
+
+/**
+ * Get a frame as an image pointing into the mapping.
+ *
+ * @param index The frame index.
+ * @return The frame. Keeps the mapping alive.
+ * @throws std::out_of_range if the index is past the last frame.
+ */
+Image FrameArchiveReader::get_frame(const uint64_t index) const {
+    const FrameArchiveEntry& entry = get_entry(index);
+    shared_ptr<unsigned char> frame_data(mapping, mapping->address + entry.offset);
+    Image frame(std::move(frame_data), entry.size, entry.width, entry.height, static_cast<PixelFormat>(entry.format),
+                entry.has_header != 0);
+    FrameInfo info;
+    info.sequence = entry.sequence;
+    info.timestamp_ns = entry.timestamp_ns;
+    info.motor_position = entry.motor_position;
+    info.has_motor_position = entry.has_motor_position != 0;
+    frame.set_frame_info(info);
+    return frame;
+}
@@ -0,0 +1,253 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <new>
+#include "frame_buffer_pool.h"
+#include "metrics.h"
+
+namespace {
+// Page alignment so frames start aligned for SIMD loads and can be
+// written with O_DIRECT without a bounce buffer.
+constexpr std::align_val_t buffer_alignment{4096};
+}
+
+/**
+ * Start with empty slabs. Keep up to 8 free buffers per size, enough
+ * for a capture loop plus a few frames waiting to be saved, and up to
+ * 256 MiB of free buffers in all, which holds eight full resolution
+ * RGB frames from the v2 camera and leaves most of a Pi's memory free.
+ */
+FrameBufferPool::FrameBufferPool() : max_free_per_size(8), max_free_bytes(size_t{256} << 20), use_clock(0), stats{} {
+}
+
+/**
+ * Get the pool shared by all images. It is never destroyed so buffers
+ * released during static destruction still have a pool to return to.
+ *
+ * @return The pool.
+ */
+FrameBufferPool& FrameBufferPool::instance() {
+    static auto* pool = new FrameBufferPool();
+    return *pool;
+}
+
+/**
+ * Get a buffer of the given size. A free buffer of the same size is reused
+ * when there is one, otherwise a new one is allocated. The buffer goes back
+ * to the pool when the last owner lets go of it. A slab is dropped once
+ * its last free buffer is taken.
+ *
+ * @param size The size of the buffer in bytes.
+ * @return The shared buffer, or nullptr if size is 0.
+ */
+std::shared_ptr<unsigned char> FrameBufferPool::acquire(const size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+    unsigned char* buffer = nullptr;
+    {
+        std::lock_guard lock(mutex);
+        const auto slab = free_buffers.find(size);
+        if (slab != free_buffers.end()) {
+            buffer = slab->second.buffers.back();
+            slab->second.buffers.pop_back();
+            slab->second.last_used = ++use_clock;
+            if (slab->second.buffers.empty()) {
+                free_buffers.erase(slab);
+            }
+            stats.bytes_pooled -= size;
+            ++stats.hits;
+        } else {
+            ++stats.misses;
+            stats.bytes_allocated += size;
+        }
+    }
+    if (buffer == nullptr) {
+        buffer = allocate(size);
+    }
+    return {buffer, [this, size](unsigned char* released) { release(released, size); }};
+}
+
+/**
+ * Allocate free buffers ahead of time so the first captures at a
+ * new resolution are pool hits. Older slabs are freed if the new
+ * buffers take the pool over its byte cap.
+ *
+ * @param size The size of each buffer in bytes.
+ * @param count The number of free buffers wanted for this size.
+ */
+void FrameBufferPool::reserve(const size_t size, const size_t count) {
+    if (size == 0 || count == 0) {
+        return;
+    }
+    std::lock_guard lock(mutex);
+    Slab& slab = free_buffers[size];
+    slab.last_used = ++use_clock;
+    while (slab.buffers.size() < count) {
+        slab.buffers.push_back(allocate(size));
+        stats.bytes_allocated += size;
+        stats.bytes_pooled += size;
+    }
+    evict_locked(size);
+}
+
+/**
+ * Free every buffer currently in the pool. Buffers still owned
+ * by images are not affected.
+ */
+void FrameBufferPool::clear() {
+    std::lock_guard lock(mutex);
+    for (auto& [size, slab] : free_buffers) {
+        for (unsigned char* buffer : slab.buffers) {
+            deallocate(buffer);
+            ++stats.frees;
+        }
+        stats.bytes_pooled -= size * slab.buffers.size();
+        stats.bytes_allocated -= size * slab.buffers.size();
+    }
+    free_buffers.clear();
+}
+
+/**
+ * Set how many free buffers of one size the pool keeps. Extra
+ * buffers are freed when released.
+ *
+ * @param new_max_free The maximum number of free buffers per size.
+ */
+void FrameBufferPool::set_max_free_per_size(const size_t new_max_free) {
+    std::lock_guard lock(mutex);
+    max_free_per_size = new_max_free;
+}
+
+/**
+ * Get how many free buffers of one size the pool keeps.
+ *
+ * @return The maximum number of free buffers per size.
+ */
+size_t FrameBufferPool::get_max_free_per_size() const {
+    std::lock_guard lock(mutex);
+    return max_free_per_size;
+}
+
+/**
+ * Set how many bytes of free buffers the pool keeps across all sizes.
+ * Least recently used slabs are freed right away to get under it.
+ *
+ * @param new_max_free_bytes The maximum bytes of free buffers.
+ */
+void FrameBufferPool::set_max_free_bytes(const size_t new_max_free_bytes) {
+    std::lock_guard lock(mutex);
+    max_free_bytes = new_max_free_bytes;
+    evict_locked(0);
+}
+
+/**
+ * Get how many bytes of free buffers the pool keeps across all sizes.
+ *
+ * @return The maximum bytes of free buffers.
+ */
+size_t FrameBufferPool::get_max_free_bytes() const {
+    std::lock_guard lock(mutex);
+    return max_free_bytes;
+}
+
+/**
+ * Get the pool counters.
+ *
+ * @return A copy of the counters.
+ */
+FrameBufferPoolStats FrameBufferPool::get_stats() const {
+    std::lock_guard lock(mutex);
+    return stats;
+}
+
+/**
+ * Reset the hit, miss, release and free counters. Byte counts
+ * describe current memory so they are kept.
+ */
+void FrameBufferPool::reset_stats() {
+    std::lock_guard lock(mutex);
+    stats.hits = 0;
+    stats.misses = 0;
+    stats.releases = 0;
+    stats.frees = 0;
+}
+
+/**
+ * Take a buffer back from its last owner. Keep it for reuse unless
+ * the slab is full or the buffer alone is over the byte cap. Keeping
+ * it can free least recently used slabs to stay under the cap.
+ *
+ * @param buffer The buffer.
+ * @param size The size of the buffer in bytes.
+ */
+void FrameBufferPool::release(unsigned char* buffer, const size_t size) {
+    {
+        std::lock_guard lock(mutex);
+        ++stats.releases;
+        const auto slab = free_buffers.find(size);
+        const size_t free_count = slab == free_buffers.end() ? 0 : slab->second.buffers.size();
+        if (free_count < max_free_per_size && size <= max_free_bytes) {
+            Slab& kept = free_buffers[size];
+            kept.buffers.push_back(buffer);
+            kept.last_used = ++use_clock;
+            stats.bytes_pooled += size;
+            evict_locked(size);
+            return;
+        }
+        ++stats.frees;
+        stats.bytes_allocated -= size;
+    }
+    deallocate(buffer);
+}
+
+/**
+ * Free buffers until the pool is under its byte cap, taking them from
+ * the least recently used slab first. The slab of keep_size goes last,
+ * since it was just used. The lock must be held.
+ *
+ * @param keep_size The size of the slab to keep if possible, or 0.
+ */
+void FrameBufferPool::evict_locked(const size_t keep_size) {
+    while (stats.bytes_pooled > max_free_bytes && !free_buffers.empty()) {
+        auto oldest = free_buffers.end();
+        for (auto slab = free_buffers.begin(); slab != free_buffers.end(); ++slab) {
+            if (slab->first != keep_size &&
+                (oldest == free_buffers.end() || slab->second.last_used < oldest->second.last_used)) {
+                oldest = slab;
+            }
+        }
+        if (oldest == free_buffers.end()) {
+            oldest = free_buffers.find(keep_size);
+        }
+        const size_t size = oldest->first;
+        deallocate(oldest->second.buffers.back());
+        oldest->second.buffers.pop_back();
+        if (oldest->second.buffers.empty()) {
+            free_buffers.erase(oldest);
+        }
+        ++stats.frees;
+        stats.bytes_pooled -= size;
+        stats.bytes_allocated -= size;
+    }
+}
+
+/**
+ * Allocate an aligned buffer.
+ *
+ * @param size The size of the buffer in bytes.
+ * @return The buffer.
+ */
+unsigned char* FrameBufferPool::allocate(const size_t size) {
+    add_to_counter(MetricCounter::allocated_bytes, size);
+    return static_cast<unsigned char*>(::operator new(size, buffer_alignment));
+}
+
+/**
+ * Free a buffer made by allocate().
+ *
+ * @param buffer The buffer.
+ */
+void FrameBufferPool::deallocate(unsigned char* buffer) {
+    ::operator delete(buffer, buffer_alignment);
+}
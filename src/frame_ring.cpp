@@ -0,0 +1,233 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "frame_buffer_pool.h"
+#include "frame_ring.h"
+#include "metrics.h"
+
+using namespace std;
+
+/**
+ * Allocate every frame up front so nothing is allocated while streaming.
+ *
+ * @param slot_count The number of frames the ring holds. At least 2.
+ * @param frame_size The size of one frame in bytes.
+ * @param policy What to do with new frames when the ring is full.
+ */
+FrameRing::FrameRing(const size_t slot_count, const size_t frame_size, const DropPolicy policy)
+    : slot_count(slot_count), frame_size(frame_size), policy(policy), head(0), tail(0), dropped(0) {
+    if (slot_count < 2) {
+        throw invalid_argument("Frame ring needs at least 2 slots.");
+    }
+    slots = make_unique<Slot[]>(slot_count);
+    for (size_t i = 0; i < slot_count; ++i) {
+        slots[i].buffer = FrameBufferPool::instance().acquire(frame_size);
+        attach_buffer(slots[i]);
+    }
+}
+
+/**
+ * Get the frame to write the next capture into. Must be followed by
+ * commit_write() before the next call. Producer only.
+ *
+ * @return The frame to fill, or nullptr if the ring is full and the new frame should be dropped.
+ */
+Image* FrameRing::begin_write() {
+    const uint64_t position = head.load(memory_order_relaxed);
+    if (policy == DropPolicy::drop_newest && position - tail.load(memory_order_acquire) >= slot_count) {
+        dropped.fetch_add(1, memory_order_relaxed);
+        add_to_counter(MetricCounter::frames_dropped);
+        return nullptr;
+    }
+    Slot& slot = slots[position % slot_count];
+    // Odd version marks the slot as being written.
+    slot.version.store(2 * position + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return &slot.frame;
+}
+
+/**
+ * Publish the frame returned by begin_write(). A frame that was given a
+ * buffer of its own, for example because it outgrew the slot, is copied
+ * into the slot buffer if it fits and dropped if not. Producer only.
+ */
+void FrameRing::commit_write() {
+    const uint64_t position = head.load(memory_order_relaxed);
+    Slot& slot = slots[position % slot_count];
+    Image& frame = slot.frame;
+    if (frame.get_data() != slot.buffer.get()) {
+        const bool fits = frame.is_contiguous() && frame.get_size() <= frame_size;
+        if (fits) {
+            memcpy(slot.buffer.get(), frame.get_data(), frame.get_size());
+        }
+        const Image copied = frame;
+        attach_buffer(slot);
+        if (!fits) {
+            dropped.fetch_add(1, memory_order_relaxed);
+            add_to_counter(MetricCounter::frames_dropped);
+            abort_write();
+            return;
+        }
+        frame.reset(copied.get_size(), copied.get_width(), copied.get_height(), copied.get_format(),
+                    copied.get_has_header());
+        frame.set_frame_info(copied.get_frame_info());
+    }
+    slot.info = {frame.get_size(), frame.get_width(), frame.get_height(), frame.get_format(),
+                 frame.get_has_header(), frame.get_frame_info()};
+    slot.version.store(2 * position + 2, memory_order_release);
+    head.store(position + 1, memory_order_release);
+}
+
+/**
+ * Give up on the frame returned by begin_write(), for example when the
+ * capture failed. Nothing is published. The frame that was in the slot
+ * may be partly overwritten, so the slot gets a version no readable
+ * position expects rather than its old one. Producer only.
+ */
+void FrameRing::abort_write() {
+    const uint64_t position = head.load(memory_order_relaxed);
+    slots[position % slot_count].version.store(2 * position + 2, memory_order_release);
+}
+
+/**
+ * Copy the oldest unread frame out of the ring. Consumer only.
+ *
+ * @param frame The image to copy into. Its buffer is reused when big enough.
+ * @return true if a frame was copied, false if there was nothing to read.
+ */
+bool FrameRing::pop_next(Image& frame) {
+    while (true) {
+        const uint64_t written = head.load(memory_order_acquire);
+        uint64_t position = tail.load(memory_order_relaxed);
+        if (position == written) {
+            return false;
+        }
+        if (written - position > slot_count) {
+            // The producer lapped the consumer, skip to the oldest frame still in the ring.
+            dropped.fetch_add(written - position - slot_count, memory_order_relaxed);
+            add_to_counter(MetricCounter::frames_dropped, written - position - slot_count);
+            position = written - slot_count;
+        }
+        if (read_slot(position, frame)) {
+            tail.store(position + 1, memory_order_release);
+            return true;
+        }
+        dropped.fetch_add(1, memory_order_relaxed);
+        add_to_counter(MetricCounter::frames_dropped);
+        tail.store(position + 1, memory_order_release);
+    }
+}
+
+/**
+ * Copy the newest frame out of the ring and mark every older
+ * frame as read. Consumer only.
+ *
+ * @param frame The image to copy into. Its buffer is reused when big enough.
+ * @return true if a frame was copied, false if there was nothing new to read.
+ */
+bool FrameRing::pop_latest(Image& frame) {
+    while (true) {
+        const uint64_t written = head.load(memory_order_acquire);
+        const uint64_t position = tail.load(memory_order_relaxed);
+        if (position == written) {
+            return false;
+        }
+        // Frames skipped to get to the newest one are not dropped, the consumer chose to skip them.
+        if (read_slot(written - 1, frame)) {
+            tail.store(written, memory_order_release);
+            return true;
+        }
+    }
+}
+
+/**
+ * Get the number of slots.
+ *
+ * @return The slot count.
+ */
+size_t FrameRing::get_slot_count() const {
+    return slot_count;
+}
+
+/**
+ * Get the policy for new frames when the ring is full.
+ *
+ * @return The drop policy.
+ */
+DropPolicy FrameRing::get_drop_policy() const {
+    return policy;
+}
+
+/**
+ * Get the number of frames written so far.
+ *
+ * @return The written count.
+ */
+uint64_t FrameRing::get_written_count() const {
+    return head.load(memory_order_acquire);
+}
+
+/**
+ * Get the number of frames lost because the ring was full.
+ *
+ * @return The dropped count.
+ */
+uint64_t FrameRing::get_dropped_count() const {
+    return dropped.load(memory_order_relaxed);
+}
+
+/**
+ * Get the number of unread frames still in the ring.
+ *
+ * @return The number of unread frames.
+ */
+size_t FrameRing::get_available() const {
+    const uint64_t written = head.load(memory_order_acquire);
+    const uint64_t position = tail.load(memory_order_acquire);
+    return static_cast<size_t>(min<uint64_t>(written - position, slot_count));
+}
+
+/**
+ * Point the producer image of a slot at the slot buffer. The image gets
+ * its own non-owning reference, so it is not shared and reset() keeps
+ * the buffer.
+ *
+ * @param slot The slot.
+ */
+void FrameRing::attach_buffer(Slot& slot) const {
+    slot.frame = Image(shared_ptr<unsigned char>(slot.buffer.get(), [](unsigned char*) {}), frame_size, 0, 0,
+                       PixelFormat::none, false);
+}
+
+/**
+ * Copy the frame at the given position out of its slot. Fails if
+ * the producer is writing or has overwritten the slot. Only the slot
+ * info and buffer are read, never the producer image, and a torn copy
+ * is thrown away by the version check.
+ *
+ * @param position The position of the frame.
+ * @param frame The image to copy into.
+ * @return true if the copy holds the frame at position, else false.
+ */
+bool FrameRing::read_slot(const uint64_t position, Image& frame) {
+    const Slot& slot = slots[position % slot_count];
+    const uint64_t expected_version = 2 * position + 2;
+    if (slot.version.load(memory_order_acquire) != expected_version) {
+        return false;
+    }
+    const SlotInfo info = slot.info;
+    const size_t size = min(info.size, frame_size);
+    frame.reset(size, info.width, info.height, info.format, info.has_header);
+    if (size > 0) {
+        memcpy(frame.get_data(), slot.buffer.get(), size);
+    }
+    atomic_thread_fence(memory_order_acquire);
+    if (slot.version.load(memory_order_relaxed) != expected_version) {
+        return false;
+    }
+    frame.set_frame_info(info.frame_info);
+    return true;
+}
@@ -0,0 +1,82 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <cstring>
+#include <thread>
+#include "frame_source.h"
+#include "camera_control.h"
+
+using namespace std;
+
+/**
+ * Stream from the given camera controller.
+ *
+ * @param camera_controller The opened camera controller.
+ */
+CameraFrameSource::CameraFrameSource(CameraController& camera_controller) : camera_controller(camera_controller) {
+}
+
+/**
+ * Get the size of one capture with the current camera configuration.
+ *
+ * @return The frame size in bytes.
+ */
+size_t CameraFrameSource::get_frame_size() const {
+    return camera_controller.get_image_buffer_size();
+}
+
+/**
+ * Capture one frame straight into the given image.
+ *
+ * @param frame The image to fill.
+ * @return true if the capture succeeded, else false.
+ */
+bool CameraFrameSource::read_frame(Image& frame) {
+    return camera_controller.capture_image(frame);
+}
+
+/**
+ * Produce rgb frames with the raspicam layout, width*height*3 bytes
+ * followed by the 54 byte header.
+ *
+ * @param width The frame width.
+ * @param height The frame height.
+ * @param frame_interval_us The time between frames in microseconds. 0 produces frames as fast as possible.
+ */
+SyntheticFrameSource::SyntheticFrameSource(const unsigned int width, const unsigned int height,
+                                           const unsigned int frame_interval_us)
+    : width(width), height(height), frame_interval(frame_interval_us),
+      next_frame_time(chrono::steady_clock::now()), frame_count(0) {
+}
+
+/**
+ * Get the size of one synthetic frame.
+ *
+ * @return width*height*3+54 bytes.
+ */
+size_t SyntheticFrameSource::get_frame_size() const {
+    return static_cast<size_t>(width) * height * 3 + 54;
+}
+
+/**
+ * Wait for the next frame time and fill the image. Each row is a
+ * single value that changes with the frame count, so a frame can be
+ * recognised from any of its rows.
+ *
+ * @param frame The image to fill.
+ * @return true.
+ */
+bool SyntheticFrameSource::read_frame(Image& frame) {
+    if (frame_interval.count() > 0) {
+        this_thread::sleep_until(next_frame_time);
+        next_frame_time += frame_interval;
+    }
+    frame.reset(get_frame_size(), width, height, PixelFormat::rgb, true);
+    const size_t row_size = static_cast<size_t>(width) * 3;
+    for (size_t row = 0; row < height; ++row) {
+        memset(frame.get_data() + row * row_size, static_cast<unsigned char>(frame_count + row), row_size);
+    }
+    memset(frame.get_data() + row_size * height, 0, 54);
+    ++frame_count;
+    return true;
+}
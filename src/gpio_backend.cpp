@@ -0,0 +1,96 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <cstdlib>
+#include <stdexcept>
+#include "gpio_backend.h"
+#include "gpio_chardev_backend.h"
+#include "gpiomem_backend.h"
+#include "simulated_gpio_backend.h"
+#ifdef RASPI_HW_HAVE_WIRINGPI
+#include "wiringpi_backend.h"
+#endif
+
+#ifndef RASPI_HW_DEFAULT_GPIO
+#define RASPI_HW_DEFAULT_GPIO "simulated"
+#endif
+
+using namespace std;
+
+/**
+ * Set several pins with one write per pin. Backends that can set
+ * many pins in one device call override this.
+ *
+ * @param pins The pins to write.
+ * @param count The number of pins, at most 32.
+ * @param levels Bit i is the level for pins[i].
+ */
+void GpioBackend::write_outputs(const unsigned int* pins, const size_t count, const uint32_t levels) {
+    for (size_t i = 0; i < count; ++i) {
+        write(pins[i], ((levels >> i) & 1) != 0);
+    }
+}
+
+/**
+ * Get whether a wiringPi pin is on the 40 pin header. Motors check
+ * their pins with this when the pins are set, so a bad pin fails on
+ * the caller's thread instead of on the motion thread.
+ *
+ * @param pin The wiringPi pin number.
+ * @return true if the pin has a BCM number, else false.
+ */
+bool is_wiringpi_pin(const unsigned int pin) {
+    return pin < size(wiringpi_to_bcm_table);
+}
+
+/**
+ * Get the BCM number of a wiringPi pin.
+ *
+ * @param pin The wiringPi pin number.
+ * @return The BCM GPIO number.
+ * @throws std::invalid_argument if the pin has no BCM number.
+ */
+unsigned int wiringpi_to_bcm(const unsigned int pin) {
+    if (!is_wiringpi_pin(pin)) {
+        throw invalid_argument("wiringPi pin has no BCM number.");
+    }
+    return wiringpi_to_bcm_table[pin];
+}
+
+/**
+ * Create a GPIO backend by name.
+ *
+ * @param name wiringpi, chardev, gpiomem, or simulated.
+ * @return The backend, not set up yet.
+ * @throws std::invalid_argument if the name is unknown or the backend was not built.
+ */
+unique_ptr<GpioBackend> make_gpio_backend(const string& name) {
+    if (name == "wiringpi") {
+#ifdef RASPI_HW_HAVE_WIRINGPI
+        return make_unique<WiringPiBackend>();
+#else
+        throw invalid_argument("Built without wiringPi. Use chardev, gpiomem, or simulated instead.");
+#endif
+    }
+    if (name == "chardev") {
+        return make_unique<GpioChardevBackend>();
+    }
+    if (name == "gpiomem") {
+        return make_unique<GpioMemBackend>();
+    }
+    if (name == "simulated") {
+        return make_unique<SimulatedGpioBackend>();
+    }
+    throw invalid_argument("Use wiringpi, chardev, gpiomem, or simulated instead.");
+}
+
+/**
+ * Get the GPIO backend used when none is given. RASPI_HW_GPIO
+ * overrides the one chosen at build time.
+ *
+ * @return The backend name.
+ */
+string get_default_gpio_backend_name() {
+    const char* name = getenv("RASPI_HW_GPIO");
+    return name != nullptr && *name != '\0' ? name : RASPI_HW_DEFAULT_GPIO;
+}
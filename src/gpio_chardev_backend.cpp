@@ -0,0 +1,191 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include "gpio_chardev_backend.h"
+#include "logger.h"
+
+using namespace std;
+
+namespace {
+
+constexpr char consumer_name[] = "raspi_hw_ctrl";
+
+}
+
+/**
+ * Keep the chip path until setup().
+ *
+ * @param chip_path The GPIO chip with the header pins. /dev/gpiochip0 on
+ *                  most Pis, /dev/gpiochip4 on a Pi 5 with an older kernel.
+ */
+GpioChardevBackend::GpioChardevBackend(string chip_path)
+    : chip_path(std::move(chip_path)), chip_fd(-1), request_fd(-1), write_error_reported(false) {
+    line_index.fill(-1);
+}
+
+/**
+ * Release the lines and close the chip.
+ */
+GpioChardevBackend::~GpioChardevBackend() {
+    if (request_fd >= 0) {
+        close(request_fd);
+    }
+    if (chip_fd >= 0) {
+        close(chip_fd);
+    }
+}
+
+/**
+ * Open the GPIO chip.
+ *
+ * @return true if the chip opened, else false.
+ */
+bool GpioChardevBackend::setup() {
+    if (chip_fd < 0) {
+        chip_fd = open(chip_path.c_str(), O_RDWR | O_CLOEXEC);
+    }
+    return chip_fd >= 0;
+}
+
+/**
+ * Set a pin to input or output mode. Output pins are requested
+ * again as one group each time the set changes.
+ *
+ * @param pin The wiringPi pin number.
+ * @param mode The pin mode.
+ */
+void GpioChardevBackend::set_mode(const unsigned int pin, const PinMode mode) {
+    const unsigned int line = wiringpi_to_bcm(pin);
+    const auto found = find(output_lines.begin(), output_lines.end(), line);
+    bool ok = true;
+    if (mode == PinMode::output && found == output_lines.end()) {
+        output_lines.push_back(line);
+        ok = request_outputs();
+    } else if (mode == PinMode::input) {
+        if (found != output_lines.end()) {
+            output_lines.erase(found);
+            ok = request_outputs();
+        }
+        ok = request_input(line) && ok;
+    }
+    if (!ok) {
+        RASPI_HW_LOG_ERROR("Set GPIO line " << line << " mode failed.");
+    }
+}
+
+/**
+ * Drive an output pin high or low.
+ *
+ * @param pin The wiringPi pin number.
+ * @param level true for high, false for low.
+ */
+void GpioChardevBackend::write(const unsigned int pin, const bool level) {
+    write_outputs(&pin, 1, level ? 1 : 0);
+}
+
+/**
+ * Set several output pins with one ioctl. Pins that are not
+ * outputs are skipped.
+ *
+ * @param pins The wiringPi pins to write.
+ * @param count The number of pins, at most 32.
+ * @param levels Bit i is the level for pins[i].
+ */
+void GpioChardevBackend::write_outputs(const unsigned int* pins, const size_t count, const uint32_t levels) {
+    uint64_t bits = 0;
+    uint64_t mask = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned int line = wiringpi_to_bcm(pins[i]);
+        const int index = line < max_lines ? line_index[line] : -1;
+        if (index < 0) {
+            continue;
+        }
+        mask |= uint64_t{1} << index;
+        if ((levels >> i) & 1) {
+            bits |= uint64_t{1} << index;
+        }
+    }
+    if (mask != 0) {
+        set_values(bits, mask);
+    }
+}
+
+/**
+ * Request every output line in one line request, replacing the
+ * previous request. Lines start low.
+ *
+ * @return true if requested, else false.
+ */
+bool GpioChardevBackend::request_outputs() {
+    if (request_fd >= 0) {
+        close(request_fd);
+        request_fd = -1;
+    }
+    line_index.fill(-1);
+    if (output_lines.empty()) {
+        return true;
+    }
+    if (chip_fd < 0 || output_lines.size() > GPIO_V2_LINES_MAX) {
+        return false;
+    }
+    gpio_v2_line_request request{};
+    for (size_t i = 0; i < output_lines.size(); ++i) {
+        request.offsets[i] = output_lines[i];
+        if (output_lines[i] < max_lines) {
+            line_index[output_lines[i]] = static_cast<int>(i);
+        }
+    }
+    request.num_lines = static_cast<uint32_t>(output_lines.size());
+    request.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+    strncpy(request.consumer, consumer_name, sizeof(request.consumer) - 1);
+    if (ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &request) < 0) {
+        line_index.fill(-1);
+        return false;
+    }
+    request_fd = request.fd;
+    return true;
+}
+
+/**
+ * Switch a line to input, then give it back to the kernel.
+ *
+ * @param line The BCM line number.
+ * @return true if switched, else false.
+ */
+bool GpioChardevBackend::request_input(const unsigned int line) {
+    if (chip_fd < 0) {
+        return false;
+    }
+    gpio_v2_line_request request{};
+    request.offsets[0] = line;
+    request.num_lines = 1;
+    request.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+    strncpy(request.consumer, consumer_name, sizeof(request.consumer) - 1);
+    if (ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &request) < 0) {
+        return false;
+    }
+    close(request.fd);
+    return true;
+}
+
+/**
+ * Set the masked lines of the output request in one ioctl.
+ *
+ * @param bits The level of each line, by index in the request.
+ * @param mask The lines to set.
+ */
+void GpioChardevBackend::set_values(const uint64_t bits, const uint64_t mask) {
+    gpio_v2_line_values values{};
+    values.bits = bits;
+    values.mask = mask;
+    if (ioctl(request_fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0 && !write_error_reported) {
+        write_error_reported = true;
+        RASPI_HW_LOG_ERROR("GPIO chardev write failed.");
+    }
+}
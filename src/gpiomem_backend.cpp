@@ -0,0 +1,121 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "gpiomem_backend.h"
+
+using namespace std;
+
+namespace {
+
+// Register offsets in 32 bit words from the GPIO base.
+constexpr size_t gpfsel0 = 0x00 / 4;
+constexpr size_t gpset0 = 0x1c / 4;
+constexpr size_t gpclr0 = 0x28 / 4;
+constexpr size_t block_size = 4096;
+
+}
+
+/**
+ * Keep the device path until setup().
+ *
+ * @param device_path The GPIO register device.
+ */
+GpioMemBackend::GpioMemBackend(string device_path) : device_path(std::move(device_path)), registers(nullptr) {
+}
+
+/**
+ * Unmap the registers.
+ */
+GpioMemBackend::~GpioMemBackend() {
+    if (registers != nullptr) {
+        munmap(const_cast<uint32_t*>(registers), block_size);
+    }
+}
+
+/**
+ * Map the GPIO registers.
+ *
+ * @return true if mapped, else false.
+ */
+bool GpioMemBackend::setup() {
+    if (registers != nullptr) {
+        return true;
+    }
+    const int fd = open(device_path.c_str(), O_RDWR | O_SYNC | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    void* address = mmap(nullptr, block_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    registers = static_cast<volatile uint32_t*>(address);
+    return true;
+}
+
+/**
+ * Set a pin to input or output mode with its 3 bit function select field.
+ *
+ * @param pin The wiringPi pin number.
+ * @param mode The pin mode.
+ */
+void GpioMemBackend::set_mode(const unsigned int pin, const PinMode mode) {
+    if (registers == nullptr) {
+        return;
+    }
+    const unsigned int bcm = wiringpi_to_bcm(pin);
+    const unsigned int shift = (bcm % 10) * 3;
+    volatile uint32_t& select = registers[gpfsel0 + bcm / 10];
+    uint32_t value = select & ~(7u << shift);
+    if (mode == PinMode::output) {
+        value |= 1u << shift;
+    }
+    select = value;
+}
+
+/**
+ * Drive an output pin high or low.
+ *
+ * @param pin The wiringPi pin number.
+ * @param level true for high, false for low.
+ */
+void GpioMemBackend::write(const unsigned int pin, const bool level) {
+    if (registers == nullptr) {
+        return;
+    }
+    registers[level ? gpset0 : gpclr0] = 1u << wiringpi_to_bcm(pin);
+}
+
+/**
+ * Set several pins with one store to the set register and one to the
+ * clear register. Header pins are all in the first bank.
+ *
+ * @param pins The wiringPi pins to write.
+ * @param count The number of pins, at most 32.
+ * @param levels Bit i is the level for pins[i].
+ */
+void GpioMemBackend::write_outputs(const unsigned int* pins, const size_t count, const uint32_t levels) {
+    if (registers == nullptr) {
+        return;
+    }
+    uint32_t set_bits = 0;
+    uint32_t clear_bits = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t bit = 1u << wiringpi_to_bcm(pins[i]);
+        if ((levels >> i) & 1) {
+            set_bits |= bit;
+        } else {
+            clear_bits |= bit;
+        }
+    }
+    if (set_bits != 0) {
+        registers[gpset0] = set_bits;
+    }
+    if (clear_bits != 0) {
+        registers[gpclr0] = clear_bits;
+    }
+}
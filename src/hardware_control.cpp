@@ -1,9 +1,17 @@
 //
 // Created by Joe Pettinelli on 2/18/25.
 //
+#include <chrono>
+#include <cstdio>
+#include <thread>
 #include "hardware_control.h"
+#include "logger.h"
 #include "camera_control.h"
+#include "image_writer.h"
 #include "motor_control.h"
+#include "qoi_codec.h"
+
+using namespace std;
 
 /**
  * Use nullptr until camera controller and motor controller are initialized.
@@ -30,6 +38,22 @@ void HardwareController::initialize_all() {
     }
 }
 
+/**
+ * Initialize camera and motor on the given backends, for example
+ * simulated ones, then set initialized to true.
+ *
+ * @param camera_backend The camera device.
+ * @param gpio_backend The GPIO device driving the motor.
+ */
+void HardwareController::initialize_all(unique_ptr<CameraBackend> camera_backend,
+                                        unique_ptr<GpioBackend> gpio_backend) {
+    if (!initialized) {
+        camera_controller = new CameraController(std::move(camera_backend));
+        motor_controller = new MotorController(std::move(gpio_backend));
+        initialized = true;
+    }
+}
+
 /**
  * Clean up camera and motor then set initialized to false.
  */
@@ -46,3 +70,96 @@ void HardwareController::cleanup_all() {
     }
     initialized = false;
 }
+
+/**
+ * Capture a frame at each angle and return them all.
+ * See the streaming version for how the scan runs.
+ *
+ * @param angles The angles from home to capture at, in order.
+ * @param scan_config The settle time, output format and output directory.
+ * @return The frames, in angle order. Failed captures are left out.
+ */
+vector<Image> HardwareController::scan(const vector<double>& angles, const ScanConfig& scan_config) {
+    vector<Image> frames;
+    frames.reserve(angles.size());
+    scan(angles, scan_config, [&frames](Image& frame) {
+        frames.push_back(std::move(frame));
+    });
+    return frames;
+}
+
+/**
+ * Capture a frame at each angle and hand each one to a callback.
+ * The camera should already be open. The motor moves to each angle
+ * the shortest way round and settles before the capture. As soon as
+ * a frame is captured the move to the next angle starts, so converting,
+ * saving and the callback for that frame run while the motor moves.
+ * Saving happens on a writer thread. Each frame is tagged with its
+ * index, capture time and motor position.
+ *
+ * @param angles The angles from home to capture at, in order.
+ * @param scan_config The settle time, output format and output directory.
+ * @param on_frame Called on this thread for each captured frame.
+ */
+void HardwareController::scan(const vector<double>& angles, const ScanConfig& scan_config,
+                              const function<void(Image&)>& on_frame) {
+    if (!initialized) {
+        RASPI_HW_LOG_WARN("Abort scan: Hardware is not initialized.");
+        return;
+    }
+    if (angles.empty()) {
+        return;
+    }
+    unique_ptr<ImageWriter> writer;
+    if (!scan_config.output_dir.empty()) {
+        writer = make_unique<ImageWriter>();
+    }
+    future<bool> move = motor_controller->move_to_async(angles[0]);
+    for (size_t i = 0; i < angles.size(); ++i) {
+        if (!move.get()) {
+            RASPI_HW_LOG_WARN("Scan stopped: Motor move was stopped.");
+            break;
+        }
+        this_thread::sleep_for(chrono::milliseconds(scan_config.settle_ms));
+        FrameInfo info;
+        info.sequence = i;
+        info.timestamp_ns = chrono::duration_cast<chrono::nanoseconds>(
+            chrono::steady_clock::now().time_since_epoch()).count();
+        info.motor_position = motor_controller->get_position();
+        info.has_motor_position = true;
+        Image frame;
+        const bool captured = camera_controller->capture_image(frame);
+        if (i + 1 < angles.size()) {
+            move = motor_controller->move_to_async(angles[i + 1]);
+        }
+        if (!captured) {
+            RASPI_HW_LOG_WARN("Scan capture " << i << " failed.");
+            continue;
+        }
+        frame.set_frame_info(info);
+        // qoi frames stay raw here and are encoded on the writer thread.
+        const bool to_qoi = scan_config.output_format == PixelFormat::qoi;
+        if (to_qoi) {
+            if (frame.get_format() == PixelFormat::rgb) {
+                frame.remove_rgb_header();
+            }
+        } else if (scan_config.output_format != PixelFormat::none &&
+                   scan_config.output_format != frame.get_format()) {
+            frame.remove_rgb_header();
+            if (!frame.convert_to(scan_config.output_format)) {
+                RASPI_HW_LOG_WARN("Scan frame " << i << " kept as " << frame.get_encoding() << ".");
+            }
+        }
+        if (writer) {
+            // The writer shares the frame buffer, so this does not copy it.
+            char file_name[32];
+            snprintf(file_name, sizeof(file_name), "/scan_%04zu.", i);
+            const string extension = to_qoi && can_encode_qoi(frame) ? "qoi" : frame.get_encoding();
+            writer->save_async(frame, scan_config.output_dir + file_name + extension, nullptr);
+        }
+        on_frame(frame);
+    }
+    if (writer) {
+        writer->flush();
+    }
+}
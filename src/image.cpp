@@ -1,11 +1,17 @@
 //
 // Created by Joe Pettinelli on 2/17/25.
 //
-#include <iostream>
 #include <cstring>
+#include <stdexcept>
 #include "image.h"
+#include "frame_buffer_pool.h"
+#include "image_ops.h"
+#include "image_thread_pool.h"
+#include "logger.h"
+#include "metrics.h"
+#include "pixel_convert.h"
+#include "qoi_codec.h"
 #include <fstream>
-#include <algorithm>
 #include <cassert>
 
 using namespace std;
@@ -13,21 +19,34 @@ using namespace std;
 /**
  * The default constructor if no image data yet.
  */
-Image::Image() : data(nullptr), size(0), width(0), height(0), has_header(false) {}
+Image::Image() : data(nullptr), size(0), capacity(0), width(0), height(0), stride(0), format(PixelFormat::none),
+    has_header(false) {}
 
 /**
  * The constructor used when have image size, width and height
- * but do not have the data yet.
+ * but do not have the data yet. The buffer comes from the frame
+ * buffer pool and is left uninitialized so the camera can write
+ * straight into it.
  *
  * @param size The size of data buffer from raspicam getImageBufferSize().
  * @param width The image width.
  * @param height The image height.
- * @param encoding The image encoding.
+ * @param format The image encoding.
  * @param has_header Whether the image has header.
  */
+Image::Image(const size_t size, const unsigned int width, const unsigned int height, const PixelFormat format,
+             const bool has_header)
+    : data(FrameBufferPool::instance().acquire(size)), size(size), capacity(size), width(width), height(height),
+      stride(0), format(format), has_header(has_header) {}
+
+/**
+ * Same as above with the encoding given by name.
+ *
+ * @param encoding The image encoding name, e.g. "rgb".
+ */
 Image::Image(const size_t size, const unsigned int width, const unsigned int height,
-                     const std::string& encoding, bool has_header) // NOLINT(*-pass-by-value)
-    : data(nullptr), size(size), width(width), height(height), encoding(encoding), has_header(has_header) {}
+             const std::string& encoding, const bool has_header)
+    : Image(size, width, height, pixel_format_from_name(encoding), has_header) {}
 
 /**
  * The constructor used when have actual image data.
@@ -36,56 +55,66 @@ Image::Image(const size_t size, const unsigned int width, const unsigned int hei
  * @param size The size of data buffer from raspicam getImageBufferSize().
  * @param width The image width.
  * @param height The image height.
- * @param encoding The image encoding.
+ * @param format The image encoding.
  * @param has_header Whether the image has header.
  */
 Image::Image(const unsigned char* src_data, const size_t size, const unsigned int width,
-    const unsigned int height, const std::string&  encoding, bool has_header) : // NOLINT(*-pass-by-value)
-    size(size), width(width), height(height), encoding(encoding), has_header(has_header) {
-    data = new unsigned char[size];
-    memcpy(data, src_data, size);
+             const unsigned int height, const PixelFormat format, const bool has_header)
+    : Image(size, width, height, format, has_header) {
+    if (size > 0) {
+        memcpy(data.get(), src_data, size);
+    }
 }
 
 /**
- * The destructor.
+ * Same as above with the encoding given by name.
+ *
+ * @param encoding The image encoding name, e.g. "rgb".
  */
-Image::~Image() {
-    //cout << "Image memory freed." << endl << endl;
-    delete[] data;
-}
+Image::Image(const unsigned char* src_data, const size_t size, const unsigned int width,
+             const unsigned int height, const std::string& encoding, const bool has_header)
+    : Image(src_data, size, width, height, pixel_format_from_name(encoding), has_header) {}
+
+/**
+ * The constructor used to view memory owned by something else, like a
+ * memory mapped archive, without copying. The image keeps the owner
+ * alive and copies the data before changing pixels.
+ *
+ * @param shared_data The image data. Usually an aliasing pointer that shares ownership with the owner.
+ * @param size The size of the image data.
+ * @param width The image width.
+ * @param height The image height.
+ * @param format The image encoding.
+ * @param has_header Whether the image has header.
+ */
+Image::Image(std::shared_ptr<unsigned char> shared_data, const size_t size, const unsigned int width,
+             const unsigned int height, const PixelFormat format, const bool has_header)
+    : data(std::move(shared_data)), size(size), capacity(size), width(width), height(height), stride(0),
+      format(format), has_header(has_header) {}
 
 /**
- * Copy the constructor. Creates a new object as a copy of the
- * given object by performing a deep copy of its resources.
+ * The destructor. The buffer goes back to the pool once no other
+ * image shares it.
+ */
+Image::~Image() = default;
+
+/**
+ * Copy the constructor. The copy shares the buffer with the given
+ * object, so it is cheap. Operations that change pixels make their
+ * own copy of a shared buffer first.
  *
  * @param other The object to copy from.
  */
-Image::Image(const Image& other) : size(other.size), width(other.width), height(other.height),
-    encoding(other.encoding), has_header(other.has_header) {
-    data = new unsigned char[size];
-    memcpy(data, other.data, size);
-}
+Image::Image(const Image& other) = default;
 
 /**
- * Copy the assignment operator. Performs a deep copy of the
- * resources from the given object to this object.
+ * Copy the assignment operator. Shares the buffer of the given
+ * object and releases the current one.
  *
  * @param other The reference to other object to copy from.
  * @return The reference to this object after the copy.
  */
-Image& Image::operator=(const Image& other) {
-    if (this != &other) {
-        delete[] data;
-        size = other.size;
-        width = other.width;
-        height = other.height;
-        encoding = other.encoding;
-        has_header = other.has_header;
-        data = new unsigned char[size];
-        memcpy(data, other.data, size);
-    }
-    return *this;
-}
+Image& Image::operator=(const Image& other) = default;
 
 /**
  * Move constructor. Transfers ownership of resources from the given
@@ -94,14 +123,17 @@ Image& Image::operator=(const Image& other) {
  * @param other The rvalue reference whose resources will be moved.
  */
 Image::Image(Image&& other) noexcept
-    : data(other.data), size(other.size), width(other.width), height(other.height),
-    encoding(std::move(other.encoding)), has_header(other.has_header) {
-    other.data = nullptr;
+    : data(std::move(other.data)), size(other.size), capacity(other.capacity), width(other.width),
+    height(other.height), stride(other.stride), format(other.format), has_header(other.has_header),
+    info(other.info) {
     other.size = 0;
+    other.capacity = 0;
     other.width = 0;
     other.height = 0;
-    other.encoding = "";
+    other.stride = 0;
+    other.format = PixelFormat::none;
     other.has_header = false;
+    other.info = FrameInfo();
 }
 
 /**
@@ -113,30 +145,47 @@ Image::Image(Image&& other) noexcept
  */
 Image& Image::operator=(Image&& other) noexcept {
     if (this != &other) {
-        delete[] data;
-        data = other.data;
+        data = std::move(other.data);
         size = other.size;
+        capacity = other.capacity;
         width = other.width;
         height = other.height;
-        encoding = std::move(other.encoding);
+        stride = other.stride;
+        format = other.format;
         has_header = other.has_header;
+        info = other.info;
         other.data = nullptr;
         other.size = 0;
+        other.capacity = 0;
         other.width = 0;
         other.height = 0;
-        other.encoding = "";
+        other.stride = 0;
+        other.format = PixelFormat::none;
         other.has_header = false;
+        other.info = FrameInfo();
     }
     return *this;
 }
 
 /**
- * Getter function.
+ * Make a deep copy that does not share the buffer.
+ *
+ * @return The copy.
+ */
+Image Image::clone() const {
+    Image copy(*this);
+    copy.detach();
+    return copy;
+}
+
+/**
+ * Getter function. The data is shared with copies of this image,
+ * use clone() first when writing to it directly.
  *
  * @return The image data 1D.
  */
 unsigned char* Image::get_data() const {
-    return data;
+    return data.get();
 }
 
 /**
@@ -148,6 +197,65 @@ size_t Image::get_size() const {
     return size;
 }
 
+/**
+ * Getter function.
+ *
+ * @return The number of bytes allocated for image data.
+ */
+size_t Image::get_capacity() const {
+    return capacity;
+}
+
+/**
+ * Get whether other images share the buffer.
+ *
+ * @return true if the buffer is shared, else false.
+ */
+bool Image::is_shared() const {
+    return data.use_count() > 1;
+}
+
+/**
+ * Get the distance between the starts of two rows. Only crop views
+ * have rows further apart than the row size.
+ *
+ * @return The row stride in bytes, or 0 for encoded images.
+ */
+size_t Image::get_stride() const {
+    if (stride != 0) {
+        return stride;
+    }
+    return pixel_format_is_raw(format) ? pixel_format_row_size(format, width) : 0;
+}
+
+/**
+ * Get whether the image data is one packed block, so size bytes from
+ * get_data() are the whole image and nothing else.
+ *
+ * @return false for crop views narrower than their source, else true.
+ */
+bool Image::is_contiguous() const {
+    return stride == 0;
+}
+
+/**
+ * Get the frame sequence number and timestamp.
+ *
+ * @return The frame info.
+ */
+const FrameInfo& Image::get_frame_info() const {
+    return info;
+}
+
+/**
+ * Set the frame sequence number and timestamp.
+ *
+ * @param new_info The frame info.
+ */
+void Image::set_frame_info(const FrameInfo& new_info) {
+    info = new_info;
+}
+
 /**
  * Get the image width.
  *
@@ -167,12 +275,22 @@ unsigned int Image::get_height() const {
 }
 
 /**
- * Get the image encoding.
+ * Get the image encoding name. Kept for callers using strings,
+ * prefer get_format().
  *
  * @return The image encoding.
  */
 std::string Image::get_encoding() const {
-    return encoding;
+    return pixel_format_name(format);
+}
+
+/**
+ * Get the image encoding.
+ *
+ * @return The pixel format.
+ */
+PixelFormat Image::get_format() const {
+    return format;
 }
 
 /**
@@ -182,22 +300,73 @@ std::string Image::get_encoding() const {
  * @return true if the image has header, else false.
  */
 bool Image::get_has_header() const {
-    if (encoding != "rgb") {
+    if (!pixel_format_is_raw(format) && format != PixelFormat::none) {
         assert(has_header);
     }
     return has_header;
 }
 
+/**
+ * Prepare the image to receive new data of the given size. The current
+ * buffer is kept when it is big enough and not shared, so repeated captures
+ * into the same Image do not allocate. Old data is not preserved.
+ *
+ * @param new_size The size of the new data.
+ * @param new_width The image width.
+ * @param new_height The image height.
+ * @param new_format The image encoding.
+ * @param new_has_header Whether the image has header.
+ */
+void Image::reset(const size_t new_size, const unsigned int new_width, const unsigned int new_height,
+                  const PixelFormat new_format, const bool new_has_header) {
+    if (capacity < new_size || is_shared()) {
+        data = FrameBufferPool::instance().acquire(new_size);
+        capacity = new_size;
+    }
+    size = new_size;
+    width = new_width;
+    height = new_height;
+    stride = 0;
+    format = new_format;
+    has_header = new_has_header;
+}
+
+/**
+ * Copy the data and description of another image into this one.
+ * Unlike assignment the buffer is not shared, and the current buffer
+ * is reused when big enough.
+ *
+ * @param other The image to copy from.
+ */
+void Image::copy_from(const Image& other) {
+    if (this == &other) {
+        return;
+    }
+    if (!other.is_contiguous()) {
+        const size_t row_size = pixel_format_row_size(other.format, other.width);
+        reset(row_size * other.height, other.width, other.height, other.format, other.has_header);
+        copy_rows(other.data.get(), other.stride, data.get(), row_size, row_size, height);
+    } else {
+        reset(other.size, other.width, other.height, other.format, other.has_header);
+        if (size > 0) {
+            memcpy(data.get(), other.data.get(), size);
+        }
+    }
+    info = other.info;
+}
+
 /**
 * Save the image to disk. User is responsible for using correct
-* file extension in the file path.
+* file extension in the file path. rgb and rgba images saved to a
+* .qoi path are encoded losslessly while they are written.
 *
 * @param file_path The path to save the image data to.
 */
 bool Image::save(const std::string& file_path) const {
+    ScopedLatency latency(MetricTimer::save);
     try {
         if (data == nullptr || size == 0) {
-            cout << "Error: No data to save!" << endl;
+            RASPI_HW_LOG_WARN("Error: No data to save!");
             return false;
         }
         if (!check_save_extension(file_path)) {
@@ -205,13 +374,27 @@ bool Image::save(const std::string& file_path) const {
         }
         ofstream file (file_path, ios::binary);
         if (!file.is_open()) {
-            cout << "Failed to open file for writing!" << endl;
+            RASPI_HW_LOG_ERROR("Failed to open file for writing!");
             return false;
         }
-        file.write(reinterpret_cast<char *>(data), static_cast<std::streamsize>(size));
+        if (has_qoi_extension(file_path) && can_encode_qoi(*this)) {
+            return encode_qoi(*this, [&file](const unsigned char* chunk, const size_t length) {
+                return static_cast<bool>(file.write(reinterpret_cast<const char*>(chunk),
+                                                    static_cast<std::streamsize>(length)));
+            });
+        }
+        if (!is_contiguous()) {
+            const size_t row_size = pixel_format_row_size(format, width);
+            for (unsigned int row = 0; row < height; ++row) {
+                file.write(reinterpret_cast<char *>(data.get() + row * stride),
+                           static_cast<std::streamsize>(row_size));
+            }
+            return true;
+        }
+        file.write(reinterpret_cast<char *>(data.get()), static_cast<std::streamsize>(size));
         return true;
     } catch (const std::exception& e) {
-        cout << "Caught error: " << e.what() << endl;
+        RASPI_HW_LOG_ERROR("Caught error: " << e.what());
         return false;
     }
 }
@@ -220,105 +403,419 @@ bool Image::save(const std::string& file_path) const {
 * Remove the header that is 54 bytes added for images.
 * Should only be called when encoding is set to rgb.
 * The buffer size is calculated as width*height*3+54 by raspicam.
+* Only the size changes, the buffer is kept as is.
 */
 void Image::remove_rgb_header() {
-    if (encoding == "rgb") {
+    ScopedLatency latency(MetricTimer::header_strip);
+    if (format == PixelFormat::rgb) {
         if (has_header) {
-            if (data != nullptr && size > 54) {
+            constexpr size_t header_size = pixel_format_info(PixelFormat::rgb).header_size;
+            if (data != nullptr && size > header_size) {
                 // Remove the last 54 bytes
-                auto* new_data = new unsigned char[size - 54];
-                memcpy(new_data, data, size - 54);
-                delete[] data;
-                data = new_data;  // Point to the new buffer
-                size -= 54;
+                size -= header_size;
                 has_header = false;
                 return;
             }
-            cout << "Abort remove header: Data is too small or already null." << endl;
+            RASPI_HW_LOG_WARN("Abort remove header: Data is too small or already null.");
             return;
         }
-        cout << "Abort remove header: Header already removed." << endl;
+        RASPI_HW_LOG_WARN("Abort remove header: Header already removed.");
         return;
     }
-    cout << "Abort remove header: Should only remove header for rgb encoded images." << endl;
+    RASPI_HW_LOG_WARN("Abort remove header: Should only remove header for rgb encoded images.");
 }
 
 /**
  * Flip a rgb encoded image horizontally. Assumes header has
- * already been removed. Do this by flipping order of each row.
+ * already been removed. Do this by reversing the pixel order of
+ * each row in a single pass. Large images are split into bands
+ * of rows on the image thread pool.
+ *
+ * @param max_threads The most threads to use, 0 for the pool default, 1 for serial.
  */
-void Image::flip_rgb_h() const {
-    if (encoding != "rgb") {
-      cout << "Abort h flip: Can only flip rgb encoded images." << endl;
-      return;
+void Image::flip_rgb_h(const unsigned int max_threads) {
+    if (!check_rgb_transform("h flip", "flip")) {
+        return;
     }
-    if (has_header) {
-        cout << "Abort h flip: Should remove header first." << endl;
+    ScopedLatency latency(MetricTimer::flip);
+    detach();
+    const size_t row_stride = get_stride();
+    ImageThreadPool::instance().run(height, size, max_threads, [&](const size_t first_row, const size_t last_row) {
+        flip_rgb_h_kernel(data.get() + first_row * row_stride, width, last_row - first_row, row_stride);
+    });
+}
+
+/**
+ * Flip a rgb encoded image vertically.
+ * Do this by swapping entire rows. Large images are split into
+ * bands of row pairs on the image thread pool.
+ *
+ * @param max_threads The most threads to use, 0 for the pool default, 1 for serial.
+ */
+void Image::flip_rgb_v(const unsigned int max_threads) {
+    if (!check_rgb_transform("v flip", "flip")) {
         return;
     }
-    const size_t row_size = width * 3;  // Each row has width * 3 bytes (RGB)
-    const size_t num_rows = height;
-    // Iterate over each row of the image
-    for (size_t row = 0; row < num_rows; ++row) {
-        // Calculate the start index of the row in the 1D array
-        unsigned char* row_start = data + row * row_size;
-        std::reverse(row_start, row_start + row_size);
-        // Swap R and B channels or the image color will be BGR
-        if (row_size % 3 == 0) {
-            for (size_t i = 0; i < row_size; i +=3) {
-                std::swap(row_start[i], row_start[i + 2]);
-            }
-        }
+    ScopedLatency latency(MetricTimer::flip);
+    detach();
+    const size_t row_size = static_cast<size_t>(width) * 3;
+    const size_t row_stride = get_stride();
+    ImageThreadPool::instance().run(height / 2, size, max_threads, [&](const size_t first_pair,
+                                                                       const size_t last_pair) {
+        flip_rows_v_pairs_kernel(data.get(), row_size, height, row_stride, first_pair, last_pair);
+    });
+}
+
+/**
+ * Rotate a rgb encoded image by 180 degrees in place.
+ */
+void Image::rotate_rgb_180() {
+    if (!check_rgb_transform("rotate", "rotate")) {
+        return;
     }
+    detach();
+    rotate_rgb_180_kernel(data.get(), width, height, get_stride());
 }
 
 /**
- * Flip a rgb encoded image vertically.
- * Do this by swapping entire rows.
+ * Rotate a rgb encoded image by 90 degrees clockwise.
+ * Width and height are swapped.
  */
-void Image::flip_rgb_v() const {
-    if (encoding != "rgb") {
-        cout << "Abort v flip: Can only flip rgb encoded images." << endl;
+void Image::rotate_rgb_90() {
+    if (!check_rgb_transform("rotate", "rotate")) {
         return;
     }
-    if (has_header) {
-        cout << "Abort v flip: Should remove header first." << endl;
+    std::shared_ptr<unsigned char> rotated = FrameBufferPool::instance().acquire(
+        pixel_format_frame_size(format, width, height));
+    rotate_rgb_90_kernel(data.get(), width, height, get_stride(), rotated.get(),
+                         static_cast<size_t>(height) * 3);
+    replace_data(std::move(rotated), height, width);
+}
+
+/**
+ * Rotate a rgb encoded image by 270 degrees clockwise.
+ * Width and height are swapped.
+ */
+void Image::rotate_rgb_270() {
+    if (!check_rgb_transform("rotate", "rotate")) {
+        return;
+    }
+    std::shared_ptr<unsigned char> rotated = FrameBufferPool::instance().acquire(
+        pixel_format_frame_size(format, width, height));
+    rotate_rgb_270_kernel(data.get(), width, height, get_stride(), rotated.get(),
+                          static_cast<size_t>(height) * 3);
+    replace_data(std::move(rotated), height, width);
+}
+
+/**
+ * Transpose a rgb encoded image so rows become columns.
+ * Width and height are swapped.
+ */
+void Image::transpose_rgb() {
+    if (!check_rgb_transform("transpose", "transpose")) {
         return;
     }
-    const size_t row_size = width * 3;
-    const size_t num_rows = height;
-    for (size_t row = 0; row < num_rows / 2; ++row) {
-        // Calculate the start index of the row in the 1D array
-        unsigned char* top_row_start = data + row * row_size;
-        unsigned char* bottom_row_start = data + (num_rows - row - 1) * row_size;
-        // Swap rows
-        for (size_t i = 0; i < row_size; ++i) {
-            std::swap(top_row_start[i], bottom_row_start[i]);
+    std::shared_ptr<unsigned char> transposed = FrameBufferPool::instance().acquire(
+        pixel_format_frame_size(format, width, height));
+    transpose_rgb_kernel(data.get(), width, height, get_stride(), transposed.get(),
+                         static_cast<size_t>(height) * 3);
+    replace_data(std::move(transposed), height, width);
+}
+
+/**
+ * Convert a raw image to another pixel format. Runs in place when the
+ * new format is no larger, otherwise the result goes to a new buffer.
+ * The rgb header must be removed first.
+ *
+ * Large conversions between single plane formats are split into bands
+ * of rows on the image thread pool. Those that would shrink pixels in
+ * place use a new buffer instead, as do conversions of shared images.
+ *
+ * @param new_format The new pixel format. Must be a raw format.
+ * @param max_threads The most threads to use, 0 for the pool default, 1 for serial.
+ * @return true if the image was converted, else false.
+ */
+bool Image::convert_to(const PixelFormat new_format, const unsigned int max_threads) {
+    const PixelFormat current = format;
+    if (!pixel_format_is_raw(current) || !pixel_format_is_raw(new_format)) {
+        RASPI_HW_LOG_WARN("Abort convert: Can only convert between rgb, bgr, rgba, gray and yuv420.");
+        return false;
+    }
+    if (has_header) {
+        RASPI_HW_LOG_WARN("Abort convert: Should remove header first.");
+        return false;
+    }
+    if (data == nullptr || (is_contiguous() && size < pixel_format_frame_size(current, width, height))) {
+        RASPI_HW_LOG_WARN("Abort convert: Data is too small for the image size.");
+        return false;
+    }
+    compact();
+    const size_t new_size = pixel_format_frame_size(new_format, width, height);
+    const PixelFormatInfo& src_info = pixel_format_info(current);
+    const PixelFormatInfo& dst_info = pixel_format_info(new_format);
+    const bool banded = src_info.planes == 1 && dst_info.planes == 1 &&
+        ImageThreadPool::instance().get_band_count(height, size, max_threads) > 1;
+    // In place, a band that shrinks pixels would overwrite rows another band has not read yet.
+    // A shared buffer would have to be copied first, so converting into a new one is cheaper.
+    const bool in_place = can_convert_in_place(current, new_format, width, height) && !is_shared() &&
+        (!banded || src_info.bytes_per_pixel == dst_info.bytes_per_pixel);
+    std::shared_ptr<unsigned char> converted;
+    if (in_place) {
+        converted = data;
+    } else {
+        converted = FrameBufferPool::instance().acquire(new_size);
+    }
+    if (banded) {
+        const size_t src_row = pixel_format_row_size(current, width);
+        const size_t dst_row = pixel_format_row_size(new_format, width);
+        ImageThreadPool::instance().run(height, size, max_threads, [&](const size_t first_row, const size_t last_row) {
+            convert_pixels(data.get() + first_row * src_row, current, converted.get() + first_row * dst_row,
+                           new_format, width, last_row - first_row);
+        });
+    } else {
+        convert_pixels(data.get(), current, converted.get(), new_format, width, height);
+    }
+    if (!in_place) {
+        data = std::move(converted);
+        capacity = new_size;
+    }
+    size = new_size;
+    format = new_format;
+    return true;
+}
+
+/**
+ * Make a view of part of the image without copying. The view shares
+ * the buffer and keeps the rows of this image, so get_stride() is the
+ * row size of this image. Changing pixels of either one gives it its
+ * own packed copy first.
+ *
+ * @param x The left edge in pixels.
+ * @param y The top edge in pixels.
+ * @param crop_width The view width in pixels.
+ * @param crop_height The view height in pixels.
+ * @return The view.
+ * @throws std::invalid_argument if the image is not raw single plane data without header,
+ *     or the rectangle is empty or not inside the image.
+ */
+Image Image::crop(const unsigned int x, const unsigned int y, const unsigned int crop_width,
+                  const unsigned int crop_height) const {
+    if (!pixel_format_is_raw(format) || pixel_format_info(format).planes != 1 || has_header || data == nullptr) {
+        throw invalid_argument("Can only crop rgb, bgr, rgba or gray images without header.");
+    }
+    if (crop_width == 0 || crop_height == 0 || x > width || y > height || crop_width > width - x ||
+        crop_height > height - y) {
+        throw invalid_argument("Crop rectangle must be inside the image and not empty.");
+    }
+    const size_t row_stride = get_stride();
+    const size_t row_size = pixel_format_row_size(format, crop_width);
+    const size_t offset = y * row_stride + pixel_format_row_size(format, x);
+    const size_t view_size = (crop_height - 1) * row_stride + row_size;
+    Image view(std::shared_ptr<unsigned char>(data, data.get() + offset), view_size, crop_width, crop_height, format,
+               false);
+    view.stride = row_stride == row_size ? 0 : row_stride;
+    view.info = info;
+    return view;
+}
+
+/**
+ * Make a resized copy. The source can be a crop view.
+ *
+ * @param new_width The new width in pixels.
+ * @param new_height The new height in pixels.
+ * @param filter How to compute new pixels. box needs the new size to divide the image size evenly.
+ * @param max_threads The most threads to use, 0 for the pool default, 1 for serial.
+ * @return The resized image, or an empty image if this image cannot be resized.
+ * @throws std::invalid_argument if the new size is 0 or box does not divide evenly.
+ */
+Image Image::resize(const unsigned int new_width, const unsigned int new_height, const ResizeFilter filter,
+                    const unsigned int max_threads) const {
+    if (new_width == 0 || new_height == 0) {
+        throw invalid_argument("New width and height must be at least 1.");
+    }
+    if (!check_resize("resize")) {
+        return {};
+    }
+    if (filter == ResizeFilter::box) {
+        if (width % new_width != 0 || height % new_height != 0 || width / new_width != height / new_height) {
+            throw invalid_argument("Box resize needs the same whole factor for width and height, use area instead.");
         }
+        return downscale(width / new_width, max_threads);
+    }
+    const size_t channels = pixel_format_info(format).bytes_per_pixel;
+    Image resized(pixel_format_frame_size(format, new_width, new_height), new_width, new_height, format, false);
+    const size_t src_stride = get_stride();
+    const size_t dst_stride = resized.get_stride();
+    const size_t bytes = pixel_format_frame_size(format, width, height);
+    ImageThreadPool::instance().run(new_height, bytes, max_threads, [&](const size_t first_row, const size_t last_row) {
+        if (filter == ResizeFilter::bilinear) {
+            resize_bilinear_rows_kernel(data.get(), width, height, src_stride, channels, resized.data.get(), new_width,
+                                        new_height, dst_stride, first_row, last_row);
+        } else {
+            resize_area_rows_kernel(data.get(), width, height, src_stride, channels, resized.data.get(), new_width,
+                                    new_height, dst_stride, first_row, last_row);
+        }
+    });
+    resized.info = info;
+    return resized;
+}
+
+/**
+ * Make a copy shrunk by a whole factor, each new pixel the average of a
+ * factor x factor block. Rows and columns left over at the right and
+ * bottom edges are dropped.
+ *
+ * @param factor The shrink factor, 1-256.
+ * @param max_threads The most threads to use, 0 for the pool default, 1 for serial.
+ * @return The smaller image, or an empty image if this image cannot be resized.
+ * @throws std::invalid_argument if the factor is out of range or larger than the image.
+ */
+Image Image::downscale(const unsigned int factor, const unsigned int max_threads) const {
+    if (factor == 0 || factor > 256) {
+        throw invalid_argument("Downscale factor must be 1-256.");
+    }
+    if (!check_resize("downscale")) {
+        return {};
+    }
+    if (factor > width || factor > height) {
+        throw invalid_argument("Downscale factor is larger than the image.");
+    }
+    const unsigned int new_width = width / factor;
+    const unsigned int new_height = height / factor;
+    Image scaled(pixel_format_frame_size(format, new_width, new_height), new_width, new_height, format, false);
+    const size_t src_stride = get_stride();
+    const size_t dst_stride = scaled.get_stride();
+    const size_t channels = pixel_format_info(format).bytes_per_pixel;
+    const size_t bytes = pixel_format_frame_size(format, width, height);
+    ImageThreadPool::instance().run(new_height, bytes, max_threads, [&](const size_t first_row, const size_t last_row) {
+        downscale_box_kernel(data.get() + first_row * factor * src_stride, width, (last_row - first_row) * factor,
+                             src_stride, channels, factor, scaled.data.get() + first_row * dst_stride, dst_stride);
+    });
+    scaled.info = info;
+    return scaled;
+}
+
+/**
+ * Check that a resize can run on this image.
+ *
+ * @param op_name The operation name used in abort messages.
+ * @return true if the image is raw single plane data without header, else false.
+ */
+bool Image::check_resize(const char* op_name) const {
+    if (!pixel_format_is_raw(format) || pixel_format_info(format).planes != 1) {
+        RASPI_HW_LOG_WARN("Abort " << op_name << ": Can only " << op_name << " rgb, bgr, rgba or gray images.");
+        return false;
+    }
+    if (has_header) {
+        RASPI_HW_LOG_WARN("Abort " << op_name << ": Should remove header first.");
+        return false;
+    }
+    if (data == nullptr) {
+        RASPI_HW_LOG_WARN("Abort " << op_name << ": No data.");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Check that a pixel transform can run on this image.
+ *
+ * @param op_name The operation name used in abort messages.
+ * @param verb The verb used in abort messages.
+ * @return true if the image is rgb without header, else false.
+ */
+bool Image::check_rgb_transform(const char* op_name, const char* verb) const {
+    if (format != PixelFormat::rgb) {
+        RASPI_HW_LOG_WARN("Abort " << op_name << ": Can only " << verb << " rgb encoded images.");
+        return false;
+    }
+    if (has_header) {
+        RASPI_HW_LOG_WARN("Abort " << op_name << ": Should remove header first.");
+        return false;
+    }
+    if (data == nullptr) {
+        RASPI_HW_LOG_WARN("Abort " << op_name << ": No data.");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Swap in a new packed buffer holding the transformed image.
+ *
+ * @param new_data The new buffer.
+ * @param new_width The new image width.
+ * @param new_height The new image height.
+ */
+void Image::replace_data(std::shared_ptr<unsigned char> new_data, const unsigned int new_width,
+                         const unsigned int new_height) {
+    data = std::move(new_data);
+    size = pixel_format_frame_size(format, new_width, new_height);
+    capacity = size;
+    width = new_width;
+    height = new_height;
+    stride = 0;
+}
+
+/**
+ * Give this image its own copy of the buffer if other images
+ * share it. Called before changing pixels.
+ */
+void Image::detach() {
+    if (!is_shared()) {
+        return;
+    }
+    if (!is_contiguous()) {
+        compact();
+        return;
+    }
+    std::shared_ptr<unsigned char> own_data = FrameBufferPool::instance().acquire(size);
+    if (size > 0) {
+        memcpy(own_data.get(), data.get(), size);
+    }
+    data = std::move(own_data);
+    capacity = size;
+}
+
+/**
+ * Copy the rows of a crop view into a packed buffer of its own, so
+ * code that needs one block of pixels can run on it.
+ */
+void Image::compact() {
+    if (is_contiguous()) {
+        return;
     }
+    const size_t row_size = pixel_format_row_size(format, width);
+    const size_t packed_size = row_size * height;
+    std::shared_ptr<unsigned char> packed = FrameBufferPool::instance().acquire(packed_size);
+    copy_rows(data.get(), stride, packed.get(), row_size, row_size, height);
+    data = std::move(packed);
+    size = packed_size;
+    capacity = packed_size;
+    stride = 0;
 }
 
 /**
  * Determine whether the file path extension matches the image encoding.
- * Only check for png or jpeg because rgb encoded images can be saved
+ * Only check for png or jpeg because raw images can be saved
  * in many ways.
  *
  * @param file_path The file path passed by user.
  * @return Whether the file path matches the image encoding.
  */
 bool Image::check_save_extension(const std::string &file_path) const {
-    if (encoding == "rgb") {
+    if (pixel_format_is_raw(format)) {
         return true;
     }
     // ReSharper disable once CppTooWideScopeInitStatement
     const size_t dot_pos = file_path.rfind('.');
     if (dot_pos != std::string::npos && dot_pos < file_path.length() - 1) {
-        if (file_path.substr(dot_pos + 1) == encoding) {
+        if (file_path.compare(dot_pos + 1, std::string::npos, pixel_format_name(format)) == 0) {
             return true;
         }
-        cout << "Abort save: File extension does not match image encoding! Change file extension." << endl;
+        RASPI_HW_LOG_WARN("Abort save: File extension does not match image encoding! Change file extension.");
         return false;
     }
-    cout << "Abort save: Invalid file extension!" << endl;
+    RASPI_HW_LOG_WARN("Abort save: Invalid file extension!");
     return false;
 }
@@ -0,0 +1,817 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "image_ops.h"
+#include "simd.h"
+
+namespace {
+
+// Rotations copy square tiles of this many pixels so both the source
+// rows and destination rows of a tile stay in cache.
+constexpr size_t tile_size = 32;
+
+// Row swaps go through a stack buffer of this size instead of allocating.
+constexpr size_t swap_chunk_size = 4096;
+
+/**
+ * Swap two 3 byte pixels.
+ */
+inline void swap_pixel(unsigned char* a, unsigned char* b) {
+    std::swap(a[0], b[0]);
+    std::swap(a[1], b[1]);
+    std::swap(a[2], b[2]);
+}
+
+/**
+ * Copy one 3 byte pixel.
+ */
+inline void copy_pixel(unsigned char* dst, const unsigned char* src) {
+    dst[0] = src[0];
+    dst[1] = src[1];
+    dst[2] = src[2];
+}
+
+#if RASPI_HW_SSSE3
+/**
+ * Shuffle masks that reverse the order of 16 packed rgb pixels held in
+ * three registers. Output register o takes lane l from input register i
+ * where masks[o][i][l] is not 0x80.
+ */
+struct ReverseMasks {
+    alignas(16) unsigned char masks[3][3][16];
+};
+
+constexpr ReverseMasks make_reverse_masks() {
+    ReverseMasks result{};
+    for (size_t out = 0; out < 48; ++out) {
+        const size_t in = (15 - out / 3) * 3 + out % 3;
+        for (size_t reg = 0; reg < 3; ++reg) {
+            result.masks[out / 16][reg][out % 16] = in / 16 == reg ? static_cast<unsigned char>(in % 16) : 0x80;
+        }
+    }
+    return result;
+}
+
+constexpr ReverseMasks reverse_masks = make_reverse_masks();
+
+inline __m128i load_mask(const size_t out, const size_t in) {
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(reverse_masks.masks[out][in]));
+}
+
+/**
+ * Load 16 pixels from src and store them in reverse pixel order at dst.
+ */
+inline void reverse_16_pixels(const __m128i in[3], unsigned char* dst) {
+    const __m128i out0 = _mm_or_si128(_mm_shuffle_epi8(in[1], load_mask(0, 1)),
+                                      _mm_shuffle_epi8(in[2], load_mask(0, 2)));
+    const __m128i out1 = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in[0], load_mask(1, 0)),
+                                                   _mm_shuffle_epi8(in[1], load_mask(1, 1))),
+                                      _mm_shuffle_epi8(in[2], load_mask(1, 2)));
+    const __m128i out2 = _mm_or_si128(_mm_shuffle_epi8(in[0], load_mask(2, 0)),
+                                      _mm_shuffle_epi8(in[1], load_mask(2, 1)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), out0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), out1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 32), out2);
+}
+
+inline void load_16_pixels(const unsigned char* src, __m128i out[3]) {
+    out[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    out[1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+    out[2] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+}
+#endif
+
+#if RASPI_HW_NEON
+inline uint8x16_t reverse_u8x16(const uint8x16_t value) {
+    const uint8x16_t halves_reversed = vrev64q_u8(value);
+    return vcombine_u8(vget_high_u8(halves_reversed), vget_low_u8(halves_reversed));
+}
+
+/**
+ * Reverse 16 pixels loaded with vld3q_u8. Deinterleaving keeps each
+ * channel in its own register so a plain byte reverse is enough.
+ */
+inline uint8x16x3_t reverse_16_pixels(uint8x16x3_t pixels) {
+    pixels.val[0] = reverse_u8x16(pixels.val[0]);
+    pixels.val[1] = reverse_u8x16(pixels.val[1]);
+    pixels.val[2] = reverse_u8x16(pixels.val[2]);
+    return pixels;
+}
+#endif
+
+/**
+ * Swap pixel i of a with pixel i counted back from b_end, for the first
+ * count pixels. Used for both flipping one row (a and b_end on the same
+ * row, count half the width) and for rotating two rows by 180 degrees.
+ * The two ranges must not overlap.
+ *
+ * @param a The first pixel of the forward range.
+ * @param b_end One past the last pixel of the backward range.
+ * @param count The number of pixel pairs to swap.
+ */
+void swap_reversed(unsigned char* a, unsigned char* b_end, const size_t count) {
+    size_t i = 0;
+#if RASPI_HW_SSSE3
+    for (; i + 16 <= count; i += 16) {
+        unsigned char* forward = a + i * 3;
+        unsigned char* backward = b_end - i * 3 - 48;
+        __m128i forward_pixels[3];
+        __m128i backward_pixels[3];
+        load_16_pixels(forward, forward_pixels);
+        load_16_pixels(backward, backward_pixels);
+        reverse_16_pixels(backward_pixels, forward);
+        reverse_16_pixels(forward_pixels, backward);
+    }
+#elif RASPI_HW_NEON
+    for (; i + 16 <= count; i += 16) {
+        unsigned char* forward = a + i * 3;
+        unsigned char* backward = b_end - i * 3 - 48;
+        const uint8x16x3_t forward_pixels = vld3q_u8(forward);
+        const uint8x16x3_t backward_pixels = vld3q_u8(backward);
+        vst3q_u8(forward, reverse_16_pixels(backward_pixels));
+        vst3q_u8(backward, reverse_16_pixels(forward_pixels));
+    }
+#endif
+    for (; i < count; ++i) {
+        swap_pixel(a + i * 3, b_end - (i + 1) * 3);
+    }
+}
+
+/**
+ * Copy every source pixel to the destination position given by dst_pixel,
+ * one square tile at a time.
+ *
+ * @param dst_pixel Callable taking (x, y) and returning the destination pointer.
+ */
+template <typename DstPixel>
+void tiled_pixel_copy(const unsigned char* src, const size_t width, const size_t height, const size_t src_stride,
+                      DstPixel dst_pixel) {
+    for (size_t tile_y = 0; tile_y < height; tile_y += tile_size) {
+        const size_t y_end = std::min(tile_y + tile_size, height);
+        for (size_t tile_x = 0; tile_x < width; tile_x += tile_size) {
+            const size_t x_end = std::min(tile_x + tile_size, width);
+            for (size_t y = tile_y; y < y_end; ++y) {
+                const unsigned char* src_row = src + y * src_stride;
+                for (size_t x = tile_x; x < x_end; ++x) {
+                    copy_pixel(dst_pixel(x, y), src_row + x * 3);
+                }
+            }
+        }
+    }
+}
+
+// Bilinear weights are in 1/128ths per axis, so a blend of two rows of
+// horizontal results is shifted down by 14 bits.
+constexpr uint32_t bilinear_one = 128;
+constexpr int bilinear_shift = 14;
+
+// Area weights sum to 2^14 across a row and 2^16 down a column. Row
+// sums are kept to 8 fractional bits so they fit 16 bits, and column
+// sums of those fit 32 bits.
+constexpr uint32_t area_row_one = 1 << 14;
+constexpr int area_row_shift = 6;
+constexpr uint32_t area_column_one = 1 << 16;
+constexpr int area_shift = 24;
+
+/**
+ * Add a row of bytes to 16 bit sums.
+ *
+ * @param row The bytes to add.
+ * @param sums The sums, count long.
+ * @param count The number of bytes.
+ */
+void add_row_u16(const unsigned char* row, uint16_t* sums, const size_t count) {
+    size_t i = 0;
+#if RASPI_HW_SSSE3
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        auto* out = reinterpret_cast<__m128i*>(sums + i);
+        _mm_storeu_si128(out, _mm_add_epi16(_mm_loadu_si128(out), _mm_unpacklo_epi8(bytes, zero)));
+        _mm_storeu_si128(out + 1, _mm_add_epi16(_mm_loadu_si128(out + 1), _mm_unpackhi_epi8(bytes, zero)));
+    }
+#elif RASPI_HW_NEON
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16_t bytes = vld1q_u8(row + i);
+        vst1q_u16(sums + i, vaddw_u8(vld1q_u16(sums + i), vget_low_u8(bytes)));
+        vst1q_u16(sums + i + 8, vaddw_u8(vld1q_u16(sums + i + 8), vget_high_u8(bytes)));
+    }
+#endif
+    for (; i < count; ++i) {
+        sums[i] = static_cast<uint16_t>(sums[i] + row[i]);
+    }
+}
+
+/**
+ * Blend two rows of horizontal bilinear results into bytes.
+ *
+ * @param top The upper row, at most 128 * 255 per value.
+ * @param bottom The lower row.
+ * @param bottom_weight How much of the lower row to take, 0-128.
+ * @param dst The output bytes.
+ * @param count The number of values.
+ */
+void blend_rows(const uint16_t* top, const uint16_t* bottom, const uint32_t bottom_weight, unsigned char* dst,
+                const size_t count) {
+    const uint32_t top_weight = bilinear_one - bottom_weight;
+    size_t i = 0;
+#if RASPI_HW_SSSE3
+    // Both rows fit in signed 16 bits, so pairs go through one multiply add.
+    const __m128i weights = _mm_set1_epi32(static_cast<int>(bottom_weight << 16 | top_weight));
+    const __m128i round = _mm_set1_epi32(1 << (bilinear_shift - 1));
+    for (; i + 8 <= count; i += 8) {
+        const __m128i top_values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + i));
+        const __m128i bottom_values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + i));
+        const __m128i low = _mm_srai_epi32(_mm_add_epi32(
+            _mm_madd_epi16(_mm_unpacklo_epi16(top_values, bottom_values), weights), round), bilinear_shift);
+        const __m128i high = _mm_srai_epi32(_mm_add_epi32(
+            _mm_madd_epi16(_mm_unpackhi_epi16(top_values, bottom_values), weights), round), bilinear_shift);
+        const __m128i packed = _mm_packs_epi32(low, high);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(packed, packed));
+    }
+#elif RASPI_HW_NEON
+    const uint16x4_t top_weights = vdup_n_u16(static_cast<uint16_t>(top_weight));
+    const uint16x4_t bottom_weights = vdup_n_u16(static_cast<uint16_t>(bottom_weight));
+    for (; i + 8 <= count; i += 8) {
+        const uint16x8_t top_values = vld1q_u16(top + i);
+        const uint16x8_t bottom_values = vld1q_u16(bottom + i);
+        const uint32x4_t low = vmlal_u16(vmull_u16(vget_low_u16(top_values), top_weights),
+                                         vget_low_u16(bottom_values), bottom_weights);
+        const uint32x4_t high = vmlal_u16(vmull_u16(vget_high_u16(top_values), top_weights),
+                                          vget_high_u16(bottom_values), bottom_weights);
+        const uint16x8_t blended = vcombine_u16(vrshrn_n_u32(low, bilinear_shift), vrshrn_n_u32(high, bilinear_shift));
+        vst1_u8(dst + i, vqmovn_u16(blended));
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint32_t value = top[i] * top_weight + bottom[i] * bottom_weight;
+        dst[i] = static_cast<unsigned char>((value + (1u << (bilinear_shift - 1))) >> bilinear_shift);
+    }
+}
+
+/**
+ * Where each destination pixel samples the source along one axis for
+ * bilinear resizing, using pixel centers.
+ */
+struct BilinearAxis {
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> second;
+    std::vector<uint16_t> second_weight;
+};
+
+/**
+ * Work out the bilinear samples for one axis.
+ *
+ * @param src_length The source width or height.
+ * @param dst_length The destination width or height.
+ * @return The samples.
+ */
+BilinearAxis make_bilinear_axis(const size_t src_length, const size_t dst_length) {
+    BilinearAxis axis;
+    axis.first.resize(dst_length);
+    axis.second.resize(dst_length);
+    axis.second_weight.resize(dst_length);
+    const double scale = static_cast<double>(src_length) / static_cast<double>(dst_length);
+    for (size_t i = 0; i < dst_length; ++i) {
+        const double position = std::clamp((static_cast<double>(i) + 0.5) * scale - 0.5, 0.0,
+                                           static_cast<double>(src_length - 1));
+        const auto first = static_cast<uint32_t>(position);
+        axis.first[i] = first;
+        axis.second[i] = std::min<uint32_t>(first + 1, static_cast<uint32_t>(src_length - 1));
+        axis.second_weight[i] = static_cast<uint16_t>(std::lround((position - first) * bilinear_one));
+    }
+    return axis;
+}
+
+/**
+ * Interpolate one source row along x into 16 bit values scaled by 128.
+ * fixed_channels lets the compiler unroll the common pixel sizes, 0
+ * takes the channel count at run time.
+ */
+template <size_t fixed_channels>
+void bilinear_row(const unsigned char* src_row, const BilinearAxis& x_axis, const size_t run_channels,
+                  uint16_t* out) {
+    const size_t channels = fixed_channels != 0 ? fixed_channels : run_channels;
+    for (size_t x = 0; x < x_axis.first.size(); ++x) {
+        const unsigned char* first = src_row + x_axis.first[x] * channels;
+        const unsigned char* second = src_row + x_axis.second[x] * channels;
+        const uint32_t second_weight = x_axis.second_weight[x];
+        const uint32_t first_weight = bilinear_one - second_weight;
+        for (size_t c = 0; c < channels; ++c) {
+            out[x * channels + c] = static_cast<uint16_t>(first[c] * first_weight + second[c] * second_weight);
+        }
+    }
+}
+
+/**
+ * Which source pixels each destination pixel covers along one axis and
+ * how much of each, for area resizing. Weights of one destination pixel
+ * sum to exactly one, given in fixed point.
+ */
+struct AreaAxis {
+    std::vector<uint32_t> start;
+    std::vector<uint32_t> offset;
+    std::vector<uint32_t> weights;
+};
+
+/**
+ * Work out the area weights for one axis. Only for shrinking.
+ *
+ * @param src_length The source width or height.
+ * @param dst_length The destination width or height, at most src_length.
+ * @param one The fixed point value of a weight of one.
+ * @return The weights.
+ */
+AreaAxis make_area_axis(const size_t src_length, const size_t dst_length, const uint32_t one) {
+    AreaAxis axis;
+    axis.start.resize(dst_length);
+    axis.offset.resize(dst_length + 1);
+    const double scale = static_cast<double>(src_length) / static_cast<double>(dst_length);
+    for (size_t i = 0; i < dst_length; ++i) {
+        const double begin = static_cast<double>(i) * scale;
+        const double end = std::min(static_cast<double>(i + 1) * scale, static_cast<double>(src_length));
+        const auto first = static_cast<uint32_t>(begin);
+        const auto last = std::min(static_cast<uint32_t>(std::ceil(end)), static_cast<uint32_t>(src_length));
+        axis.start[i] = first;
+        axis.offset[i] = static_cast<uint32_t>(axis.weights.size());
+        // Round the running total so the weights add up to exactly one.
+        double covered = 0;
+        long given = 0;
+        for (uint32_t j = first; j < last; ++j) {
+            covered += std::min(end, j + 1.0) - std::max(begin, static_cast<double>(j));
+            const long total = std::lround(covered / (end - begin) * one);
+            axis.weights.push_back(static_cast<uint32_t>(total - given));
+            given = total;
+        }
+    }
+    axis.offset[dst_length] = static_cast<uint32_t>(axis.weights.size());
+    return axis;
+}
+
+/**
+ * Average one source row along x into 16 bit values with 8 fractional bits.
+ * fixed_channels works as for bilinear_row().
+ */
+template <size_t fixed_channels>
+void area_row(const unsigned char* src_row, const AreaAxis& x_axis, const size_t run_channels, uint16_t* out) {
+    const size_t channels = fixed_channels != 0 ? fixed_channels : run_channels;
+    const size_t dst_width = x_axis.start.size();
+    const uint32_t* starts = x_axis.start.data();
+    const uint32_t* offsets = x_axis.offset.data();
+    const uint32_t* all_weights = x_axis.weights.data();
+    for (size_t x = 0; x < dst_width; ++x) {
+        const unsigned char* first = src_row + static_cast<size_t>(starts[x]) * channels;
+        const uint32_t* weights = all_weights + offsets[x];
+        const uint32_t count = offsets[x + 1] - offsets[x];
+        // Pixels have at most 4 channels.
+        uint32_t sums[4] = {};
+        for (uint32_t k = 0; k < count; ++k) {
+            const uint32_t weight = weights[k];
+            for (size_t c = 0; c < channels; ++c) {
+                sums[c] += first[k * channels + c] * weight;
+            }
+        }
+        for (size_t c = 0; c < channels; ++c) {
+            out[x * channels + c] =
+                static_cast<uint16_t>((sums[c] + (1u << (area_row_shift - 1))) >> area_row_shift);
+        }
+    }
+}
+
+/**
+ * Pick the version of a row function for a channel count.
+ *
+ * @param channels The bytes per pixel.
+ * @return The row function, unrolled for 1, 3 or 4 channels.
+ */
+template <typename Axis>
+auto pick_row_function(void (*const versions[4])(const unsigned char*, const Axis&, size_t, uint16_t*),
+                       const size_t channels) {
+    switch (channels) {
+        case 1:
+            return versions[1];
+        case 3:
+            return versions[2];
+        case 4:
+            return versions[3];
+        default:
+            return versions[0];
+    }
+}
+
+}
+
+/**
+ * Get which SIMD instructions the kernels were built with.
+ *
+ * @return "neon", "ssse3" or "scalar".
+ */
+const char* get_simd_backend_name() {
+#if RASPI_HW_NEON
+    return "neon";
+#elif RASPI_HW_SSSE3
+    return "ssse3";
+#else
+    return "scalar";
+#endif
+}
+
+/**
+ * Copy rows between buffers whose rows are different distances apart.
+ *
+ * @param src The first source row.
+ * @param src_stride The distance between source rows in bytes.
+ * @param dst The first destination row.
+ * @param dst_stride The distance between destination rows in bytes.
+ * @param row_size The bytes to copy from each row.
+ * @param height The number of rows.
+ */
+void copy_rows(const unsigned char* src, const size_t src_stride, unsigned char* dst, const size_t dst_stride,
+               const size_t row_size, const size_t height) {
+    for (size_t row = 0; row < height; ++row) {
+        memcpy(dst + row * dst_stride, src + row * src_stride, row_size);
+    }
+}
+
+/**
+ * Reverse the pixel order of every row in one pass.
+ *
+ * @param data The first row.
+ * @param width The image width in pixels.
+ * @param height The image height.
+ * @param stride The distance between rows in bytes.
+ */
+void flip_rgb_h_kernel(unsigned char* data, const size_t width, const size_t height, const size_t stride) {
+    const size_t row_size = width * 3;
+    for (size_t row = 0; row < height; ++row) {
+        unsigned char* row_start = data + row * stride;
+        swap_reversed(row_start, row_start + row_size, width / 2);
+    }
+}
+
+/**
+ * Reference horizontal flip, one pixel pair at a time.
+ */
+void flip_rgb_h_scalar(unsigned char* data, const size_t width, const size_t height, const size_t stride) {
+    for (size_t row = 0; row < height; ++row) {
+        unsigned char* row_start = data + row * stride;
+        for (size_t col = 0; col < width / 2; ++col) {
+            swap_pixel(row_start + col * 3, row_start + (width - col - 1) * 3);
+        }
+    }
+}
+
+/**
+ * Swap rows top to bottom with memcpy through a small stack buffer.
+ *
+ * @param data The first row.
+ * @param row_size The number of bytes to swap per row.
+ * @param height The image height.
+ * @param stride The distance between rows in bytes.
+ */
+void flip_rows_v_kernel(unsigned char* data, const size_t row_size, const size_t height, const size_t stride) {
+    flip_rows_v_pairs_kernel(data, row_size, height, stride, 0, height / 2);
+}
+
+/**
+ * Swap rows first_pair up to last_pair of the top half with their
+ * mirror rows in the bottom half. Pairs are independent, so bands of
+ * them can run on different threads.
+ *
+ * @param data The first row.
+ * @param row_size The bytes to swap in each row.
+ * @param height The image height.
+ * @param stride The distance between rows in bytes.
+ * @param first_pair The first top row to swap.
+ * @param last_pair One past the last top row to swap, at most height / 2.
+ */
+void flip_rows_v_pairs_kernel(unsigned char* data, const size_t row_size, const size_t height, const size_t stride,
+                              const size_t first_pair, const size_t last_pair) {
+    unsigned char chunk[swap_chunk_size];
+    for (size_t row = first_pair; row < last_pair; ++row) {
+        unsigned char* top_row_start = data + row * stride;
+        unsigned char* bottom_row_start = data + (height - row - 1) * stride;
+        for (size_t offset = 0; offset < row_size; offset += swap_chunk_size) {
+            const size_t length = std::min(swap_chunk_size, row_size - offset);
+            memcpy(chunk, top_row_start + offset, length);
+            memcpy(top_row_start + offset, bottom_row_start + offset, length);
+            memcpy(bottom_row_start + offset, chunk, length);
+        }
+    }
+}
+
+/**
+ * Reference vertical flip, one byte at a time.
+ */
+void flip_rows_v_scalar(unsigned char* data, const size_t row_size, const size_t height, const size_t stride) {
+    for (size_t row = 0; row < height / 2; ++row) {
+        unsigned char* top_row_start = data + row * stride;
+        unsigned char* bottom_row_start = data + (height - row - 1) * stride;
+        for (size_t i = 0; i < row_size; ++i) {
+            std::swap(top_row_start[i], bottom_row_start[i]);
+        }
+    }
+}
+
+/**
+ * Rotate by 180 degrees in one pass. Each top row is swapped with
+ * its bottom row while both are reversed.
+ *
+ * @param data The first row.
+ * @param width The image width in pixels.
+ * @param height The image height.
+ * @param stride The distance between rows in bytes.
+ */
+void rotate_rgb_180_kernel(unsigned char* data, const size_t width, const size_t height, const size_t stride) {
+    const size_t row_size = width * 3;
+    for (size_t row = 0; row < height / 2; ++row) {
+        unsigned char* top_row_start = data + row * stride;
+        unsigned char* bottom_row_start = data + (height - row - 1) * stride;
+        swap_reversed(top_row_start, bottom_row_start + row_size, width);
+    }
+    if (height % 2 == 1) {
+        unsigned char* middle_row_start = data + (height / 2) * stride;
+        swap_reversed(middle_row_start, middle_row_start + row_size, width / 2);
+    }
+}
+
+/**
+ * Reference 180 degree rotation, one pixel pair at a time.
+ */
+void rotate_rgb_180_scalar(unsigned char* data, const size_t width, const size_t height, const size_t stride) {
+    const size_t pixel_count = width * height;
+    for (size_t i = 0; i < pixel_count / 2; ++i) {
+        const size_t j = pixel_count - i - 1;
+        swap_pixel(data + (i / width) * stride + (i % width) * 3, data + (j / width) * stride + (j % width) * 3);
+    }
+}
+
+/**
+ * Rotate by 90 degrees clockwise into dst using cache sized tiles.
+ *
+ * @param src The first source row.
+ * @param width The source width in pixels.
+ * @param height The source height.
+ * @param src_stride The distance between source rows in bytes.
+ * @param dst The first destination row. Holds height pixels per row and width rows.
+ * @param dst_stride The distance between destination rows in bytes.
+ */
+void rotate_rgb_90_kernel(const unsigned char* src, const size_t width, const size_t height,
+                          const size_t src_stride, unsigned char* dst, const size_t dst_stride) {
+    tiled_pixel_copy(src, width, height, src_stride, [=](const size_t x, const size_t y) {
+        return dst + x * dst_stride + (height - y - 1) * 3;
+    });
+}
+
+/**
+ * Reference 90 degree clockwise rotation, row by row.
+ */
+void rotate_rgb_90_scalar(const unsigned char* src, const size_t width, const size_t height,
+                          const size_t src_stride, unsigned char* dst, const size_t dst_stride) {
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            copy_pixel(dst + x * dst_stride + (height - y - 1) * 3, src + y * src_stride + x * 3);
+        }
+    }
+}
+
+/**
+ * Rotate by 270 degrees clockwise into dst using cache sized tiles.
+ * Same arguments as rotate_rgb_90_kernel().
+ */
+void rotate_rgb_270_kernel(const unsigned char* src, const size_t width, const size_t height,
+                           const size_t src_stride, unsigned char* dst, const size_t dst_stride) {
+    tiled_pixel_copy(src, width, height, src_stride, [=](const size_t x, const size_t y) {
+        return dst + (width - x - 1) * dst_stride + y * 3;
+    });
+}
+
+/**
+ * Reference 270 degree clockwise rotation, row by row.
+ */
+void rotate_rgb_270_scalar(const unsigned char* src, const size_t width, const size_t height,
+                           const size_t src_stride, unsigned char* dst, const size_t dst_stride) {
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            copy_pixel(dst + (width - x - 1) * dst_stride + y * 3, src + y * src_stride + x * 3);
+        }
+    }
+}
+
+/**
+ * Swap rows and columns into dst using cache sized tiles.
+ * Same arguments as rotate_rgb_90_kernel().
+ */
+void transpose_rgb_kernel(const unsigned char* src, const size_t width, const size_t height,
+                          const size_t src_stride, unsigned char* dst, const size_t dst_stride) {
+    tiled_pixel_copy(src, width, height, src_stride, [=](const size_t x, const size_t y) {
+        return dst + x * dst_stride + y * 3;
+    });
+}
+
+/**
+ * Reference transpose, row by row.
+ */
+void transpose_rgb_scalar(const unsigned char* src, const size_t width, const size_t height,
+                          const size_t src_stride, unsigned char* dst, const size_t dst_stride) {
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            copy_pixel(dst + x * dst_stride + y * 3, src + y * src_stride + x * 3);
+        }
+    }
+}
+
+/**
+ * Average factor x factor blocks. Rows are summed into 16 bit lanes
+ * with SIMD, then each block is summed across and divided.
+ *
+ * @param src The first source row.
+ * @param width The source width in pixels.
+ * @param height The source height.
+ * @param src_stride The distance between source rows in bytes.
+ * @param channels The bytes per pixel.
+ * @param factor The block size, 1-256.
+ * @param dst The first destination row.
+ * @param dst_stride The distance between destination rows in bytes.
+ */
+void downscale_box_kernel(const unsigned char* src, const size_t width, const size_t height, const size_t src_stride,
+                          const size_t channels, const size_t factor, unsigned char* dst, const size_t dst_stride) {
+    const size_t dst_width = width / factor;
+    const size_t dst_height = height / factor;
+    const size_t used = dst_width * factor * channels;
+    const auto area = static_cast<uint32_t>(factor * factor);
+    std::vector<uint16_t> sums(used);
+    for (size_t y = 0; y < dst_height; ++y) {
+        std::fill(sums.begin(), sums.end(), 0);
+        for (size_t k = 0; k < factor; ++k) {
+            add_row_u16(src + (y * factor + k) * src_stride, sums.data(), used);
+        }
+        unsigned char* dst_row = dst + y * dst_stride;
+        if (factor == 2) {
+            for (size_t x = 0; x < dst_width; ++x) {
+                const uint16_t* block = sums.data() + x * 2 * channels;
+                for (size_t c = 0; c < channels; ++c) {
+                    dst_row[x * channels + c] = static_cast<unsigned char>((block[c] + block[channels + c] + 2) >> 2);
+                }
+            }
+            continue;
+        }
+        for (size_t x = 0; x < dst_width; ++x) {
+            const uint16_t* block = sums.data() + x * factor * channels;
+            for (size_t c = 0; c < channels; ++c) {
+                uint32_t sum = 0;
+                for (size_t k = 0; k < factor; ++k) {
+                    sum += block[k * channels + c];
+                }
+                dst_row[x * channels + c] = static_cast<unsigned char>((sum + area / 2) / area);
+            }
+        }
+    }
+}
+
+/**
+ * Reference box downscale, one block at a time.
+ */
+void downscale_box_scalar(const unsigned char* src, const size_t width, const size_t height, const size_t src_stride,
+                          const size_t channels, const size_t factor, unsigned char* dst, const size_t dst_stride) {
+    const auto area = static_cast<uint32_t>(factor * factor);
+    for (size_t y = 0; y < height / factor; ++y) {
+        for (size_t x = 0; x < width / factor; ++x) {
+            for (size_t c = 0; c < channels; ++c) {
+                uint32_t sum = 0;
+                for (size_t block_y = 0; block_y < factor; ++block_y) {
+                    const unsigned char* row = src + (y * factor + block_y) * src_stride;
+                    for (size_t block_x = 0; block_x < factor; ++block_x) {
+                        sum += row[(x * factor + block_x) * channels + c];
+                    }
+                }
+                dst[y * dst_stride + x * channels + c] = static_cast<unsigned char>((sum + area / 2) / area);
+            }
+        }
+    }
+}
+
+/**
+ * Resize with bilinear interpolation between pixel centers. Each source
+ * row is interpolated along x once, then pairs of rows are blended with
+ * SIMD.
+ *
+ * @param src The first source row.
+ * @param width The source width in pixels.
+ * @param height The source height.
+ * @param src_stride The distance between source rows in bytes.
+ * @param channels The bytes per pixel.
+ * @param dst The first destination row.
+ * @param dst_width The destination width in pixels.
+ * @param dst_height The destination height.
+ * @param dst_stride The distance between destination rows in bytes.
+ */
+void resize_bilinear_kernel(const unsigned char* src, const size_t width, const size_t height,
+                            const size_t src_stride, const size_t channels, unsigned char* dst,
+                            const size_t dst_width, const size_t dst_height, const size_t dst_stride) {
+    resize_bilinear_rows_kernel(src, width, height, src_stride, channels, dst, dst_width, dst_height, dst_stride, 0,
+                                dst_height);
+}
+
+/**
+ * Bilinear resize of destination rows first_row up to last_row only, so
+ * bands of one image can run on different threads. Other arguments are
+ * as for resize_bilinear_kernel().
+ *
+ * @param first_row The first destination row to write.
+ * @param last_row One past the last destination row to write.
+ */
+void resize_bilinear_rows_kernel(const unsigned char* src, const size_t width, const size_t height,
+                                 const size_t src_stride, const size_t channels, unsigned char* dst,
+                                 const size_t dst_width, const size_t dst_height, const size_t dst_stride,
+                                 const size_t first_row, const size_t last_row) {
+    const BilinearAxis x_axis = make_bilinear_axis(width, dst_width);
+    const BilinearAxis y_axis = make_bilinear_axis(height, dst_height);
+    constexpr void (*versions[4])(const unsigned char*, const BilinearAxis&, size_t, uint16_t*) = {
+        bilinear_row<0>, bilinear_row<1>, bilinear_row<3>, bilinear_row<4>};
+    const auto interpolate_row = pick_row_function(versions, channels);
+    const size_t row_values = dst_width * channels;
+    std::vector<uint16_t> rows(row_values * 2);
+    uint16_t* cached[2] = {rows.data(), rows.data() + row_values};
+    // Source rows currently held in cached, or -1.
+    long cached_rows[2] = {-1, -1};
+    for (size_t y = first_row; y < last_row; ++y) {
+        const long top = y_axis.first[y];
+        const long bottom = y_axis.second[y];
+        if (cached_rows[0] != top) {
+            // Moving down one source row, the old bottom row is the new top row.
+            if (cached_rows[1] == top) {
+                std::swap(cached[0], cached[1]);
+                std::swap(cached_rows[0], cached_rows[1]);
+            } else {
+                interpolate_row(src + static_cast<size_t>(top) * src_stride, x_axis, channels, cached[0]);
+                cached_rows[0] = top;
+            }
+        }
+        if (cached_rows[1] != bottom) {
+            interpolate_row(src + static_cast<size_t>(bottom) * src_stride, x_axis, channels, cached[1]);
+            cached_rows[1] = bottom;
+        }
+        blend_rows(cached[0], cached[1], y_axis.second_weight[y], dst + y * dst_stride, row_values);
+    }
+}
+
+/**
+ * Resize by averaging every source pixel each destination pixel covers,
+ * weighted by how much of it is covered. Gives the least aliasing when
+ * shrinking. Enlarging along either axis falls back to bilinear.
+ * Same arguments as resize_bilinear_kernel().
+ */
+void resize_area_kernel(const unsigned char* src, const size_t width, const size_t height, const size_t src_stride,
+                        const size_t channels, unsigned char* dst, const size_t dst_width, const size_t dst_height,
+                        const size_t dst_stride) {
+    resize_area_rows_kernel(src, width, height, src_stride, channels, dst, dst_width, dst_height, dst_stride, 0,
+                            dst_height);
+}
+
+/**
+ * Area resize of destination rows first_row up to last_row only. Other
+ * arguments are as for resize_area_kernel().
+ *
+ * @param first_row The first destination row to write.
+ * @param last_row One past the last destination row to write.
+ */
+void resize_area_rows_kernel(const unsigned char* src, const size_t width, const size_t height,
+                             const size_t src_stride, const size_t channels, unsigned char* dst,
+                             const size_t dst_width, const size_t dst_height, const size_t dst_stride,
+                             const size_t first_row, const size_t last_row) {
+    if (dst_width > width || dst_height > height) {
+        resize_bilinear_rows_kernel(src, width, height, src_stride, channels, dst, dst_width, dst_height, dst_stride,
+                                    first_row, last_row);
+        return;
+    }
+    const AreaAxis x_axis = make_area_axis(width, dst_width, area_row_one);
+    const AreaAxis y_axis = make_area_axis(height, dst_height, area_column_one);
+    constexpr void (*versions[4])(const unsigned char*, const AreaAxis&, size_t, uint16_t*) = {
+        area_row<0>, area_row<1>, area_row<3>, area_row<4>};
+    const auto average_row = pick_row_function(versions, channels);
+    const size_t row_values = dst_width * channels;
+    std::vector<uint16_t> row(row_values);
+    std::vector<uint32_t> sums(row_values);
+    for (size_t y = first_row; y < last_row; ++y) {
+        std::fill(sums.begin(), sums.end(), 0);
+        for (uint32_t k = y_axis.offset[y]; k < y_axis.offset[y + 1]; ++k) {
+            const size_t src_y = y_axis.start[y] + (k - y_axis.offset[y]);
+            average_row(src + src_y * src_stride, x_axis, channels, row.data());
+            const uint32_t weight = y_axis.weights[k];
+            // Simple enough for the compiler to vectorize.
+            for (size_t i = 0; i < row_values; ++i) {
+                sums[i] += row[i] * weight;
+            }
+        }
+        unsigned char* dst_row = dst + y * dst_stride;
+        for (size_t i = 0; i < row_values; ++i) {
+            dst_row[i] = static_cast<unsigned char>((sums[i] + (1u << (area_shift - 1))) >> area_shift);
+        }
+    }
+}
@@ -0,0 +1,250 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include "image_thread_pool.h"
+#include "logger.h"
+
+using namespace std;
+
+namespace {
+
+// Bands thinner than this are not worth a thread.
+constexpr size_t min_band_rows = 8;
+// About a 640x480 rgb frame. Smaller frames take less time than waking the workers.
+constexpr size_t default_min_parallel_bytes = 512 * 1024;
+
+// Set on worker threads so operations they run do not wait on the pool.
+thread_local bool on_worker = false;
+
+/**
+ * Get the thread count to start with, RASPI_HW_IMAGE_THREADS when set,
+ * else one per core.
+ *
+ * @return The thread count, at least 1.
+ */
+unsigned int get_default_thread_count() {
+    const char* value = getenv("RASPI_HW_IMAGE_THREADS");
+    if (value != nullptr && *value != '\0') {
+        char* end = nullptr;
+        const unsigned long count = strtoul(value, &end, 10);
+        if (*end == '\0' && count > 0) {
+            return static_cast<unsigned int>(count);
+        }
+        RASPI_HW_LOG_WARN("Unknown RASPI_HW_IMAGE_THREADS " << value << ", using one thread per core.");
+    }
+    return max(1u, thread::hardware_concurrency());
+}
+
+}
+
+/**
+ * Get the process wide pool.
+ *
+ * @return The pool.
+ */
+ImageThreadPool& ImageThreadPool::instance() {
+    static ImageThreadPool pool;
+    return pool;
+}
+
+/**
+ * Start without workers. They are started by the first operation big
+ * enough to split.
+ */
+ImageThreadPool::ImageThreadPool()
+    : thread_count(get_default_thread_count()), min_parallel_bytes(default_min_parallel_bytes), stopping(false),
+      generation(0), current_band(nullptr), band_rows(0), total_rows(0), band_count(0), next_band(0),
+      finished_bands(0), active_workers(0) {}
+
+/**
+ * Stop and join the workers.
+ */
+ImageThreadPool::~ImageThreadPool() {
+    stop_workers();
+}
+
+/**
+ * Run band over all rows, split into bands that run at the same time.
+ * Returns once every band is done. Runs band(0, rows) on the calling
+ * thread when the frame is too small, max_threads is 1, or another
+ * operation is using the workers.
+ *
+ * @param rows The number of rows.
+ * @param bytes The bytes the operation touches, compared with the minimum parallel size.
+ * @param max_threads The most threads to use, 0 for as many as the pool has.
+ * @param band The work for rows first_row up to last_row. Must not throw.
+ */
+void ImageThreadPool::run(const size_t rows, const size_t bytes, const unsigned int max_threads,
+                          const function<void(size_t first_row, size_t last_row)>& band) {
+    unsigned int bands = get_band_count(rows, bytes, max_threads);
+    if (bands <= 1 || on_worker) {
+        band(0, rows);
+        return;
+    }
+    unique_lock run_lock(run_mutex, try_to_lock);
+    if (!run_lock.owns_lock()) {
+        band(0, rows);
+        return;
+    }
+    const unsigned int count = thread_count.load(memory_order_relaxed);
+    if (workers.size() + 1 != count) {
+        stop_workers();
+        start_workers(count - 1);
+    }
+    bands = min(bands, static_cast<unsigned int>(workers.size() + 1));
+    // Rounding the band height up can leave the last bands with no rows, so drop them.
+    const size_t rows_per_band = (rows + bands - 1) / bands;
+    bands = static_cast<unsigned int>((rows + rows_per_band - 1) / rows_per_band);
+    {
+        // A worker that woke too late for the last operation may still be looking at it.
+        unique_lock lock(mutex);
+        work_done.wait(lock, [this] { return active_workers == 0; });
+        current_band = &band;
+        band_rows = rows_per_band;
+        total_rows = rows;
+        band_count = bands;
+        next_band.store(0);
+        finished_bands.store(0);
+        ++generation;
+    }
+    work_ready.notify_all();
+    run_bands();
+    unique_lock lock(mutex);
+    work_done.wait(lock, [this] { return finished_bands.load() == band_count && active_workers == 0; });
+    current_band = nullptr;
+}
+
+/**
+ * Get how many bands run() would split an operation into.
+ *
+ * @param rows The number of rows.
+ * @param bytes The bytes the operation touches.
+ * @param max_threads The most threads to use, 0 for as many as the pool has.
+ * @return The band count, 1 when the operation stays on the calling thread.
+ */
+unsigned int ImageThreadPool::get_band_count(const size_t rows, const size_t bytes,
+                                             const unsigned int max_threads) const {
+    if (bytes < min_parallel_bytes.load(memory_order_relaxed)) {
+        return 1;
+    }
+    unsigned int threads = thread_count.load(memory_order_relaxed);
+    if (max_threads != 0) {
+        threads = min(threads, max_threads);
+    }
+    return static_cast<unsigned int>(max<size_t>(1, min<size_t>(threads, rows / min_band_rows)));
+}
+
+/**
+ * Set how many threads operations use, counting the calling thread.
+ * Waits for a running operation to finish.
+ *
+ * @param count The thread count, 1 to keep every operation serial.
+ * @throws std::invalid_argument if the count is 0.
+ */
+void ImageThreadPool::set_thread_count(const unsigned int count) {
+    if (count == 0) {
+        throw invalid_argument("Thread count must be at least 1.");
+    }
+    lock_guard run_lock(run_mutex);
+    thread_count.store(count, memory_order_relaxed);
+    stop_workers();
+}
+
+/**
+ * Get how many threads operations use, counting the calling thread.
+ *
+ * @return The thread count.
+ */
+unsigned int ImageThreadPool::get_thread_count() const {
+    return thread_count.load(memory_order_relaxed);
+}
+
+/**
+ * Set the size below which operations stay on the calling thread.
+ *
+ * @param bytes The size in bytes, 0 to split every operation with enough rows.
+ */
+void ImageThreadPool::set_min_parallel_bytes(const size_t bytes) {
+    min_parallel_bytes.store(bytes, memory_order_relaxed);
+}
+
+/**
+ * Get the size below which operations stay on the calling thread.
+ *
+ * @return The size in bytes.
+ */
+size_t ImageThreadPool::get_min_parallel_bytes() const {
+    return min_parallel_bytes.load(memory_order_relaxed);
+}
+
+/**
+ * Start worker threads. Called with run_mutex held and no workers.
+ *
+ * @param count The number of workers.
+ */
+void ImageThreadPool::start_workers(const unsigned int count) {
+    stopping = false;
+    for (unsigned int i = 0; i < count; ++i) {
+        workers.emplace_back(&ImageThreadPool::worker_loop, this);
+    }
+}
+
+/**
+ * Stop and join the worker threads. Called with run_mutex held, or
+ * from the destructor.
+ */
+void ImageThreadPool::stop_workers() {
+    {
+        lock_guard lock(mutex);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+/**
+ * Wait for operations and help run their bands.
+ */
+void ImageThreadPool::worker_loop() {
+    on_worker = true;
+    unique_lock lock(mutex);
+    unsigned long seen = generation;
+    while (true) {
+        work_ready.wait(lock, [this, seen] { return stopping || generation != seen; });
+        if (stopping) {
+            return;
+        }
+        seen = generation;
+        ++active_workers;
+        lock.unlock();
+        run_bands();
+        lock.lock();
+        --active_workers;
+        if (active_workers == 0) {
+            work_done.notify_all();
+        }
+    }
+}
+
+/**
+ * Take bands of the current operation until none are left.
+ */
+void ImageThreadPool::run_bands() {
+    unsigned int index;
+    while ((index = next_band.fetch_add(1)) < band_count) {
+        const size_t first_row = index * band_rows;
+        if (first_row < total_rows) {
+            (*current_band)(first_row, min(total_rows, first_row + band_rows));
+        }
+        if (finished_bands.fetch_add(1) + 1 == band_count) {
+            lock_guard lock(mutex);
+            work_done.notify_all();
+        }
+    }
+}
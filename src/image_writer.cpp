@@ -0,0 +1,368 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <fcntl.h>
+#include <iostream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include "image_writer.h"
+#include "logger.h"
+#include "metrics.h"
+#include "qoi_codec.h"
+
+using namespace std;
+
+namespace {
+
+// O_DIRECT needs the buffer, length and file offset aligned to the block size.
+constexpr size_t direct_alignment = 4096;
+
+/**
+ * Write the whole buffer, retrying short writes and interrupts.
+ *
+ * @return true if every byte was written, else false.
+ */
+bool write_all(const int fd, const unsigned char* buffer, size_t length) {
+    while (length > 0) {
+        const ssize_t written = ::write(fd, buffer, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        buffer += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+}
+
+/**
+ * Start the writer threads.
+ *
+ * @param config The number of threads, queue size, batch size and flush policy.
+ */
+ImageWriter::ImageWriter(const ImageWriterConfig& config)
+    : config(config), in_flight(0), stopping(false), saved(0), failed(0), bytes_written(0) {
+    this->config.thread_count = max<size_t>(this->config.thread_count, 1);
+    this->config.queue_capacity = max<size_t>(this->config.queue_capacity, 1);
+    this->config.max_batch = max<size_t>(this->config.max_batch, 1);
+    for (size_t i = 0; i < this->config.thread_count; ++i) {
+        threads.emplace_back(&ImageWriter::writer_loop, this);
+    }
+}
+
+/**
+ * Save everything still queued, then stop the writer threads.
+ */
+ImageWriter::~ImageWriter() {
+    {
+        lock_guard lock(mutex);
+        stopping = true;
+    }
+    job_ready.notify_all();
+    for (thread& writer : threads) {
+        writer.join();
+    }
+}
+
+/**
+ * Queue an image to be saved. Waits while the queue is full.
+ *
+ * @param image The image to save. Shares its buffer, later changes to the caller's image are not saved.
+ * @param file_path The path to save the image data to.
+ * @return A future that becomes true when the image was saved, else false.
+ */
+future<bool> ImageWriter::save_async(const Image& image, const string& file_path) {
+    Job job{image, file_path, promise<bool>(), nullptr};
+    future<bool> result = job.promise.get_future();
+    enqueue(std::move(job));
+    return result;
+}
+
+/**
+ * Queue an image to be saved and report the result through a
+ * callback. Waits while the queue is full.
+ *
+ * @param image The image to save.
+ * @param file_path The path to save the image data to.
+ * @param callback Called on a writer thread with true if saved, else false.
+ */
+void ImageWriter::save_async(const Image& image, const string& file_path, function<void(bool)> callback) {
+    enqueue(Job{image, file_path, promise<bool>(), std::move(callback)});
+}
+
+/**
+ * Queue an image to be saved without waiting.
+ *
+ * @param image The image to save.
+ * @param file_path The path to save the image data to.
+ * @param callback Called on a writer thread with true if saved, else false. May be empty.
+ * @return true if queued, false if the queue was full.
+ */
+bool ImageWriter::try_save_async(const Image& image, const string& file_path, function<void(bool)> callback) {
+    {
+        lock_guard lock(mutex);
+        if (queue.size() >= config.queue_capacity) {
+            return false;
+        }
+        queue.push_back(Job{image, file_path, promise<bool>(), std::move(callback)});
+    }
+    job_ready.notify_one();
+    return true;
+}
+
+/**
+ * Wait until every queued image has been saved.
+ */
+void ImageWriter::flush() {
+    unique_lock lock(mutex);
+    idle.wait(lock, [this] { return queue.empty() && in_flight == 0; });
+}
+
+/**
+ * Get the number of images waiting for a writer thread.
+ *
+ * @return The queued count.
+ */
+size_t ImageWriter::get_queued_count() const {
+    lock_guard lock(mutex);
+    return queue.size();
+}
+
+/**
+ * Get the number of images saved.
+ *
+ * @return The saved count.
+ */
+unsigned long ImageWriter::get_saved_count() const {
+    return saved.load();
+}
+
+/**
+ * Get the number of images that failed to save.
+ *
+ * @return The failed count.
+ */
+unsigned long ImageWriter::get_failed_count() const {
+    return failed.load();
+}
+
+/**
+ * Get the number of image bytes written.
+ *
+ * @return The bytes written.
+ */
+unsigned long long ImageWriter::get_bytes_written() const {
+    return bytes_written.load();
+}
+
+/**
+ * Get the writer configuration.
+ *
+ * @return The configuration.
+ */
+const ImageWriterConfig& ImageWriter::get_config() const {
+    return config;
+}
+
+/**
+ * Add a job to the queue, waiting for room first.
+ *
+ * @param job The job.
+ */
+void ImageWriter::enqueue(Job job) {
+    {
+        unique_lock lock(mutex);
+        space_ready.wait(lock, [this] { return queue.size() < config.queue_capacity; });
+        queue.push_back(std::move(job));
+    }
+    job_ready.notify_one();
+}
+
+/**
+ * Take up to max_batch jobs at a time and write them until stopped
+ * and the queue is empty.
+ */
+void ImageWriter::writer_loop() {
+    vector<Job> batch;
+    batch.reserve(config.max_batch);
+    while (true) {
+        {
+            unique_lock lock(mutex);
+            job_ready.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) {
+                return;
+            }
+            while (!queue.empty() && batch.size() < config.max_batch) {
+                batch.push_back(std::move(queue.front()));
+                queue.pop_front();
+            }
+            in_flight += batch.size();
+        }
+        space_ready.notify_all();
+        const size_t batch_size = batch.size();
+        write_batch(batch);
+        batch.clear();
+        {
+            lock_guard lock(mutex);
+            in_flight -= batch_size;
+        }
+        idle.notify_all();
+    }
+}
+
+/**
+ * Write every job of a batch. With the per_batch policy the files stay
+ * open until one syncfs() per device has flushed them all, then the
+ * results are reported. A file on a device whose sync failed is
+ * reported as not saved.
+ *
+ * @param batch The jobs to write.
+ */
+void ImageWriter::write_batch(vector<Job>& batch) {
+    vector<int> fds(batch.size(), -1);
+    vector<bool> results(batch.size(), false);
+    vector<size_t> written(batch.size(), 0);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        results[i] = write_file(batch[i], fds[i], written[i]);
+    }
+    if (config.fsync_policy == FsyncPolicy::per_batch) {
+        // syncfs() flushes the whole file system, so each device is synced once and a
+        // failed sync fails every file of the batch on that device.
+        vector<pair<dev_t, bool>> synced_devices;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            if (fds[i] < 0) {
+                continue;
+            }
+            struct stat file_stat {};
+            if (fstat(fds[i], &file_stat) != 0) {
+                RASPI_HW_LOG_ERROR("Failed to sync " << batch[i].file_path);
+                results[i] = false;
+                continue;
+            }
+            auto device = find_if(synced_devices.begin(), synced_devices.end(),
+                                  [&file_stat](const pair<dev_t, bool>& synced) {
+                                      return synced.first == file_stat.st_dev;
+                                  });
+            if (device == synced_devices.end()) {
+                synced_devices.emplace_back(file_stat.st_dev, syncfs(fds[i]) == 0);
+                device = prev(synced_devices.end());
+            }
+            if (!device->second) {
+                RASPI_HW_LOG_ERROR("Failed to sync " << batch[i].file_path);
+                results[i] = false;
+            }
+        }
+        for (const int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Job& job = batch[i];
+        if (results[i]) {
+            saved.fetch_add(1);
+            bytes_written.fetch_add(written[i]);
+        } else {
+            failed.fetch_add(1);
+        }
+        job.promise.set_value(results[i]);
+        if (job.callback) {
+            try {
+                job.callback(results[i]);
+            } catch (const std::exception& e) {
+                RASPI_HW_LOG_ERROR("Caught error in save callback: " << e.what());
+            }
+        }
+    }
+}
+
+/**
+ * Write one image with plain POSIX calls. With direct I/O the aligned
+ * part of the buffer bypasses the page cache and the tail is written
+ * normally. Falls back to normal writes when the file system does not
+ * support O_DIRECT. rgb and rgba frames going to a .qoi path are
+ * encoded here and written a chunk at a time as they are encoded.
+ *
+ * @param job The job to write.
+ * @param fd Set to the open file when the per_batch policy keeps it open, else -1.
+ * @param written Set to the number of bytes written to the file.
+ * @return true if the image was written, else false.
+ */
+bool ImageWriter::write_file(const Job& job, int& fd, size_t& written) const {
+    ScopedLatency latency(MetricTimer::save);
+    fd = -1;
+    written = 0;
+    // Crop views are packed first so the file gets one block of pixels.
+    const Image image = job.image.is_contiguous() ? job.image : job.image.clone();
+    if (image.get_data() == nullptr || image.get_size() == 0) {
+        RASPI_HW_LOG_WARN("Error: No data to save!");
+        return false;
+    }
+    if (!image.check_save_extension(job.file_path)) {
+        return false;
+    }
+    const unsigned char* data = image.get_data();
+    const size_t size = image.get_size();
+    // Raw frames going to a .qoi path are encoded here, on the writer thread.
+    const bool encode = has_qoi_extension(job.file_path) && can_encode_qoi(image);
+    constexpr int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    size_t direct_size = 0;
+    if (!encode && config.direct_io && reinterpret_cast<uintptr_t>(data) % direct_alignment == 0) {
+        direct_size = size - size % direct_alignment;
+    }
+    int file = -1;
+    if (direct_size > 0) {
+        file = open(job.file_path.c_str(), flags | O_DIRECT, 0644);
+        if (file < 0) {
+            direct_size = 0;
+        }
+    }
+    if (file < 0) {
+        file = open(job.file_path.c_str(), flags, 0644);
+    }
+    if (file < 0) {
+        RASPI_HW_LOG_ERROR("Failed to open file for writing!");
+        return false;
+    }
+    bool ok = true;
+    if (encode) {
+        ok = encode_qoi(image, [file, &written](const unsigned char* chunk, const size_t length) {
+            written += length;
+            return write_all(file, chunk, length);
+        });
+    } else {
+        size_t offset = 0;
+        if (direct_size > 0) {
+            if (write_all(file, data, direct_size)) {
+                offset = direct_size;
+            } else if (errno != EINVAL || lseek(file, 0, SEEK_SET) != 0) {
+                ok = false;
+            }
+            fcntl(file, F_SETFL, fcntl(file, F_GETFL) & ~O_DIRECT);
+        }
+        ok = ok && write_all(file, data + offset, size - offset);
+        written = size;
+    }
+    if (ok && config.fsync_policy == FsyncPolicy::per_file) {
+        ok = fdatasync(file) == 0;
+    }
+    if (!ok) {
+        RASPI_HW_LOG_ERROR("Failed to write " << job.file_path);
+    }
+    if (ok && config.fsync_policy == FsyncPolicy::per_batch) {
+        fd = file;
+    } else {
+        close(file);
+    }
+    return ok;
+}
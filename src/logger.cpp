@@ -0,0 +1,116 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include "logger.h"
+
+using namespace std;
+
+namespace {
+
+// Keeps lines from different threads from interleaving.
+mutex write_mutex;
+
+}
+
+/**
+ * Get the process wide logger.
+ *
+ * @return The logger.
+ */
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+/**
+ * Start at info unless RASPI_HW_LOG_LEVEL names another level.
+ */
+Logger::Logger() : level(static_cast<uint8_t>(LogLevel::info)) {
+    const char* name = getenv("RASPI_HW_LOG_LEVEL");
+    if (name != nullptr && *name != '\0') {
+        try {
+            level.store(static_cast<uint8_t>(log_level_from_name(name)));
+        } catch (const invalid_argument&) {
+            cerr << "Unknown RASPI_HW_LOG_LEVEL " << name << ", using info." << '\n';
+        }
+    }
+}
+
+/**
+ * Set the lowest level that is written. Levels removed at compile
+ * time stay removed.
+ *
+ * @param new_level The level.
+ */
+void Logger::set_level(const LogLevel new_level) {
+    level.store(static_cast<uint8_t>(new_level), memory_order_relaxed);
+}
+
+/**
+ * Get the lowest level that is written.
+ *
+ * @return The level.
+ */
+LogLevel Logger::get_level() const {
+    return static_cast<LogLevel>(level.load(memory_order_relaxed));
+}
+
+/**
+ * Write one line. Does not flush stdout, so logging from the capture
+ * path does not wait on the terminal.
+ *
+ * @param message_level The level of the message.
+ * @param message The message, without a trailing newline.
+ */
+void Logger::write(const LogLevel message_level, const string& message) {
+    if (!is_enabled(message_level)) {
+        return;
+    }
+    lock_guard lock(write_mutex);
+    if (message_level >= LogLevel::warn) {
+        cerr << message << '\n';
+    } else {
+        cout << message << '\n';
+    }
+}
+
+/**
+ * Get a log level by name.
+ *
+ * @param name debug, info, warn, error, or off.
+ * @return The level.
+ * @throws std::invalid_argument if the name is unknown.
+ */
+LogLevel log_level_from_name(const string& name) {
+    for (const LogLevel level : {LogLevel::debug, LogLevel::info, LogLevel::warn, LogLevel::error, LogLevel::off}) {
+        if (name == log_level_name(level)) {
+            return level;
+        }
+    }
+    throw invalid_argument("Use debug, info, warn, error, or off instead.");
+}
+
+/**
+ * Get the name of a log level.
+ *
+ * @param level The level.
+ * @return The name.
+ */
+const char* log_level_name(const LogLevel level) {
+    switch (level) {
+        case LogLevel::debug:
+            return "debug";
+        case LogLevel::info:
+            return "info";
+        case LogLevel::warn:
+            return "warn";
+        case LogLevel::error:
+            return "error";
+        default:
+            return "off";
+    }
+}
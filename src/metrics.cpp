@@ -0,0 +1,271 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <limits>
+#include "metrics.h"
+
+using namespace std;
+
+namespace {
+
+constexpr size_t timer_count = static_cast<size_t>(MetricTimer::count);
+constexpr size_t counter_count = static_cast<size_t>(MetricCounter::count);
+
+atomic<bool> metrics_enabled(true);
+LatencyHistogram timers[timer_count];
+atomic<uint64_t> counters[counter_count];
+
+/**
+ * Get the latency at a percentile from a histogram copy.
+ *
+ * @param snapshot The histogram copy with its buckets filled.
+ * @param fraction The percentile as a fraction, 0.5 for the median.
+ * @return The upper edge of the bucket the percentile falls in, capped at the max.
+ */
+int64_t get_percentile_ns(const HistogramSnapshot& snapshot, const double fraction) {
+    if (snapshot.count == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<uint64_t>(fraction * static_cast<double>(snapshot.count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < snapshot.buckets.size(); ++bucket) {
+        seen += snapshot.buckets[bucket];
+        if (seen >= rank) {
+            return min((int64_t{2} << bucket) - 1, snapshot.max_ns);
+        }
+    }
+    return snapshot.max_ns;
+}
+
+}
+
+/**
+ * Start empty.
+ */
+LatencyHistogram::LatencyHistogram()
+    : count(0), sum_ns(0), min_ns(numeric_limits<int64_t>::max()), max_ns(numeric_limits<int64_t>::min()),
+      buckets() {
+}
+
+/**
+ * Add one sample.
+ *
+ * @param latency_ns The latency in nanoseconds. Negative values count as 0.
+ */
+void LatencyHistogram::record(int64_t latency_ns) {
+    latency_ns = max<int64_t>(latency_ns, 0);
+    const size_t bucket = min<size_t>(latency_ns > 0 ? 63 - __builtin_clzll(static_cast<uint64_t>(latency_ns)) : 0,
+                                      bucket_count - 1);
+    buckets[bucket].fetch_add(1, memory_order_relaxed);
+    count.fetch_add(1, memory_order_relaxed);
+    sum_ns.fetch_add(latency_ns, memory_order_relaxed);
+    int64_t current = min_ns.load(memory_order_relaxed);
+    while (latency_ns < current && !min_ns.compare_exchange_weak(current, latency_ns, memory_order_relaxed)) {
+    }
+    current = max_ns.load(memory_order_relaxed);
+    while (latency_ns > current && !max_ns.compare_exchange_weak(current, latency_ns, memory_order_relaxed)) {
+    }
+}
+
+/**
+ * Drop all samples.
+ */
+void LatencyHistogram::reset() {
+    for (atomic<uint64_t>& bucket : buckets) {
+        bucket.store(0, memory_order_relaxed);
+    }
+    count.store(0, memory_order_relaxed);
+    sum_ns.store(0, memory_order_relaxed);
+    min_ns.store(numeric_limits<int64_t>::max(), memory_order_relaxed);
+    max_ns.store(numeric_limits<int64_t>::min(), memory_order_relaxed);
+}
+
+/**
+ * Get the number of samples.
+ *
+ * @return The sample count.
+ */
+uint64_t LatencyHistogram::get_count() const {
+    return count.load(memory_order_relaxed);
+}
+
+/**
+ * Get the sum of all samples.
+ *
+ * @return The sum in nanoseconds.
+ */
+int64_t LatencyHistogram::get_sum_ns() const {
+    return sum_ns.load(memory_order_relaxed);
+}
+
+/**
+ * Get the smallest sample.
+ *
+ * @return The smallest latency in nanoseconds, or 0 if there are no samples.
+ */
+int64_t LatencyHistogram::get_min_ns() const {
+    return get_count() == 0 ? 0 : min_ns.load(memory_order_relaxed);
+}
+
+/**
+ * Get the largest sample.
+ *
+ * @return The largest latency in nanoseconds, or 0 if there are no samples.
+ */
+int64_t LatencyHistogram::get_max_ns() const {
+    return get_count() == 0 ? 0 : max_ns.load(memory_order_relaxed);
+}
+
+/**
+ * Get the number of samples in one bucket.
+ *
+ * @param bucket The bucket index, less than bucket_count.
+ * @return The sample count of the bucket.
+ */
+uint64_t LatencyHistogram::get_bucket(const size_t bucket) const {
+    return buckets[bucket].load(memory_order_relaxed);
+}
+
+/**
+ * Add a latency sample to one of the process wide timers.
+ *
+ * @param timer The timer.
+ * @param latency_ns The latency in nanoseconds.
+ */
+void record_latency(const MetricTimer timer, const int64_t latency_ns) {
+    if (metrics_enabled.load(memory_order_relaxed)) {
+        timers[static_cast<size_t>(timer)].record(latency_ns);
+    }
+}
+
+/**
+ * Add to one of the process wide counters.
+ *
+ * @param counter The counter.
+ * @param amount How much to add.
+ */
+void add_to_counter(const MetricCounter counter, const uint64_t amount) {
+    if (metrics_enabled.load(memory_order_relaxed)) {
+        counters[static_cast<size_t>(counter)].fetch_add(amount, memory_order_relaxed);
+    }
+}
+
+/**
+ * Copy all timers and counters. Samples recorded while copying may
+ * land in some timers and not others.
+ *
+ * @return The copy, keyed by metric name.
+ */
+MetricsSnapshot get_metrics_snapshot() {
+    MetricsSnapshot snapshot;
+    for (size_t i = 0; i < timer_count; ++i) {
+        const LatencyHistogram& histogram = timers[i];
+        HistogramSnapshot timer;
+        timer.buckets.resize(LatencyHistogram::bucket_count);
+        for (size_t bucket = 0; bucket < LatencyHistogram::bucket_count; ++bucket) {
+            timer.buckets[bucket] = histogram.get_bucket(bucket);
+            timer.count += timer.buckets[bucket];
+        }
+        timer.sum_ns = histogram.get_sum_ns();
+        timer.min_ns = histogram.get_min_ns();
+        timer.max_ns = histogram.get_max_ns();
+        timer.mean_ns = timer.count == 0 ? 0 : static_cast<double>(timer.sum_ns) / static_cast<double>(timer.count);
+        timer.p50_ns = get_percentile_ns(timer, 0.5);
+        timer.p90_ns = get_percentile_ns(timer, 0.9);
+        timer.p99_ns = get_percentile_ns(timer, 0.99);
+        snapshot.timers[metric_timer_name(static_cast<MetricTimer>(i))] = std::move(timer);
+    }
+    for (size_t i = 0; i < counter_count; ++i) {
+        snapshot.counters[metric_counter_name(static_cast<MetricCounter>(i))] = counters[i].load(memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+/**
+ * Zero all timers and counters.
+ */
+void reset_metrics() {
+    for (LatencyHistogram& histogram : timers) {
+        histogram.reset();
+    }
+    for (atomic<uint64_t>& counter : counters) {
+        counter.store(0, memory_order_relaxed);
+    }
+}
+
+/**
+ * Turn recording on or off. When off, timers do not read the clock.
+ *
+ * @param enabled true to record, false to skip.
+ */
+void set_metrics_enabled(const bool enabled) {
+    metrics_enabled.store(enabled, memory_order_relaxed);
+}
+
+/**
+ * Get whether metrics are recorded.
+ *
+ * @return true if recording, else false.
+ */
+bool get_metrics_enabled() {
+    return metrics_enabled.load(memory_order_relaxed);
+}
+
+/**
+ * Get the name of a timer, as used in snapshots.
+ *
+ * @param timer The timer.
+ * @return The name.
+ */
+const char* metric_timer_name(const MetricTimer timer) {
+    switch (timer) {
+        case MetricTimer::capture:
+            return "capture";
+        case MetricTimer::camera_open:
+            return "camera_open";
+        case MetricTimer::camera_switch:
+            return "camera_switch";
+        case MetricTimer::first_frame:
+            return "first_frame";
+        case MetricTimer::header_strip:
+            return "header_strip";
+        case MetricTimer::flip:
+            return "flip";
+        case MetricTimer::save:
+            return "save";
+        case MetricTimer::encode:
+            return "encode";
+        case MetricTimer::step:
+            return "step";
+        case MetricTimer::move:
+            return "move";
+        case MetricTimer::step_lateness:
+            return "step_lateness";
+        default:
+            return "";
+    }
+}
+
+/**
+ * Get the name of a counter, as used in snapshots.
+ *
+ * @param counter The counter.
+ * @return The name.
+ */
+const char* metric_counter_name(const MetricCounter counter) {
+    switch (counter) {
+        case MetricCounter::frames_captured:
+            return "frames_captured";
+        case MetricCounter::capture_failures:
+            return "capture_failures";
+        case MetricCounter::frames_dropped:
+            return "frames_dropped";
+        case MetricCounter::allocated_bytes:
+            return "allocated_bytes";
+        case MetricCounter::steps:
+            return "steps";
+        default:
+            return "";
+    }
+}
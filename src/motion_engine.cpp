@@ -0,0 +1,299 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <stdexcept>
+#include "motion_engine.h"
+#include "logger.h"
+#include "metrics.h"
+#include "realtime_thread.h"
+
+using namespace std;
+
+/**
+ * Start the motion thread. It waits for commands without using the CPU.
+ *
+ * @param step Called once per step on the motion thread with the direction
+ *             and the index of the step within its command. Can be empty
+ *             if every command brings its own.
+ * @param config How to schedule the motion thread.
+ */
+MotionEngine::MotionEngine(StepFunction step, const MotionEngineConfig& config)
+    : step(std::move(step)), config(config), busy(false), stopping(false), stop_requested(false),
+      cancel_requested(false), position(0), is_pinned(false), is_realtime(false), step_count(0), error_count(0),
+      next_deadline_ns(0), lateness_sum_ns(0) {
+    motion_thread = thread(&MotionEngine::motion_loop, this);
+}
+
+/**
+ * Stop the motion thread. Commands still queued are not run and
+ * their futures get false.
+ */
+MotionEngine::~MotionEngine() {
+    {
+        lock_guard lock(mutex);
+        stopping = true;
+    }
+    stop_requested.store(true);
+    work_ready.notify_all();
+    if (motion_thread.joinable()) {
+        motion_thread.join();
+    }
+    for (Job& job : jobs) {
+        job.promise.set_value(false);
+    }
+}
+
+/**
+ * Queue a command to run after the ones already queued. Returns
+ * right away. Back to back commands keep the step spacing.
+ *
+ * @param command The steps to run.
+ * @return A future that becomes true when every step has run, or false
+ *         if the command was stopped first. If a step function throws,
+ *         the command ends there and the future holds the exception.
+ * @throws std::invalid_argument if step delays are given but not one per step.
+ */
+future<bool> MotionEngine::queue(StepCommand command) {
+    if (!command.step_delays_us.empty() && command.step_delays_us.size() != command.steps) {
+        throw invalid_argument("Step command needs one delay per step.");
+    }
+    Job job{std::move(command), promise<bool>()};
+    future<bool> result = job.promise.get_future();
+    if (job.command.steps == 0) {
+        job.promise.set_value(true);
+        return result;
+    }
+    {
+        lock_guard lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    work_ready.notify_one();
+    return result;
+}
+
+/**
+ * Stop the running command after its current step and drop every
+ * queued command. Their futures get false. Waits until the motor
+ * has stopped, which is at most one step delay.
+ */
+void MotionEngine::stop() {
+    deque<Job> dropped;
+    unique_lock lock(mutex);
+    dropped.swap(jobs);
+    if (busy) {
+        cancel_requested.store(true);
+    }
+    idle.wait(lock, [this] { return !busy || stopping; });
+    lock.unlock();
+    for (Job& job : dropped) {
+        job.promise.set_value(false);
+    }
+}
+
+/**
+ * Wait until every queued command has run.
+ */
+void MotionEngine::wait_idle() {
+    unique_lock lock(mutex);
+    idle.wait(lock, [this] { return (jobs.empty() && !busy) || stopping; });
+}
+
+/**
+ * Get whether there is nothing queued or running.
+ *
+ * @return true if idle, else false.
+ */
+bool MotionEngine::is_idle() const {
+    lock_guard lock(mutex);
+    return jobs.empty() && !busy;
+}
+
+/**
+ * Get the position, counted in steps since the engine started
+ * or since the last set_position().
+ *
+ * @return The position in steps.
+ */
+int64_t MotionEngine::get_position() const {
+    return position.load();
+}
+
+/**
+ * Set the position, for example after homing. Should only be
+ * called while idle, else steps in flight are counted on top.
+ *
+ * @param new_position The position in steps.
+ */
+void MotionEngine::set_position(const int64_t new_position) {
+    position.store(new_position);
+}
+
+/**
+ * Get whether the motion thread was pinned to a core.
+ *
+ * @return true if pinned, else false.
+ */
+bool MotionEngine::get_is_pinned() const {
+    return is_pinned.load();
+}
+
+/**
+ * Get whether the motion thread got SCHED_FIFO.
+ *
+ * @return true if realtime, else false.
+ */
+bool MotionEngine::get_is_realtime() const {
+    return is_realtime.load();
+}
+
+/**
+ * Get the number of steps run since the engine started.
+ *
+ * @return The step count.
+ */
+uint64_t MotionEngine::get_step_count() const {
+    return step_count.load();
+}
+
+/**
+ * Get the number of commands that ended because a step function threw.
+ *
+ * @return The error count.
+ */
+uint64_t MotionEngine::get_error_count() const {
+    return error_count.load();
+}
+
+/**
+ * Get the step timing statistics since the last reset.
+ *
+ * @return The jitter statistics.
+ */
+JitterStats MotionEngine::get_jitter_stats() const {
+    lock_guard lock(stats_mutex);
+    return stats;
+}
+
+/**
+ * Clear the step timing statistics.
+ */
+void MotionEngine::reset_jitter_stats() {
+    lock_guard lock(stats_mutex);
+    stats = JitterStats();
+    lateness_sum_ns = 0;
+}
+
+/**
+ * Set up scheduling for the motion thread, then run commands as they are queued.
+ */
+void MotionEngine::motion_loop() {
+    if (config.pin_thread) {
+        const int core_count = static_cast<int>(thread::hardware_concurrency());
+        const int core = config.cpu_core >= 0 ? config.cpu_core : max(core_count - 1, 0);
+        is_pinned.store(pin_current_thread(core));
+    }
+    if (config.realtime) {
+        is_realtime.store(set_current_thread_fifo(config.realtime_priority));
+        if (!is_realtime.load()) {
+            RASPI_HW_LOG_WARN("Motion thread is not realtime, step timing may jitter.");
+        }
+    }
+    unique_lock lock(mutex);
+    while (true) {
+        work_ready.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping) {
+            break;
+        }
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        busy = true;
+        lock.unlock();
+        // Nothing above this thread can catch, so a throwing step function ends its command, not the process.
+        try {
+            job.promise.set_value(run_command(job.command));
+        } catch (const exception& error) {
+            RASPI_HW_LOG_ERROR("Motion command failed: " << error.what());
+            error_count.fetch_add(1, memory_order_relaxed);
+            job.promise.set_exception(current_exception());
+        } catch (...) {
+            RASPI_HW_LOG_ERROR("Motion command failed.");
+            error_count.fetch_add(1, memory_order_relaxed);
+            job.promise.set_exception(current_exception());
+        }
+        lock.lock();
+        busy = false;
+        cancel_requested.store(false);
+        if (jobs.empty()) {
+            idle.notify_all();
+        }
+    }
+    busy = false;
+    idle.notify_all();
+}
+
+/**
+ * Run the steps of one command against absolute deadlines. The first
+ * step waits for the delay after the last step of the previous command.
+ *
+ * @param command The steps to run.
+ * @return true if every step ran, false if stopped first.
+ */
+bool MotionEngine::run_command(const StepCommand& command) {
+    ScopedLatency latency(MetricTimer::move);
+    const bool has_delays = !command.step_delays_us.empty();
+    int64_t deadline_ns = max(monotonic_now_ns(), next_deadline_ns);
+    const int64_t increment = command.position_increment;
+    const int64_t position_change = command.direction == 1 ? increment : -increment;
+    int64_t delay_ns = 0;
+    for (uint32_t step_index = 0; step_index < command.steps; ++step_index) {
+        if (stop_requested.load(memory_order_relaxed) || cancel_requested.load(memory_order_relaxed)) {
+            next_deadline_ns = deadline_ns;
+            return false;
+        }
+        sleep_until_ns(deadline_ns);
+        if (step_index > 0) {
+            record_lateness(monotonic_now_ns() - deadline_ns, delay_ns);
+        }
+        {
+            ScopedLatency step_latency(MetricTimer::step);
+            if (command.on_step) {
+                command.on_step(command.direction, step_index);
+            } else if (step) {
+                step(command.direction, step_index);
+            }
+        }
+        add_to_counter(MetricCounter::steps);
+        position.fetch_add(position_change, memory_order_relaxed);
+        step_count.fetch_add(1, memory_order_relaxed);
+        const uint32_t delay_us = has_delays ? command.step_delays_us[step_index] : command.step_interval_us;
+        delay_ns = static_cast<int64_t>(delay_us) * 1000;
+        deadline_ns += delay_ns;
+    }
+    next_deadline_ns = deadline_ns;
+    return true;
+}
+
+/**
+ * Add one step to the timing statistics.
+ *
+ * @param lateness_ns How long after its deadline the step fired.
+ * @param delay_ns The delay before the step.
+ */
+void MotionEngine::record_lateness(const int64_t lateness_ns, const int64_t delay_ns) {
+    record_latency(MetricTimer::step_lateness, lateness_ns);
+    lock_guard lock(stats_mutex);
+    if (stats.sample_count == 0) {
+        stats.min_ns = lateness_ns;
+        stats.max_ns = lateness_ns;
+    } else {
+        stats.min_ns = min(stats.min_ns, lateness_ns);
+        stats.max_ns = max(stats.max_ns, lateness_ns);
+    }
+    ++stats.sample_count;
+    lateness_sum_ns += lateness_ns;
+    stats.mean_ns = static_cast<double>(lateness_sum_ns) / static_cast<double>(stats.sample_count);
+    if (lateness_ns * 2 > delay_ns) {
+        ++stats.overrun_count;
+    }
+}
@@ -0,0 +1,182 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include "motion_profile.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Round a time in seconds to whole microseconds, at least 1.
+ */
+uint32_t to_us(const double seconds) {
+    return static_cast<uint32_t>(max(llround(seconds * 1e6), 1LL));
+}
+
+/**
+ * Time to change speed from v0 to v1 under the jerk limit. The
+ * acceleration ramps up, holds at the limit if there is room, then
+ * ramps down, so the average speed is halfway between v0 and v1.
+ */
+double s_curve_ramp_time(const double v0, const double v1, const double acceleration, const double jerk) {
+    const double dv = v1 - v0;
+    if (dv <= 0) {
+        return 0;
+    }
+    if (dv >= acceleration * acceleration / jerk) {
+        return dv / acceleration + acceleration / jerk;
+    }
+    return 2 * sqrt(dv / jerk);
+}
+
+/**
+ * Distance covered while ramping from v0 to v1.
+ */
+double ramp_distance(const MotionProfileConfig& config, const double v1) {
+    const double v0 = config.start_velocity;
+    if (config.shape == ProfileShape::trapezoidal) {
+        return (v1 * v1 - v0 * v0) / (2 * config.max_acceleration);
+    }
+    return (v0 + v1) / 2 * s_curve_ramp_time(v0, v1, config.max_acceleration, config.max_jerk);
+}
+
+/**
+ * Speed at time t into an s-curve ramp from v0 to v1.
+ */
+double s_curve_velocity(const double t, const double v0, const double v1, const double acceleration,
+                        const double jerk) {
+    const double total = s_curve_ramp_time(v0, v1, acceleration, jerk);
+    const double dv = v1 - v0;
+    const double jerk_time = dv >= acceleration * acceleration / jerk ? acceleration / jerk : total / 2;
+    const double peak = jerk * jerk_time;
+    if (t <= jerk_time) {
+        return v0 + jerk * t * t / 2;
+    }
+    if (t <= total - jerk_time) {
+        return v0 + jerk * jerk_time * jerk_time / 2 + peak * (t - jerk_time);
+    }
+    const double remaining = max(total - t, 0.0);
+    return v1 - jerk * remaining * remaining / 2;
+}
+
+/**
+ * Times at which the ramp from start_velocity to peak crosses each
+ * whole step, starting with 0 for the first step.
+ */
+vector<double> ramp_step_times(const MotionProfileConfig& config, const double peak, const uint32_t ramp_steps) {
+    vector<double> times(ramp_steps + 1, 0);
+    const double v0 = config.start_velocity;
+    if (config.shape == ProfileShape::trapezoidal) {
+        const double a = config.max_acceleration;
+        for (uint32_t step = 1; step <= ramp_steps; ++step) {
+            times[step] = (sqrt(v0 * v0 + 2 * a * step) - v0) / a;
+        }
+        return times;
+    }
+    // No closed form for position against time, so integrate in small slices.
+    const double total = s_curve_ramp_time(v0, peak, config.max_acceleration, config.max_jerk);
+    const double dt = min(1e-5, total / 1000);
+    double t = 0;
+    double position = 0;
+    double velocity = v0;
+    uint32_t step = 1;
+    while (step <= ramp_steps && t < total) {
+        const double next_t = min(t + dt, total);
+        const double next_velocity = s_curve_velocity(next_t, v0, peak, config.max_acceleration, config.max_jerk);
+        const double next_position = position + (velocity + next_velocity) / 2 * (next_t - t);
+        while (step <= ramp_steps && next_position >= step) {
+            times[step] = t + (step - position) / (next_position - position) * (next_t - t);
+            ++step;
+        }
+        t = next_t;
+        position = next_position;
+        velocity = next_velocity;
+    }
+    for (; step <= ramp_steps; ++step) {
+        times[step] = times[step - 1] + 1 / peak;
+    }
+    return times;
+}
+
+}
+
+/**
+ * Work out how long each step of a move takes. Entry i is the time
+ * from step i to step i + 1, and the last entry is the time after the
+ * final step before the motor can take another. The ramp down mirrors
+ * the ramp up. Short moves ramp down before reaching max_velocity.
+ * Constant moves take every step at start_velocity.
+ *
+ * @param steps The number of steps in the move.
+ * @param config The speed limits.
+ * @return The step delays in microseconds, one per step.
+ * @throws std::invalid_argument if a limit is not positive, or
+ *         start_velocity is above max_velocity.
+ */
+vector<uint32_t> build_step_delays(const uint32_t steps, const MotionProfileConfig& config) {
+    if (config.max_velocity <= 0) {
+        throw invalid_argument("max_velocity must be positive.");
+    }
+    const uint32_t start_interval_us = get_step_interval_us(config);
+    if (config.shape == ProfileShape::constant || steps == 0) {
+        return vector<uint32_t>(steps, start_interval_us);
+    }
+    if (config.max_acceleration <= 0 || (config.shape == ProfileShape::s_curve && config.max_jerk <= 0)) {
+        throw invalid_argument("Profile needs positive limits.");
+    }
+    vector<uint32_t> delays(steps);
+    // Fastest speed the move can reach and still ramp down in time.
+    double peak = config.max_velocity;
+    if (2 * ramp_distance(config, peak) > steps) {
+        double low = config.start_velocity;
+        double high = config.max_velocity;
+        for (int i = 0; i < 50; ++i) {
+            const double middle = (low + high) / 2;
+            if (2 * ramp_distance(config, middle) > steps) {
+                high = middle;
+            } else {
+                low = middle;
+            }
+        }
+        peak = low;
+    }
+    const auto ramp_steps = min(static_cast<uint32_t>(ramp_distance(config, peak)), steps / 2);
+    const vector<double> times = ramp_step_times(config, peak, ramp_steps);
+    fill(delays.begin(), delays.end(), to_us(1 / peak));
+    for (uint32_t step = 0; step < ramp_steps; ++step) {
+        const uint32_t delay = to_us(times[step + 1] - times[step]);
+        delays[step] = delay;
+        delays[steps - 1 - step] = delay;
+    }
+    return delays;
+}
+
+/**
+ * Get the time between steps of a constant move, which runs at
+ * start_velocity the whole way.
+ *
+ * @param config The speed limits.
+ * @return The step interval in microseconds.
+ * @throws std::invalid_argument if start_velocity is not positive or is above max_velocity.
+ */
+uint32_t get_step_interval_us(const MotionProfileConfig& config) {
+    if (config.start_velocity <= 0 || config.start_velocity > config.max_velocity) {
+        throw invalid_argument("Profile needs 0 < start_velocity <= max_velocity.");
+    }
+    return to_us(1 / config.start_velocity);
+}
+
+/**
+ * Get the total time of a move.
+ *
+ * @param step_delays_us The step delays from build_step_delays.
+ * @return The move time in microseconds.
+ */
+uint64_t get_move_time_us(const vector<uint32_t>& step_delays_us) {
+    return accumulate(step_delays_us.begin(), step_delays_us.end(), uint64_t{0});
+}
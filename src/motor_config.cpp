@@ -12,14 +12,11 @@ MotorConfig::MotorConfig()
     : steps_per_rev(4096),
       step_delay_ms(2),
       w_pi_pins{25, 24, 23, 22},
-      step_sequence{{
-          {1,0,0,1},
-          {1,0,0,0},
-          {1,1,0,0},
-          {0,1,0,0},
-          {0,1,1,0},
-          {0,0,1,0},
-          {0,0,1,1},
-          {0,0,0,1}
-      }} {
+      drive_mode(DriveMode::half_step) {
+    // Constant moves and the start of ramped moves run at the step_delay_ms speed, which the motor can always
+    // start at.
+    profile.start_velocity = 1000.0 / step_delay_ms;
+    profile.max_velocity = 1000;
+    profile.max_acceleration = 2000;
+    profile.max_jerk = 20000;
 }
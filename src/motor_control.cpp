@@ -1,24 +1,40 @@
 //
 // Created by Joe Pettinelli on 2/17/25.
 //
-#include <iostream>
-#include <chrono>
-#include <thread>
-#include <wiringPi.h>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
 #include "motor_control.h"
+#include "logger.h"
 
 using namespace std;
 
 /**
- * Initialize the motor once at beginning of program.
- * Make sure setup is successful and then set pins to output mode.
+ * Initialize the motor once at beginning of program using the default
+ * GPIO backend, wiringPi unless the build or RASPI_HW_GPIO says otherwise.
  */
-MotorController::MotorController() {
-    if (wiringPiSetup() == -1) {
-        cerr << "Initialize motor failed." << endl;
+MotorController::MotorController() : MotorController(make_gpio_backend(get_default_gpio_backend_name())) {
+}
+
+/**
+ * Initialize the motor once at beginning of program using the given
+ * GPIO backend. Make sure setup is successful, then start the motion
+ * thread. Set pins to output mode before rotating.
+ *
+ * @param backend The GPIO device driving the motor pins.
+ * @param engine_config How to schedule the motion thread.
+ */
+MotorController::MotorController(unique_ptr<GpioBackend> backend, const MotionEngineConfig& engine_config)
+    : gpio(std::move(backend)), sequence(step_sequence_for(config.drive_mode)), phase(0), target_position(0),
+      planned_position(0), planned_phase(0) {
+    if (!gpio->setup()) {
+        RASPI_HW_LOG_ERROR("Initialize motor failed.");
     } else {
-        cout << "Initialize motor success." << endl << endl;
+        RASPI_HW_LOG_INFO("Initialize motor success.");
     }
+    // Every command brings its own step function, see queue_steps().
+    engine = make_unique<MotionEngine>(nullptr, engine_config);
 }
 
 /**
@@ -26,80 +42,420 @@ MotorController::MotorController() {
  */
 void MotorController::set_to_output_mode() const {
     for (const unsigned int w_pi_pin : config.w_pi_pins) {
-        pinMode(w_pi_pin, OUTPUT);
+        gpio->set_mode(w_pi_pin, PinMode::output);
     }
 }
 
 /**
  * Set the current pins to input mode when done using them.
+ * Saves the position first if a position file is set.
  */
 void MotorController::cleanup() const {
+    if (!config.position_file.empty() && !save_position(config.position_file)) {
+        RASPI_HW_LOG_WARN("Save motor position failed.");
+    }
     for (const unsigned int w_pi_pin : config.w_pi_pins) {
-        pinMode(w_pi_pin, INPUT);
+        gpio->set_mode(w_pi_pin, PinMode::input);
     }
-    cout << "Cleanup motor success." << endl;
+    RASPI_HW_LOG_INFO("Cleanup motor success.");
 }
 
 /**
  * Rotate the motor in either direction for certain number
- * of degrees.
+ * of degrees. Waits until the move and any moves queued
+ * before it are done.
  *
  * @param degrees Degrees to rotate the motor.
  * @param direction The direction to rotate the motor.
  */
-void MotorController::rotate(const unsigned int degrees, const int direction) const {
-    const unsigned int num_steps = (config.steps_per_rev * degrees) / 360;
-    int semi_step_counter = 0;
-    for (int step = 0; step < num_steps; step++) {
-        if (direction == 1) {
-            clockwise_step(semi_step_counter);
-        } else {
-            counter_clockwise_step(semi_step_counter);
+void MotorController::rotate(const unsigned int degrees, const int direction) {
+    rotate_async(degrees, direction).wait();
+}
+
+/**
+ * Queue a rotation and return right away. Same as move_by_async()
+ * with the direction as the sign.
+ *
+ * @param degrees Degrees to rotate the motor.
+ * @param direction The direction to rotate the motor.
+ * @return A future that becomes true when the move is done, or false if it was stopped.
+ */
+future<bool> MotorController::rotate_async(const unsigned int degrees, const int direction) {
+    return move_by_async(direction == 1 ? degrees : -static_cast<double>(degrees));
+}
+
+/**
+ * Rotate by an angle and wait until done.
+ *
+ * @param degrees Degrees to rotate, negative for counter-clockwise.
+ */
+void MotorController::move_by(const double degrees) {
+    move_by_async(degrees).wait();
+}
+
+/**
+ * Queue a rotation by an angle and return right away. The steps
+ * run on the motion thread after any moves already queued. The
+ * target is kept to a fraction of a step, so the part of a step
+ * that does not fit in this move is taken by a later one.
+ *
+ * @param degrees Degrees to rotate, negative for counter-clockwise.
+ * @return A future that becomes true when the move is done, or false if it was stopped.
+ */
+future<bool> MotorController::move_by_async(const double degrees) {
+    lock_guard lock(plan_mutex);
+    return move_by_locked(degrees);
+}
+
+/**
+ * Rotate to an angle the shortest way round and wait until done.
+ *
+ * @param angle The angle from home in degrees.
+ */
+void MotorController::move_to(const double angle) {
+    move_to_async(angle).wait();
+}
+
+/**
+ * Queue a rotation to an angle the shortest way round and return
+ * right away. Angles are measured from home, and the move starts
+ * from where the moves already queued end.
+ *
+ * @param angle The angle from home in degrees.
+ * @return A future that becomes true when the move is done, or false if it was stopped.
+ */
+future<bool> MotorController::move_to_async(const double angle) {
+    lock_guard lock(plan_mutex);
+    const double current_angle = target_position * 360 / config.steps_per_rev;
+    return move_by_locked(remainder(angle - current_angle, 360.0));
+}
+
+/**
+ * Step toward home one step at a time until at_home() is true, then
+ * make that position 0. at_home() is called on this thread before
+ * every step, so it can read a switch or sensor.
+ *
+ * @param at_home Returns true when the motor is at home.
+ * @param max_degrees How far to look for home before giving up.
+ * @param direction The direction to look in.
+ * @return true if home was found, false if not found or stopped.
+ */
+bool MotorController::home(const function<bool()>& at_home, const unsigned int max_degrees, const int direction) {
+    int64_t step_size = 0;
+    int64_t max_steps = 0;
+    {
+        lock_guard lock(plan_mutex);
+        step_size = sequence.half_steps_per_step;
+        max_steps = static_cast<int64_t>(config.steps_per_rev) * max_degrees / 360 / step_size;
+    }
+    const int64_t step_change = direction == 1 ? step_size : -step_size;
+    for (int64_t i = 0; i <= max_steps; ++i) {
+        if (at_home()) {
+            set_home();
+            return true;
         }
-        semi_step_counter = (semi_step_counter + 1) % 8;
-        this_thread::sleep_for(chrono::milliseconds(config.step_delay_ms));
+        if (i == max_steps) {
+            break;
+        }
+        future<bool> moved;
+        {
+            lock_guard lock(plan_mutex);
+            align_phase_locked(direction);
+            planned_position += step_change;
+            target_position = static_cast<double>(planned_position);
+            moved = queue_steps(sequence, step_change);
+        }
+        if (!moved.get()) {
+            return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * Make the current position home, angle 0. Call while the motor is idle.
+ */
+void MotorController::set_home() {
+    lock_guard lock(plan_mutex);
+    engine->set_position(0);
+    planned_position = 0;
+    target_position = 0;
+}
+
+/**
+ * Stop the current move after its step in progress and drop
+ * queued moves. Returns once the motor has stopped. The next
+ * move starts from where the motor stopped.
+ */
+void MotorController::stop() {
+    engine->stop();
+    lock_guard lock(plan_mutex);
+    planned_position = engine->get_position();
+    planned_phase = phase.load();
+    target_position = static_cast<double>(planned_position);
+}
+
+/**
+ * Wait until every queued move is done.
+ */
+void MotorController::wait() const {
+    engine->wait_idle();
+}
+
+/**
+ * Get whether a move is running or queued.
+ *
+ * @return true if moving, else false.
+ */
+bool MotorController::is_moving() const {
+    return !engine->is_idle();
+}
+
+/**
+ * Get the position in half steps from home. Clockwise steps
+ * count up and counter-clockwise steps count down.
+ *
+ * @return The position in half steps.
+ */
+int64_t MotorController::get_position() const {
+    return engine->get_position();
+}
+
+/**
+ * Get the angle from home, not wrapped to one turn.
+ *
+ * @return The angle in degrees.
+ */
+double MotorController::get_angle() const {
+    return static_cast<double>(engine->get_position()) * 360 / config.steps_per_rev;
+}
+
+/**
+ * Keep the position in a file across restarts. Loads the file now
+ * if it exists, and cleanup() saves to it.
+ *
+ * @param file_path The position file, or empty to stop saving.
+ */
+void MotorController::set_position_file(const string& file_path) {
+    config.position_file = file_path;
+    if (!file_path.empty() && ifstream(file_path).good()) {
+        load_position(file_path);
+    }
+}
+
+/**
+ * Save the position and coil phase. Call while the motor is idle.
+ *
+ * @param file_path The file to write.
+ * @return true if saved, else false.
+ */
+bool MotorController::save_position(const string& file_path) const {
+    ofstream file(file_path, ios::trunc);
+    file << engine->get_position() << " " << phase.load() << endl;
+    return file.good();
+}
+
+/**
+ * Load a position saved by save_position(). The coil phase is
+ * restored too, so the first step lines up with where the motor
+ * was left. Call while the motor is idle.
+ *
+ * @param file_path The file to read.
+ * @return true if loaded, else false.
+ */
+bool MotorController::load_position(const string& file_path) {
+    ifstream file(file_path);
+    int64_t saved_position = 0;
+    uint32_t saved_phase = 0;
+    if (!(file >> saved_position >> saved_phase)) {
+        return false;
     }
+    lock_guard lock(plan_mutex);
+    engine->set_position(saved_position);
+    phase.store(saved_phase);
+    planned_phase = saved_phase;
+    planned_position = saved_position;
+    target_position = static_cast<double>(saved_position);
+    return true;
 }
 
 /**
  * Set the pins being used on raspberry pi. Does not clean up
  * the previous pins being used. Should call cleanup() before setting
  * new pins. Also, after this function is called, set_to_output_mode()
- * should be called.
+ * should be called. Moves already queued keep the pins they were
+ * queued with.
  *
  * @param pin1 The first pin.
  * @param pin2 The second pin.
  * @param pin3 The third pin.
  * @param pin4 The fourth pin.
+ * @throws std::invalid_argument if a pin is not a wiringPi pin. The pins are not changed.
  */
 void MotorController::set_pins(const unsigned int pin1, const unsigned int pin2, const unsigned int pin3,
     const unsigned int pin4) {
-    config.w_pi_pins[0] = pin1;
-    config.w_pi_pins[1] = pin2;
-    config.w_pi_pins[2] = pin3;
-    config.w_pi_pins[3] = pin4;
+    const array<unsigned int, 4> pins{pin1, pin2, pin3, pin4};
+    for (const unsigned int pin : pins) {
+        if (!is_wiringpi_pin(pin)) {
+            throw invalid_argument("Motor pin is not a wiringPi pin.");
+        }
+    }
+    lock_guard lock(plan_mutex);
+    config.w_pi_pins = pins;
+}
+
+/**
+ * Set how the coils are driven. Moves already queued keep the
+ * drive mode they were queued with. steps_per_rev stays in half
+ * steps, so wave and full step moves take half as many steps.
+ * Full steps sit on even coil phases and wave steps on odd ones,
+ * so if the motor is between them the next move starts with one
+ * half step, which counts in the position like any other step.
+ *
+ * @param mode The drive mode.
+ */
+void MotorController::set_drive_mode(const DriveMode mode) {
+    lock_guard lock(plan_mutex);
+    config.drive_mode = mode;
+    sequence = step_sequence_for(mode);
+}
+
+/**
+ * Get how the coils are driven.
+ *
+ * @return The drive mode.
+ */
+DriveMode MotorController::get_drive_mode() const {
+    lock_guard lock(plan_mutex);
+    return config.drive_mode;
+}
+
+/**
+ * Set the speed limits of the moves queued from now on. Moves already
+ * queued keep the profile they were queued with. Checked here so a bad
+ * profile fails now instead of on the next move.
+ *
+ * @param profile The motion profile.
+ * @throws std::invalid_argument if the profile limits are invalid.
+ */
+void MotorController::set_motion_profile(const MotionProfileConfig& profile) {
+    build_step_delays(1, profile);
+    lock_guard lock(plan_mutex);
+    config.profile = profile;
+}
+
+/**
+ * Get the speed limits of the moves queued from now on.
+ *
+ * @return A copy of the motion profile.
+ */
+MotionProfileConfig MotorController::get_motion_profile() const {
+    lock_guard lock(plan_mutex);
+    return config.profile;
+}
+
+/**
+ * Get how late steps fired compared to their deadlines.
+ *
+ * @return The jitter statistics.
+ */
+JitterStats MotorController::get_jitter_stats() const {
+    return engine->get_jitter_stats();
+}
+
+/**
+ * Clear the step timing statistics.
+ */
+void MotorController::reset_jitter_stats() const {
+    engine->reset_jitter_stats();
+}
+
+/**
+ * Get whether the motion thread runs with realtime scheduling.
+ *
+ * @return true if realtime, else false.
+ */
+bool MotorController::get_is_realtime() const {
+    return engine->get_is_realtime();
+}
+
+/**
+ * Queue a move by an angle. The plan lock must be held.
+ *
+ * @param degrees Degrees to rotate, negative for counter-clockwise.
+ * @return A future that becomes true when the move is done, or false if it was stopped.
+ */
+future<bool> MotorController::move_by_locked(const double degrees) {
+    target_position += degrees * config.steps_per_rev / 360;
+    const double distance = target_position - static_cast<double>(planned_position);
+    if (llround(distance) != 0) {
+        align_phase_locked(distance > 0 ? 1 : -1);
+    }
+    const auto step_size = static_cast<int64_t>(sequence.half_steps_per_step);
+    const int64_t half_steps =
+        llround((target_position - static_cast<double>(planned_position)) / step_size) * step_size;
+    planned_position += half_steps;
+    return queue_steps(sequence, half_steps);
 }
 
 /**
- * Make a single clockwise step.
+ * Queue one half step if the moves queued so far leave the coil phase
+ * off the table of the current drive mode. Without it, the first step
+ * would move one half step more or less than it counts. The plan lock
+ * must be held.
  *
- * @param semi_step The semi-step ranging from 1-8.
+ * @param direction The direction of the move about to be queued.
  */
-void MotorController::clockwise_step(const unsigned int semi_step) const {
-    digitalWrite(config.w_pi_pins[0], config.step_sequence[semi_step][0]);
-    digitalWrite(config.w_pi_pins[1], config.step_sequence[semi_step][1]);
-    digitalWrite(config.w_pi_pins[2], config.step_sequence[semi_step][2]);
-    digitalWrite(config.w_pi_pins[3], config.step_sequence[semi_step][3]);
+void MotorController::align_phase_locked(const int direction) {
+    if ((planned_phase - sequence.phase_parity) % sequence.half_steps_per_step == 0) {
+        return;
+    }
+    const int64_t half_step = direction == 1 ? 1 : -1;
+    planned_position += half_step;
+    queue_steps(step_sequence_for(DriveMode::half_step), half_step);
+}
+
+/**
+ * Queue a run of steps with the given step table and the current pins
+ * and profile. The step table and pins are copied into the command, so
+ * changing them later does not touch a move the motion thread is
+ * running. The plan lock must be held.
+ *
+ * @param step_sequence The step table of the drive mode to step in.
+ * @param half_steps The distance in half steps, a multiple of the
+ *                   step size, negative for counter-clockwise.
+ * @return A future that becomes true when the move is done, or false if it was stopped.
+ */
+future<bool> MotorController::queue_steps(const StepSequence& step_sequence, const int64_t half_steps) {
+    planned_phase += static_cast<uint32_t>(half_steps);
+    StepCommand command;
+    command.steps = static_cast<uint32_t>(llabs(half_steps) / step_sequence.half_steps_per_step);
+    command.direction = half_steps >= 0 ? 1 : -1;
+    command.position_increment = step_sequence.half_steps_per_step;
+    if (config.profile.shape == ProfileShape::constant) {
+        command.step_interval_us = get_step_interval_us(config.profile);
+    } else {
+        command.step_delays_us = build_step_delays(command.steps, config.profile);
+    }
+    command.on_step = [this, step_sequence, pins = config.w_pi_pins](const int direction, uint64_t) {
+        step(direction, step_sequence, pins);
+    };
+    return engine->queue(std::move(command));
 }
 
 /**
- * Make a single counter-clockwise step.
+ * Make a single step. The coil phase carries over between moves,
+ * and all four pins are set in one write from the precomputed mask.
  *
- * @param semi_step The semi-step ranging from 1-8.
+ * @param direction The direction to step.
+ * @param step_sequence The step table the move was queued with.
+ * @param pins The pins the move was queued with.
  */
-void MotorController::counter_clockwise_step(const unsigned int semi_step) const {
-    digitalWrite(config.w_pi_pins[0], config.step_sequence[semi_step][3]);
-    digitalWrite(config.w_pi_pins[1], config.step_sequence[semi_step][2]);
-    digitalWrite(config.w_pi_pins[2], config.step_sequence[semi_step][1]);
-    digitalWrite(config.w_pi_pins[3], config.step_sequence[semi_step][0]);
+void MotorController::step(const int direction, const StepSequence& step_sequence,
+    const array<unsigned int, 4>& pins) {
+    const uint32_t half_steps = step_sequence.half_steps_per_step;
+    const uint32_t next_phase = phase.load(memory_order_relaxed) + (direction == 1 ? half_steps : -half_steps);
+    phase.store(next_phase, memory_order_relaxed);
+    const uint8_t mask = step_sequence.forward[(next_phase >> step_sequence.phase_shift) & step_sequence.index_mask];
+    gpio->write_outputs(pins.data(), pins.size(), mask);
 }
@@ -0,0 +1,231 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "multi_axis_control.h"
+#include "logger.h"
+
+using namespace std;
+
+/**
+ * Set up the GPIO and start the motion thread. The default profile
+ * steps the leading axis every 2 ms, the same as MotorController.
+ *
+ * @param backend The GPIO device driving every axis.
+ * @param engine_config How to schedule the motion thread.
+ */
+MultiAxisController::MultiAxisController(unique_ptr<GpioBackend> backend, const MotionEngineConfig& engine_config)
+    : gpio(std::move(backend)) {
+    if (!gpio->setup()) {
+        RASPI_HW_LOG_ERROR("Initialize multi-axis motors failed.");
+    } else {
+        RASPI_HW_LOG_INFO("Initialize multi-axis motors success.");
+    }
+    profile.start_velocity = 500;
+    profile.max_velocity = 500;
+    engine = make_unique<MotionEngine>(nullptr, engine_config);
+}
+
+/**
+ * Add an axis. Its position starts at 0.
+ *
+ * @param axis_config The pins, steps per revolution and drive mode.
+ * @return The index of the axis.
+ * @throws std::invalid_argument if there are already max_axes axes or a pin is not a wiringPi pin.
+ */
+size_t MultiAxisController::add_axis(const AxisConfig& axis_config) {
+    if (axes.size() >= max_axes) {
+        throw invalid_argument("Too many axes.");
+    }
+    for (const unsigned int pin : axis_config.w_pi_pins) {
+        if (!is_wiringpi_pin(pin)) {
+            throw invalid_argument("Axis pin is not a wiringPi pin.");
+        }
+    }
+    auto axis = make_unique<Axis>();
+    axis->config = axis_config;
+    axis->sequence = step_sequence_for(axis_config.drive_mode);
+    axes.push_back(std::move(axis));
+    return axes.size() - 1;
+}
+
+/**
+ * Get the number of axes.
+ *
+ * @return The axis count.
+ */
+size_t MultiAxisController::get_axis_count() const {
+    return axes.size();
+}
+
+/**
+ * Set the pins of every axis to output mode.
+ */
+void MultiAxisController::set_to_output_mode() const {
+    for (const auto& axis : axes) {
+        for (const unsigned int w_pi_pin : axis->config.w_pi_pins) {
+            gpio->set_mode(w_pi_pin, PinMode::output);
+        }
+    }
+}
+
+/**
+ * Stop moving and set the pins of every axis to input mode.
+ */
+void MultiAxisController::cleanup() const {
+    engine->stop();
+    for (const auto& axis : axes) {
+        for (const unsigned int w_pi_pin : axis->config.w_pi_pins) {
+            gpio->set_mode(w_pi_pin, PinMode::input);
+        }
+    }
+    RASPI_HW_LOG_INFO("Cleanup multi-axis motors success.");
+}
+
+/**
+ * Move every axis by the given angle and wait until done.
+ *
+ * @param degrees Degrees for each axis, negative for counter-clockwise.
+ */
+void MultiAxisController::move_linear(const vector<double>& degrees) const {
+    move_linear_async(degrees).wait();
+}
+
+/**
+ * Queue a move of every axis by the given angle and return right
+ * away. Angles are rounded to the nearest step of each axis.
+ *
+ * @param degrees Degrees for each axis, negative for counter-clockwise.
+ * @return A future that becomes true when the move is done, or false if it was stopped.
+ * @throws std::invalid_argument if there is not one angle per axis.
+ */
+future<bool> MultiAxisController::move_linear_async(const vector<double>& degrees) const {
+    if (degrees.size() != axes.size()) {
+        throw invalid_argument("Give one angle per axis.");
+    }
+    auto move = make_shared<LinearMove>();
+    for (size_t i = 0; i < axes.size(); ++i) {
+        const Axis& axis = *axes[i];
+        const double steps = degrees[i] * axis.config.steps_per_rev / 360 / axis.sequence.half_steps_per_step;
+        move->steps[i] = llround(steps);
+        move->major_steps = max<uint64_t>(move->major_steps, llabs(move->steps[i]));
+    }
+    // Errors start at 0, so each minor axis reaches its last step exactly on the final tick.
+    StepCommand command;
+    command.steps = static_cast<uint32_t>(move->major_steps);
+    command.position_increment = 0;
+    if (profile.shape == ProfileShape::constant) {
+        command.step_interval_us = get_step_interval_us(profile);
+    } else {
+        command.step_delays_us = build_step_delays(command.steps, profile);
+    }
+    command.on_step = [this, move](int, uint64_t) {
+        tick(*move);
+    };
+    return engine->queue(std::move(command));
+}
+
+/**
+ * Stop the current move after its step in progress and drop queued
+ * moves. Positions stay correct. Returns once every axis has stopped.
+ */
+void MultiAxisController::stop() const {
+    engine->stop();
+}
+
+/**
+ * Wait until every queued move is done.
+ */
+void MultiAxisController::wait() const {
+    engine->wait_idle();
+}
+
+/**
+ * Get whether a move is running or queued.
+ *
+ * @return true if moving, else false.
+ */
+bool MultiAxisController::is_moving() const {
+    return !engine->is_idle();
+}
+
+/**
+ * Get the position of one axis in half steps since it was added.
+ *
+ * @param axis The axis index.
+ * @return The position in half steps.
+ * @throws std::out_of_range if there is no such axis.
+ */
+int64_t MultiAxisController::get_position(const size_t axis) const {
+    return axes.at(axis)->position.load();
+}
+
+/**
+ * Get the position of every axis in half steps.
+ *
+ * @return The positions, by axis index.
+ */
+vector<int64_t> MultiAxisController::get_positions() const {
+    vector<int64_t> positions;
+    positions.reserve(axes.size());
+    for (const auto& axis : axes) {
+        positions.push_back(axis->position.load());
+    }
+    return positions;
+}
+
+/**
+ * Set the speed limits of the leading axis of each move.
+ *
+ * @param new_profile The motion profile.
+ * @throws std::invalid_argument if the profile limits are invalid.
+ */
+void MultiAxisController::set_motion_profile(const MotionProfileConfig& new_profile) {
+    build_step_delays(1, new_profile);
+    profile = new_profile;
+}
+
+/**
+ * Get the speed limits of the leading axis of each move.
+ *
+ * @return The motion profile.
+ */
+const MotionProfileConfig& MultiAxisController::get_motion_profile() const {
+    return profile;
+}
+
+/**
+ * Run one tick of a move on the motion thread. Every axis whose
+ * error passes the leading axis step count takes a step, and all
+ * of their pins are written together.
+ *
+ * @param move The move in progress.
+ */
+void MultiAxisController::tick(LinearMove& move) const {
+    array<unsigned int, max_axes * 4> pins{};
+    uint32_t levels = 0;
+    size_t pin_count = 0;
+    for (size_t i = 0; i < axes.size(); ++i) {
+        move.error[i] += static_cast<uint64_t>(llabs(move.steps[i]));
+        if (move.error[i] < move.major_steps) {
+            continue;
+        }
+        move.error[i] -= move.major_steps;
+        Axis& axis = *axes[i];
+        const bool clockwise = move.steps[i] > 0;
+        axis.phase += clockwise ? 1 : -1;
+        const uint8_t mask = axis.sequence.forward[axis.phase & axis.sequence.index_mask];
+        for (size_t coil = 0; coil < 4; ++coil) {
+            pins[pin_count] = axis.config.w_pi_pins[coil];
+            levels |= static_cast<uint32_t>((mask >> coil) & 1) << pin_count;
+            ++pin_count;
+        }
+        const int64_t increment = axis.sequence.half_steps_per_step;
+        axis.position.fetch_add(clockwise ? increment : -increment, memory_order_relaxed);
+    }
+    if (pin_count > 0) {
+        gpio->write_outputs(pins.data(), pin_count, levels);
+    }
+}
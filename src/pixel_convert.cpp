@@ -0,0 +1,380 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include "pixel_convert.h"
+#include "frame_buffer_pool.h"
+#include "simd.h"
+
+namespace {
+
+/**
+ * Byte layout of a packed pixel: channel count and where red and blue
+ * sit. Green is always at 1 and alpha, when present, at 3.
+ */
+template <int Channels, int R, int B>
+struct Layout {
+    static constexpr int channels = Channels;
+    static constexpr int r = R;
+    static constexpr int b = B;
+};
+
+using RgbLayout = Layout<3, 0, 2>;
+using BgrLayout = Layout<3, 2, 0>;
+using RgbaLayout = Layout<4, 0, 2>;
+
+/**
+ * Call fn with the layout of a packed format.
+ *
+ * @return true if the format is packed rgb, bgr or rgba, else false.
+ */
+template <typename Fn>
+bool with_packed_layout(const PixelFormat format, Fn&& fn) {
+    switch (format) {
+        case PixelFormat::rgb: fn(RgbLayout{}); return true;
+        case PixelFormat::bgr: fn(BgrLayout{}); return true;
+        case PixelFormat::rgba: fn(RgbaLayout{}); return true;
+        default: return false;
+    }
+}
+
+inline unsigned char clamp_byte(const int value) {
+    return static_cast<unsigned char>(std::clamp(value, 0, 255));
+}
+
+// BT.601 limited range, the same matrix the camera uses for its yuv output.
+inline unsigned char rgb_to_y(const int r, const int g, const int b) {
+    return static_cast<unsigned char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+}
+
+inline unsigned char rgb_to_u(const int r, const int g, const int b) {
+    return static_cast<unsigned char>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+}
+
+inline unsigned char rgb_to_v(const int r, const int g, const int b) {
+    return static_cast<unsigned char>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+// Full range luma for gray images.
+inline unsigned char rgb_to_gray(const int r, const int g, const int b) {
+    return static_cast<unsigned char>((77 * r + 150 * g + 29 * b + 128) >> 8);
+}
+
+#if RASPI_HW_SSSE3
+inline __m128i swap_rb_mask(const size_t out_reg, const size_t in_reg) {
+    alignas(16) unsigned char mask[16];
+    for (size_t lane = 0; lane < 16; ++lane) {
+        const size_t out = out_reg * 16 + lane;
+        const size_t in = out - out % 3 + (2 - out % 3);
+        mask[lane] = in / 16 == in_reg ? static_cast<unsigned char>(in % 16) : 0x80;
+    }
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+}
+#endif
+
+/**
+ * Swap the first and third byte of every 3 byte pixel. Turns
+ * rgb into bgr and back, in place. Simd false keeps to the scalar loop.
+ */
+template <bool Simd>
+void swap_rb(unsigned char* data, const size_t pixels) {
+    size_t i = 0;
+#if RASPI_HW_SSSE3
+    if constexpr (Simd) {
+        // Each output register takes bytes from at most two neighbouring input registers.
+        const __m128i m00 = swap_rb_mask(0, 0), m01 = swap_rb_mask(0, 1);
+        const __m128i m10 = swap_rb_mask(1, 0), m11 = swap_rb_mask(1, 1), m12 = swap_rb_mask(1, 2);
+        const __m128i m21 = swap_rb_mask(2, 1), m22 = swap_rb_mask(2, 2);
+        for (; i + 16 <= pixels; i += 16) {
+            auto* chunk = reinterpret_cast<__m128i*>(data + i * 3);
+            const __m128i in0 = _mm_loadu_si128(chunk);
+            const __m128i in1 = _mm_loadu_si128(chunk + 1);
+            const __m128i in2 = _mm_loadu_si128(chunk + 2);
+            _mm_storeu_si128(chunk, _mm_or_si128(_mm_shuffle_epi8(in0, m00), _mm_shuffle_epi8(in1, m01)));
+            _mm_storeu_si128(chunk + 1, _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in0, m10),
+                                                                  _mm_shuffle_epi8(in1, m11)),
+                                                     _mm_shuffle_epi8(in2, m12)));
+            _mm_storeu_si128(chunk + 2, _mm_or_si128(_mm_shuffle_epi8(in1, m21), _mm_shuffle_epi8(in2, m22)));
+        }
+    }
+#elif RASPI_HW_NEON
+    if constexpr (Simd) {
+        for (; i + 16 <= pixels; i += 16) {
+            uint8x16x3_t chunk = vld3q_u8(data + i * 3);
+            const uint8x16_t red = chunk.val[0];
+            chunk.val[0] = chunk.val[2];
+            chunk.val[2] = red;
+            vst3q_u8(data + i * 3, chunk);
+        }
+    }
+#endif
+    for (; i < pixels; ++i) {
+        std::swap(data[i * 3], data[i * 3 + 2]);
+    }
+}
+
+/**
+ * Reorder packed pixels from one layout to another. Runs forward so
+ * it is safe in place when the destination pixel is not larger.
+ */
+template <bool Simd, typename Src, typename Dst>
+void packed_to_packed(const unsigned char* src, unsigned char* dst, const size_t pixels) {
+    if constexpr (Src::channels == 3 && Dst::channels == 3) {
+        if (src != dst) {
+            memcpy(dst, src, pixels * 3);
+        }
+        if constexpr (Src::r != Dst::r) {
+            swap_rb<Simd>(dst, pixels);
+        }
+        return;
+    }
+    for (size_t i = 0; i < pixels; ++i) {
+        const unsigned char* in = src + i * Src::channels;
+        unsigned char* out = dst + i * Dst::channels;
+        const unsigned char r = in[Src::r];
+        const unsigned char g = in[1];
+        const unsigned char b = in[Src::b];
+        const unsigned char a = Src::channels == 4 ? in[3] : 255;
+        out[Dst::r] = r;
+        out[1] = g;
+        out[Dst::b] = b;
+        if constexpr (Dst::channels == 4) {
+            out[3] = a;
+        }
+    }
+}
+
+/**
+ * Reduce packed pixels to gray. Safe in place.
+ */
+template <bool Simd, typename Src>
+void packed_to_gray(const unsigned char* src, unsigned char* dst, const size_t pixels) {
+    size_t i = 0;
+#if RASPI_HW_NEON
+    if constexpr (Simd && Src::channels == 3) {
+        const uint8x8_t r_weight = vdup_n_u8(77);
+        const uint8x8_t g_weight = vdup_n_u8(150);
+        const uint8x8_t b_weight = vdup_n_u8(29);
+        for (; i + 8 <= pixels; i += 8) {
+            const uint8x8x3_t in = vld3_u8(src + i * 3);
+            uint16x8_t sum = vmull_u8(in.val[Src::r], r_weight);
+            sum = vmlal_u8(sum, in.val[1], g_weight);
+            sum = vmlal_u8(sum, in.val[Src::b], b_weight);
+            vst1_u8(dst + i, vrshrn_n_u16(sum, 8));
+        }
+    }
+#endif
+    for (; i < pixels; ++i) {
+        const unsigned char* in = src + i * Src::channels;
+        dst[i] = rgb_to_gray(in[Src::r], in[1], in[Src::b]);
+    }
+}
+
+/**
+ * Expand gray to packed pixels. Not safe in place.
+ */
+template <typename Dst>
+void gray_to_packed(const unsigned char* src, unsigned char* dst, const size_t pixels) {
+    for (size_t i = 0; i < pixels; ++i) {
+        unsigned char* out = dst + i * Dst::channels;
+        out[0] = src[i];
+        out[1] = src[i];
+        out[2] = src[i];
+        if constexpr (Dst::channels == 4) {
+            out[3] = 255;
+        }
+    }
+}
+
+/**
+ * Convert packed pixels to I420. Each pair of rows is read for its
+ * chroma before its luma is written, and luma is written behind the
+ * read position, so src may equal dst. Chroma goes to a scratch buffer
+ * in that case and is copied after the Y plane at the end.
+ */
+template <typename Src>
+void packed_to_i420(const unsigned char* src, unsigned char* dst, const size_t width, const size_t height) {
+    const size_t chroma_width = (width + 1) / 2;
+    const size_t chroma_height = (height + 1) / 2;
+    const size_t chroma_size = chroma_width * chroma_height;
+    std::shared_ptr<unsigned char> scratch;
+    unsigned char* u_plane = dst + width * height;
+    if (src == dst) {
+        scratch = FrameBufferPool::instance().acquire(chroma_size * 2);
+        u_plane = scratch.get();
+    }
+    unsigned char* v_plane = u_plane + chroma_size;
+    const size_t row_size = width * Src::channels;
+    for (size_t row = 0; row < height; row += 2) {
+        const unsigned char* top = src + row * row_size;
+        const unsigned char* bottom = row + 1 < height ? top + row_size : top;
+        for (size_t col = 0; col < width; col += 2) {
+            const size_t next = col + 1 < width ? col + 1 : col;
+            const unsigned char* p[4] = {top + col * Src::channels, top + next * Src::channels,
+                                         bottom + col * Src::channels, bottom + next * Src::channels};
+            int r = 0, g = 0, b = 0;
+            for (const unsigned char* pixel : p) {
+                r += pixel[Src::r];
+                g += pixel[1];
+                b += pixel[Src::b];
+            }
+            const size_t chroma_index = (row / 2) * chroma_width + col / 2;
+            u_plane[chroma_index] = rgb_to_u((r + 2) >> 2, (g + 2) >> 2, (b + 2) >> 2);
+            v_plane[chroma_index] = rgb_to_v((r + 2) >> 2, (g + 2) >> 2, (b + 2) >> 2);
+        }
+        for (size_t y = row; y < std::min(row + 2, height); ++y) {
+            const unsigned char* in = src + y * row_size;
+            unsigned char* out = dst + y * width;
+            for (size_t col = 0; col < width; ++col) {
+                out[col] = rgb_to_y(in[col * Src::channels + Src::r], in[col * Src::channels + 1],
+                                    in[col * Src::channels + Src::b]);
+            }
+        }
+    }
+    if (scratch) {
+        memcpy(dst + width * height, scratch.get(), chroma_size * 2);
+    }
+}
+
+/**
+ * Convert I420 to packed pixels. Not safe in place.
+ */
+template <typename Dst>
+void i420_to_packed(const unsigned char* src, unsigned char* dst, const size_t width, const size_t height) {
+    const size_t chroma_width = (width + 1) / 2;
+    const unsigned char* u_plane = src + width * height;
+    const unsigned char* v_plane = u_plane + chroma_width * ((height + 1) / 2);
+    for (size_t row = 0; row < height; ++row) {
+        const unsigned char* y_row = src + row * width;
+        const unsigned char* u_row = u_plane + (row / 2) * chroma_width;
+        const unsigned char* v_row = v_plane + (row / 2) * chroma_width;
+        unsigned char* out = dst + row * width * Dst::channels;
+        for (size_t col = 0; col < width; ++col) {
+            const int c = 298 * (y_row[col] - 16);
+            const int d = u_row[col / 2] - 128;
+            const int e = v_row[col / 2] - 128;
+            unsigned char* pixel = out + col * Dst::channels;
+            pixel[Dst::r] = clamp_byte((c + 409 * e + 128) >> 8);
+            pixel[1] = clamp_byte((c - 100 * d - 208 * e + 128) >> 8);
+            pixel[Dst::b] = clamp_byte((c + 516 * d + 128) >> 8);
+            if constexpr (Dst::channels == 4) {
+                pixel[3] = 255;
+            }
+        }
+    }
+}
+
+/**
+ * Use full range gray as limited range luma with neutral chroma.
+ * Not safe in place.
+ */
+void gray_to_i420(const unsigned char* src, unsigned char* dst, const size_t width, const size_t height) {
+    const size_t pixels = width * height;
+    for (size_t i = 0; i < pixels; ++i) {
+        dst[i] = static_cast<unsigned char>(((src[i] * 220 + 128) >> 8) + 16);
+    }
+    memset(dst + pixels, 128, 2 * ((width + 1) / 2) * ((height + 1) / 2));
+}
+
+/**
+ * Expand limited range luma back to full range gray. Safe in place.
+ */
+void i420_to_gray(const unsigned char* src, unsigned char* dst, const size_t width, const size_t height) {
+    const size_t pixels = width * height;
+    for (size_t i = 0; i < pixels; ++i) {
+        dst[i] = clamp_byte(((src[i] - 16) * 298 + 128) >> 8);
+    }
+}
+
+/**
+ * Convert a raw frame from one format to another, with the vector
+ * kernels when Simd is true.
+ */
+template <bool Simd>
+bool convert_raw(const unsigned char* src, const PixelFormat src_format, unsigned char* dst,
+                 const PixelFormat dst_format, const size_t width, const size_t height) {
+    if (!pixel_format_is_raw(src_format) || !pixel_format_is_raw(dst_format)) {
+        return false;
+    }
+    const size_t pixels = width * height;
+    if (src_format == dst_format) {
+        if (src != dst) {
+            memcpy(dst, src, pixel_format_frame_size(src_format, width, height));
+        }
+        return true;
+    }
+    if (src_format == PixelFormat::gray) {
+        if (dst_format == PixelFormat::yuv420) {
+            gray_to_i420(src, dst, width, height);
+            return true;
+        }
+        return with_packed_layout(dst_format, [&](auto dst_layout) {
+            gray_to_packed<decltype(dst_layout)>(src, dst, pixels);
+        });
+    }
+    if (src_format == PixelFormat::yuv420) {
+        if (dst_format == PixelFormat::gray) {
+            i420_to_gray(src, dst, width, height);
+            return true;
+        }
+        return with_packed_layout(dst_format, [&](auto dst_layout) {
+            i420_to_packed<decltype(dst_layout)>(src, dst, width, height);
+        });
+    }
+    return with_packed_layout(src_format, [&](auto src_layout) {
+        using Src = decltype(src_layout);
+        if (dst_format == PixelFormat::gray) {
+            packed_to_gray<Simd, Src>(src, dst, pixels);
+        } else if (dst_format == PixelFormat::yuv420) {
+            packed_to_i420<Src>(src, dst, width, height);
+        } else {
+            with_packed_layout(dst_format, [&](auto dst_layout) {
+                packed_to_packed<Simd, Src, decltype(dst_layout)>(src, dst, pixels);
+            });
+        }
+    });
+}
+
+}
+
+/**
+ * Get whether a conversion can write over its own source.
+ *
+ * @param src_format The source format.
+ * @param dst_format The destination format.
+ * @param width The image width.
+ * @param height The image height.
+ * @return true if the output is no larger than the input, else false.
+ */
+bool can_convert_in_place(const PixelFormat src_format, const PixelFormat dst_format, const size_t width,
+                          const size_t height) {
+    return pixel_format_is_raw(src_format) && pixel_format_is_raw(dst_format) &&
+           pixel_format_frame_size(dst_format, width, height) <= pixel_format_frame_size(src_format, width, height);
+}
+
+/**
+ * Convert a raw frame from one format to another.
+ *
+ * @param src The source pixels.
+ * @param src_format The source format.
+ * @param dst The destination. May equal src when can_convert_in_place().
+ * @param dst_format The destination format.
+ * @param width The image width.
+ * @param height The image height.
+ * @return true if the conversion is supported, else false.
+ */
+bool convert_pixels(const unsigned char* src, const PixelFormat src_format, unsigned char* dst,
+                    const PixelFormat dst_format, const size_t width, const size_t height) {
+    return convert_raw<true>(src, src_format, dst, dst_format, width, height);
+}
+
+/**
+ * Reference conversion without the vector kernels, which
+ * convert_pixels() is checked against. Same arguments and result.
+ */
+bool convert_pixels_scalar(const unsigned char* src, const PixelFormat src_format, unsigned char* dst,
+                           const PixelFormat dst_format, const size_t width, const size_t height) {
+    return convert_raw<false>(src, src_format, dst, dst_format, width, height);
+}
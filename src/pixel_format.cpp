@@ -0,0 +1,38 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <stdexcept>
+#include "pixel_format.h"
+
+/**
+ * Look up a format by name. Only used where strings come in from
+ * callers, formats are passed around as the enum after that.
+ *
+ * @param name The name, e.g. "rgb". The empty name is PixelFormat::none.
+ * @param format Set to the format when the name is known.
+ * @return true if the name is known, else false.
+ */
+bool pixel_format_from_name(const std::string& name, PixelFormat& format) {
+    for (size_t i = 0; i < std::size(pixel_format_table); ++i) {
+        if (name == pixel_format_table[i].name) {
+            format = static_cast<PixelFormat>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Look up a format by name.
+ *
+ * @param name The name, e.g. "rgb".
+ * @return The format.
+ * @throws std::invalid_argument if the name is unknown.
+ */
+PixelFormat pixel_format_from_name(const std::string& name) {
+    PixelFormat format;
+    if (!pixel_format_from_name(name, format)) {
+        throw std::invalid_argument("Unknown image encoding: " + name);
+    }
+    return format;
+}
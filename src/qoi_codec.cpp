@@ -0,0 +1,411 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "qoi_codec.h"
+#include "logger.h"
+#include "metrics.h"
+
+using namespace std;
+
+namespace {
+
+constexpr unsigned char op_index = 0x00;
+constexpr unsigned char op_diff = 0x40;
+constexpr unsigned char op_luma = 0x80;
+constexpr unsigned char op_run = 0xc0;
+constexpr unsigned char op_rgb = 0xfe;
+constexpr unsigned char op_rgba = 0xff;
+constexpr unsigned char op_mask = 0xc0;
+constexpr unsigned int max_run = 62;
+constexpr unsigned char end_marker[QoiEncoder::end_size] = {0, 0, 0, 0, 0, 0, 0, 1};
+// The format caps images at 400 million pixels so sizes fit 32 bits.
+constexpr size_t max_pixels = 400000000;
+// Encoded bytes handed to the sink at a time.
+constexpr size_t chunk_size = 256 * 1024;
+constexpr uint32_t opaque_black = 0xff000000;
+
+/**
+ * Pack a pixel as r | g << 8 | b << 16 | a << 24.
+ */
+inline uint32_t pack(const unsigned int r, const unsigned int g, const unsigned int b, const unsigned int a) {
+    return r | g << 8 | b << 16 | a << 24;
+}
+
+inline unsigned int hash_pixel(const uint32_t px) {
+    const unsigned int r = px & 0xff;
+    const unsigned int g = px >> 8 & 0xff;
+    const unsigned int b = px >> 16 & 0xff;
+    const unsigned int a = px >> 24;
+    return (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+}
+
+/**
+ * Encode rows of packed pixels, carrying the index, the previous pixel
+ * and any unfinished run from one call to the next.
+ *
+ * @return The bytes written to out.
+ */
+template <unsigned int channels>
+size_t encode_pixels(const unsigned char* rows, const size_t row_count, const size_t stride,
+                     const unsigned int width, uint32_t* index, uint32_t& previous, unsigned int& run,
+                     unsigned char* out) {
+    unsigned char* p = out;
+    for (size_t row = 0; row < row_count; ++row) {
+        const unsigned char* px_bytes = rows + row * stride;
+        for (unsigned int x = 0; x < width; ++x, px_bytes += channels) {
+            const uint32_t px = pack(px_bytes[0], px_bytes[1], px_bytes[2], channels == 4 ? px_bytes[3] : 255);
+            if (px == previous) {
+                if (++run == max_run) {
+                    *p++ = static_cast<unsigned char>(op_run | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                *p++ = static_cast<unsigned char>(op_run | (run - 1));
+                run = 0;
+            }
+            const unsigned int slot = hash_pixel(px);
+            if (index[slot] == px) {
+                *p++ = static_cast<unsigned char>(op_index | slot);
+                previous = px;
+                continue;
+            }
+            index[slot] = px;
+            if ((px ^ previous) >> 24 != 0) {
+                *p++ = op_rgba;
+                memcpy(p, &px_bytes[0], 3);
+                p[3] = static_cast<unsigned char>(px >> 24);
+                p += 4;
+                previous = px;
+                continue;
+            }
+            const auto dr = static_cast<int8_t>((px & 0xff) - (previous & 0xff));
+            const auto dg = static_cast<int8_t>((px >> 8 & 0xff) - (previous >> 8 & 0xff));
+            const auto db = static_cast<int8_t>((px >> 16 & 0xff) - (previous >> 16 & 0xff));
+            const int dr_dg = dr - dg;
+            const int db_dg = db - dg;
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                *p++ = static_cast<unsigned char>(op_diff | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+            } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                *p++ = static_cast<unsigned char>(op_luma | (dg + 32));
+                *p++ = static_cast<unsigned char>((dr_dg + 8) << 4 | (db_dg + 8));
+            } else {
+                *p++ = op_rgb;
+                memcpy(p, &px_bytes[0], 3);
+                p += 3;
+            }
+            previous = px;
+        }
+    }
+    return static_cast<size_t>(p - out);
+}
+
+/**
+ * Decode pixels until the image is full or the data runs out.
+ *
+ * @return true if every pixel was decoded, else false.
+ */
+template <unsigned int channels>
+bool decode_pixels(const unsigned char* data, const size_t data_size, unsigned char* pixels,
+                   const size_t pixel_count) {
+    uint32_t index[64] = {};
+    uint32_t px = opaque_black;
+    size_t pos = 0;
+    unsigned int run = 0;
+    unsigned char* out = pixels;
+    for (size_t i = 0; i < pixel_count; ++i, out += channels) {
+        if (run > 0) {
+            --run;
+        } else {
+            if (pos >= data_size) {
+                return false;
+            }
+            const unsigned char op = data[pos++];
+            if (op == op_rgb || op == op_rgba) {
+                const size_t length = op == op_rgb ? 3 : 4;
+                if (pos + length > data_size) {
+                    return false;
+                }
+                const unsigned int a = op == op_rgba ? data[pos + 3] : px >> 24;
+                px = pack(data[pos], data[pos + 1], data[pos + 2], a);
+                pos += length;
+            } else if ((op & op_mask) == op_index) {
+                px = index[op];
+            } else if ((op & op_mask) == op_diff) {
+                const unsigned int r = (px & 0xff) + (op >> 4 & 3) - 2;
+                const unsigned int g = (px >> 8 & 0xff) + (op >> 2 & 3) - 2;
+                const unsigned int b = (px >> 16 & 0xff) + (op & 3) - 2;
+                px = pack(r & 0xff, g & 0xff, b & 0xff, px >> 24);
+            } else if ((op & op_mask) == op_luma) {
+                if (pos >= data_size) {
+                    return false;
+                }
+                const unsigned char second = data[pos++];
+                const int dg = (op & 0x3f) - 32;
+                const unsigned int r = (px & 0xff) + dg - 8 + (second >> 4 & 0x0f);
+                const unsigned int g = (px >> 8 & 0xff) + dg;
+                const unsigned int b = (px >> 16 & 0xff) + dg - 8 + (second & 0x0f);
+                px = pack(r & 0xff, g & 0xff, b & 0xff, px >> 24);
+            } else {
+                run = op & 0x3f;
+            }
+            index[hash_pixel(px)] = px;
+        }
+        out[0] = static_cast<unsigned char>(px);
+        out[1] = static_cast<unsigned char>(px >> 8);
+        out[2] = static_cast<unsigned char>(px >> 16);
+        if (channels == 4) {
+            out[3] = static_cast<unsigned char>(px >> 24);
+        }
+    }
+    return true;
+}
+
+/**
+ * Write a 32 bit big endian value.
+ */
+void put_u32(unsigned char* out, const uint32_t value) {
+    out[0] = static_cast<unsigned char>(value >> 24);
+    out[1] = static_cast<unsigned char>(value >> 16);
+    out[2] = static_cast<unsigned char>(value >> 8);
+    out[3] = static_cast<unsigned char>(value);
+}
+
+/**
+ * Read a 32 bit big endian value.
+ */
+uint32_t get_u32(const unsigned char* in) {
+    return static_cast<uint32_t>(in[0]) << 24 | static_cast<uint32_t>(in[1]) << 16 |
+        static_cast<uint32_t>(in[2]) << 8 | in[3];
+}
+
+}
+
+/**
+ * Start an image.
+ *
+ * @param width The image width.
+ * @param height The image height.
+ * @param channels 3 for rgb, 4 for rgba.
+ * @throws std::invalid_argument if the channel count is not 3 or 4.
+ */
+QoiEncoder::QoiEncoder(const unsigned int width, const unsigned int height, const unsigned int channels)
+    : width(width), height(height), channels(channels), index(), previous(opaque_black), run(0) {
+    if (channels != 3 && channels != 4) {
+        throw invalid_argument("QOI needs 3 or 4 channels.");
+    }
+}
+
+/**
+ * Write the file header.
+ *
+ * @param out At least header_size bytes.
+ * @return The bytes written.
+ */
+size_t QoiEncoder::write_header(unsigned char* out) const {
+    memcpy(out, "qoif", 4);
+    put_u32(out + 4, width);
+    put_u32(out + 8, height);
+    out[12] = static_cast<unsigned char>(channels);
+    // sRGB with linear alpha.
+    out[13] = 0;
+    return header_size;
+}
+
+/**
+ * Encode the next rows of the image.
+ *
+ * @param rows The first row, packed rgb or rgba.
+ * @param row_count The number of rows.
+ * @param stride The distance between rows in bytes.
+ * @param out At least get_max_encoded_size(row_count) bytes.
+ * @return The bytes written.
+ */
+size_t QoiEncoder::encode_rows(const unsigned char* rows, const size_t row_count, const size_t stride,
+                               unsigned char* out) {
+    if (channels == 4) {
+        return encode_pixels<4>(rows, row_count, stride, width, index, previous, run, out);
+    }
+    return encode_pixels<3>(rows, row_count, stride, width, index, previous, run, out);
+}
+
+/**
+ * End the image after its last row.
+ *
+ * @param out At least end_size + 1 bytes.
+ * @return The bytes written.
+ */
+size_t QoiEncoder::finish(unsigned char* out) {
+    size_t length = 0;
+    if (run > 0) {
+        out[length++] = static_cast<unsigned char>(op_run | (run - 1));
+        run = 0;
+    }
+    memcpy(out + length, end_marker, end_size);
+    return length + end_size;
+}
+
+/**
+ * Get the most bytes encode_rows() can write for some rows.
+ *
+ * @param row_count The number of rows.
+ * @return The size in bytes, one more than channels per pixel plus a run from before.
+ */
+size_t QoiEncoder::get_max_encoded_size(const size_t row_count) const {
+    return row_count * width * (channels + 1) + 1;
+}
+
+/**
+ * Get whether an image can be encoded. Any rgb header trails the
+ * pixels, so it does not need removing first.
+ *
+ * @param image The image.
+ * @return true for rgb and rgba images with data, else false.
+ */
+bool can_encode_qoi(const Image& image) {
+    const PixelFormat format = image.get_format();
+    return (format == PixelFormat::rgb || format == PixelFormat::rgba) && image.get_data() != nullptr &&
+        image.get_width() > 0 && image.get_height() > 0 &&
+        static_cast<size_t>(image.get_width()) * image.get_height() <= max_pixels &&
+        image.get_size() >= (image.get_height() - 1) * image.get_stride() +
+            pixel_format_row_size(format, image.get_width());
+}
+
+/**
+ * Get whether a file path ends in .qoi.
+ *
+ * @param file_path The file path.
+ * @return true if the extension is qoi, else false.
+ */
+bool has_qoi_extension(const string& file_path) {
+    return file_path.size() > 4 && file_path.compare(file_path.size() - 4, 4, ".qoi") == 0;
+}
+
+/**
+ * Encode an image, handing the output to sink in chunks as it is made,
+ * so it can be written out while the rest is encoded.
+ *
+ * @param image An rgb or rgba image, can be a crop view.
+ * @param sink Called with each chunk. Return false to stop.
+ * @return true if the whole image was encoded and taken by sink, else false.
+ */
+bool encode_qoi(const Image& image, const function<bool(const unsigned char* data, size_t size)>& sink) {
+    if (!can_encode_qoi(image)) {
+        RASPI_HW_LOG_WARN("Abort encode: Can only encode rgb or rgba images to qoi.");
+        return false;
+    }
+    ScopedLatency latency(MetricTimer::encode);
+    const unsigned int channels = pixel_format_info(image.get_format()).bytes_per_pixel;
+    QoiEncoder encoder(image.get_width(), image.get_height(), channels);
+    const size_t stride = image.get_stride();
+    const size_t rows_per_chunk = max<size_t>(1, chunk_size / encoder.get_max_encoded_size(1));
+    vector<unsigned char> buffer(QoiEncoder::header_size + encoder.get_max_encoded_size(rows_per_chunk) +
+                                 QoiEncoder::end_size);
+    size_t length = encoder.write_header(buffer.data());
+    for (size_t row = 0; row < image.get_height(); row += rows_per_chunk) {
+        const size_t row_count = min<size_t>(rows_per_chunk, image.get_height() - row);
+        length += encoder.encode_rows(image.get_data() + row * stride, row_count, stride, buffer.data() + length);
+        if (!sink(buffer.data(), length)) {
+            return false;
+        }
+        length = 0;
+    }
+    length = encoder.finish(buffer.data());
+    return sink(buffer.data(), length);
+}
+
+/**
+ * Encode an image in memory.
+ *
+ * @param image An rgb or rgba image, can be a crop view.
+ * @return The encoded image with format qoi, or an empty image if it cannot be encoded.
+ */
+Image encode_qoi(const Image& image) {
+    vector<unsigned char> encoded;
+    const bool ok = encode_qoi(image, [&encoded](const unsigned char* data, const size_t size) {
+        encoded.insert(encoded.end(), data, data + size);
+        return true;
+    });
+    if (!ok) {
+        return {};
+    }
+    Image result(encoded.data(), encoded.size(), image.get_width(), image.get_height(), PixelFormat::qoi, true);
+    result.set_frame_info(image.get_frame_info());
+    return result;
+}
+
+/**
+ * Decode a QOI file in memory.
+ *
+ * @param data The file bytes.
+ * @param size The file size.
+ * @return An rgb or rgba image, or an empty image if the data is not valid QOI.
+ */
+Image decode_qoi(const unsigned char* data, const size_t size) {
+    if (data == nullptr || size < QoiEncoder::header_size + QoiEncoder::end_size || memcmp(data, "qoif", 4) != 0) {
+        RASPI_HW_LOG_WARN("Abort decode: Not a qoi file.");
+        return {};
+    }
+    const uint32_t width = get_u32(data + 4);
+    const uint32_t height = get_u32(data + 8);
+    const unsigned int channels = data[12];
+    if (width == 0 || height == 0 || static_cast<size_t>(width) * height > max_pixels ||
+        (channels != 3 && channels != 4)) {
+        RASPI_HW_LOG_WARN("Abort decode: Unsupported qoi size or channel count.");
+        return {};
+    }
+    const PixelFormat format = channels == 4 ? PixelFormat::rgba : PixelFormat::rgb;
+    Image image(pixel_format_frame_size(format, width, height), width, height, format, false);
+    const unsigned char* chunks = data + QoiEncoder::header_size;
+    const size_t chunks_size = size - QoiEncoder::header_size - QoiEncoder::end_size;
+    const size_t pixel_count = static_cast<size_t>(width) * height;
+    const bool ok = channels == 4 ? decode_pixels<4>(chunks, chunks_size, image.get_data(), pixel_count)
+                                  : decode_pixels<3>(chunks, chunks_size, image.get_data(), pixel_count);
+    if (!ok) {
+        RASPI_HW_LOG_WARN("Abort decode: qoi data is truncated.");
+        return {};
+    }
+    return image;
+}
+
+/**
+ * Decode an image with format qoi, e.g. from encode_qoi().
+ *
+ * @param encoded The encoded image.
+ * @return An rgb or rgba image, or an empty image if it is not valid QOI.
+ */
+Image decode_qoi(const Image& encoded) {
+    if (encoded.get_format() != PixelFormat::qoi) {
+        RASPI_HW_LOG_WARN("Abort decode: Image is not qoi encoded.");
+        return {};
+    }
+    Image image = decode_qoi(encoded.get_data(), encoded.get_size());
+    image.set_frame_info(encoded.get_frame_info());
+    return image;
+}
+
+/**
+ * Read and decode a QOI file.
+ *
+ * @param file_path The file path.
+ * @return An rgb or rgba image, or an empty image if the file cannot be read or is not valid QOI.
+ */
+Image load_qoi(const string& file_path) {
+    ifstream file(file_path, ios::binary | ios::ate);
+    if (!file.is_open()) {
+        RASPI_HW_LOG_ERROR("Failed to open " << file_path);
+        return {};
+    }
+    vector<unsigned char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<streamsize>(data.size()))) {
+        RASPI_HW_LOG_ERROR("Failed to read " << file_path);
+        return {};
+    }
+    return decode_qoi(data.data(), data.size());
+}
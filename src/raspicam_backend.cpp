@@ -0,0 +1,156 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <stdexcept>
+#include "raspicam_backend.h"
+
+/**
+ * Open the raspberry pi camera.
+ *
+ * @return true if the camera opened, else false.
+ */
+bool RaspiCamBackend::open() {
+    return camera.open();
+}
+
+/**
+ * Release the raspberry pi camera.
+ */
+void RaspiCamBackend::release() {
+    camera.release();
+}
+
+/**
+ * Set the image width.
+ *
+ * @param width The image width.
+ */
+void RaspiCamBackend::set_width(const unsigned int width) {
+    camera.setWidth(width);
+}
+
+/**
+ * Set the image height.
+ *
+ * @param height The image height.
+ */
+void RaspiCamBackend::set_height(const unsigned int height) {
+    camera.setHeight(height);
+}
+
+/**
+ * Set the image encoding.
+ *
+ * @param encoding The image encoding. Only png, jpeg, or rgb.
+ */
+void RaspiCamBackend::set_encoding(const PixelFormat encoding) {
+    switch (encoding) {
+        case PixelFormat::png:
+            camera.setEncoding(raspicam::RASPICAM_ENCODING_PNG);
+            break;
+        case PixelFormat::jpeg:
+            camera.setEncoding(raspicam::RASPICAM_ENCODING_JPEG);
+            break;
+        case PixelFormat::rgb:
+            camera.setEncoding(raspicam::RASPICAM_ENCODING_RGB);
+            break;
+        default:
+            throw std::invalid_argument("Use png, jpeg, or rgb instead.");
+    }
+}
+
+/**
+ * Set the camera sharpness.
+ *
+ * @param sharpness The sharpness. -100 - 100.
+ */
+void RaspiCamBackend::set_sharpness(const int sharpness) {
+    camera.setSharpness(sharpness);
+}
+
+/**
+ * Set the camera contrast.
+ *
+ * @param contrast The contrast. -100 - 100.
+ */
+void RaspiCamBackend::set_contrast(const int contrast) {
+    camera.setContrast(contrast);
+}
+
+/**
+ * Set the camera brightness.
+ *
+ * @param brightness The brightness. 0 - 100.
+ */
+void RaspiCamBackend::set_brightness(const unsigned int brightness) {
+    camera.setBrightness(brightness);
+}
+
+/**
+ * Set the camera saturation.
+ *
+ * @param saturation The saturation. -100 - 100.
+ */
+void RaspiCamBackend::set_saturation(const int saturation) {
+    camera.setSaturation(saturation);
+}
+
+/**
+ * Set the camera iso.
+ *
+ * @param iso The iso. 100 - 800.
+ */
+void RaspiCamBackend::set_iso(const int iso) {
+    camera.setISO(iso);
+}
+
+/**
+ * Let the camera choose the exposure.
+ */
+void RaspiCamBackend::set_exposure_auto() {
+    camera.setExposure(raspicam::RASPICAM_EXPOSURE_AUTO);
+}
+
+/**
+ * Hold the exposure and white balance at their current values, or let
+ * the camera choose them again.
+ *
+ * @param locked true to hold them, false for auto.
+ */
+void RaspiCamBackend::set_exposure_locked(const bool locked) {
+    camera.setExposure(locked ? raspicam::RASPICAM_EXPOSURE_OFF : raspicam::RASPICAM_EXPOSURE_AUTO);
+    camera.setAWB(locked ? raspicam::RASPICAM_AWB_OFF : raspicam::RASPICAM_AWB_AUTO);
+}
+
+/**
+ * Get the buffer size needed for one capture.
+ *
+ * @return Header + Image Data + Padding in bytes.
+ */
+size_t RaspiCamBackend::get_image_buffer_size() const {
+    return camera.getImageBufferSize();
+}
+
+/**
+ * Get the buffer size one capture would need at other settings,
+ * without changing the camera.
+ *
+ * @param width The image width.
+ * @param height The image height.
+ * @return width*height*3+54 bytes, what RaspiCam_Still reports for every encoding.
+ */
+size_t RaspiCamBackend::get_image_buffer_size(const unsigned int width, const unsigned int height,
+                                              PixelFormat) const {
+    return static_cast<size_t>(width) * height * 3 + 54;
+}
+
+/**
+ * Capture an image directly into the given buffer.
+ *
+ * @param data The buffer to fill. Must hold at least size bytes.
+ * @param size The size of the buffer.
+ * @return true if the capture succeeded, else false.
+ */
+bool RaspiCamBackend::grab_retrieve(unsigned char* data, const size_t size) {
+    return camera.grab_retrieve(data, static_cast<unsigned int>(size));
+}
@@ -0,0 +1,65 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <cerrno>
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+#include "realtime_thread.h"
+
+/**
+ * Pin the calling thread to one core so it does not migrate
+ * between cores in the middle of a move.
+ *
+ * @param core The core index.
+ * @return true if pinned, else false.
+ */
+bool pin_current_thread(const int core) {
+    if (core < 0 || core >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core, &cpu_set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+}
+
+/**
+ * Move the calling thread to SCHED_FIFO so normal threads cannot
+ * preempt it. The priority is clamped to the allowed range.
+ *
+ * @param priority The realtime priority, 1-99 on Linux.
+ * @return true if the thread is now SCHED_FIFO, else false.
+ */
+bool set_current_thread_fifo(const int priority) {
+    const int min_priority = sched_get_priority_min(SCHED_FIFO);
+    const int max_priority = sched_get_priority_max(SCHED_FIFO);
+    sched_param param{};
+    param.sched_priority = priority < min_priority ? min_priority : priority > max_priority ? max_priority : priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+/**
+ * Get the monotonic clock time.
+ *
+ * @return The time in nanoseconds.
+ */
+int64_t monotonic_now_ns() {
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * Sleep until an absolute monotonic time. Unlike a relative sleep,
+ * time lost to a late wake up is not added to the next deadline.
+ *
+ * @param deadline_ns The monotonic time to wake at, in nanoseconds.
+ */
+void sleep_until_ns(const int64_t deadline_ns) {
+    timespec deadline{};
+    deadline.tv_sec = static_cast<time_t>(deadline_ns / 1000000000);
+    deadline.tv_nsec = static_cast<long>(deadline_ns % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+}
@@ -0,0 +1,214 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include "simulated_camera_backend.h"
+
+/**
+ * Start with the same defaults as CameraConfig.
+ *
+ * @param capture_latency_us How long each capture takes in microseconds.
+ */
+SimulatedCameraBackend::SimulatedCameraBackend(const unsigned long capture_latency_us)
+    : width(320), height(240), encoding(PixelFormat::png), capture_latency_us(capture_latency_us), open_latency_us(0),
+      is_open(false), exposure_locked(false), grab_count(0), open_count(0), last_buffer(nullptr) {
+}
+
+/**
+ * Open the simulated camera. Waits for the open latency first. Always
+ * succeeds.
+ *
+ * @return true.
+ */
+bool SimulatedCameraBackend::open() {
+    if (open_latency_us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(open_latency_us));
+    }
+    is_open = true;
+    ++open_count;
+    return true;
+}
+
+/**
+ * Release the simulated camera.
+ */
+void SimulatedCameraBackend::release() {
+    is_open = false;
+}
+
+/**
+ * Set the image width.
+ *
+ * @param new_width The image width.
+ */
+void SimulatedCameraBackend::set_width(const unsigned int new_width) {
+    width = new_width;
+}
+
+/**
+ * Set the image height.
+ *
+ * @param new_height The image height.
+ */
+void SimulatedCameraBackend::set_height(const unsigned int new_height) {
+    height = new_height;
+}
+
+/**
+ * Set the image encoding. Same rules as the raspicam backend.
+ *
+ * @param new_encoding The image encoding. Only png, jpeg, or rgb.
+ */
+void SimulatedCameraBackend::set_encoding(const PixelFormat new_encoding) {
+    if (!pixel_format_info(new_encoding).camera_output) {
+        throw std::invalid_argument("Use png, jpeg, or rgb instead.");
+    }
+    encoding = new_encoding;
+}
+
+/**
+ * Hold the simulated exposure. Only remembered, the frames do not change.
+ *
+ * @param locked true to hold it, false for auto.
+ */
+void SimulatedCameraBackend::set_exposure_locked(const bool locked) {
+    exposure_locked = locked;
+}
+
+/**
+ * Same size raspicam reports for every encoding.
+ *
+ * @return width*height*3+54 bytes.
+ */
+size_t SimulatedCameraBackend::get_image_buffer_size() const {
+    return get_image_buffer_size(width, height, encoding);
+}
+
+/**
+ * Same size raspicam reports for every encoding, at other settings.
+ *
+ * @param new_width The image width.
+ * @param new_height The image height.
+ * @return width*height*3+54 bytes.
+ */
+size_t SimulatedCameraBackend::get_image_buffer_size(const unsigned int new_width, const unsigned int new_height,
+                                                     PixelFormat) const {
+    return static_cast<size_t>(new_width) * new_height * 3 + 54;
+}
+
+/**
+ * Fill the buffer with a gradient that shifts with every capture.
+ * For png and jpeg the bytes are not a valid file, only the right size.
+ * Waits for the capture latency first.
+ *
+ * @param data The buffer to fill.
+ * @param size The size of the buffer.
+ * @return true if the buffer is big enough and the camera is open, else false.
+ */
+bool SimulatedCameraBackend::grab_retrieve(unsigned char* data, const size_t size) {
+    const size_t image_size = get_image_buffer_size();
+    if (!is_open || data == nullptr || size < image_size) {
+        return false;
+    }
+    if (capture_latency_us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(capture_latency_us));
+    }
+    const auto shift = static_cast<unsigned char>(grab_count);
+    const size_t row_size = static_cast<size_t>(width) * 3;
+    for (size_t row = 0; row < height; ++row) {
+        unsigned char* row_start = data + row * row_size;
+        for (size_t col = 0; col < width; ++col) {
+            row_start[col * 3] = static_cast<unsigned char>(col + shift);
+            row_start[col * 3 + 1] = static_cast<unsigned char>(row + shift);
+            row_start[col * 3 + 2] = shift;
+        }
+    }
+    std::fill(data + image_size - 54, data + image_size, 0);
+    ++grab_count;
+    last_buffer = data;
+    return true;
+}
+
+/**
+ * Set how long each capture takes.
+ *
+ * @param new_capture_latency_us The capture latency in microseconds, 0 for none.
+ */
+void SimulatedCameraBackend::set_capture_latency_us(const unsigned long new_capture_latency_us) {
+    capture_latency_us = new_capture_latency_us;
+}
+
+/**
+ * Get how long each capture takes.
+ *
+ * @return The capture latency in microseconds.
+ */
+unsigned long SimulatedCameraBackend::get_capture_latency_us() const {
+    return capture_latency_us;
+}
+
+/**
+ * Set how long opening takes.
+ *
+ * @param new_open_latency_us The open latency in microseconds, 0 for none.
+ */
+void SimulatedCameraBackend::set_open_latency_us(const unsigned long new_open_latency_us) {
+    open_latency_us = new_open_latency_us;
+}
+
+/**
+ * Get how long opening takes.
+ *
+ * @return The open latency in microseconds.
+ */
+unsigned long SimulatedCameraBackend::get_open_latency_us() const {
+    return open_latency_us;
+}
+
+/**
+ * Get whether the simulated camera is open.
+ *
+ * @return true if open, else false.
+ */
+bool SimulatedCameraBackend::get_is_open() const {
+    return is_open;
+}
+
+/**
+ * Get whether the simulated exposure is held.
+ *
+ * @return true if held, else false.
+ */
+bool SimulatedCameraBackend::get_exposure_locked() const {
+    return exposure_locked;
+}
+
+/**
+ * Get the number of successful captures.
+ *
+ * @return The capture count.
+ */
+unsigned long SimulatedCameraBackend::get_grab_count() const {
+    return grab_count;
+}
+
+/**
+ * Get the number of times the camera was opened.
+ *
+ * @return The open count.
+ */
+unsigned long SimulatedCameraBackend::get_open_count() const {
+    return open_count;
+}
+
+/**
+ * Get the last buffer a frame was written into.
+ *
+ * @return The buffer pointer, or nullptr if nothing captured yet.
+ */
+const unsigned char* SimulatedCameraBackend::get_last_buffer() const {
+    return last_buffer;
+}
@@ -0,0 +1,215 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <stdexcept>
+#include "simulated_gpio_backend.h"
+#include "realtime_thread.h"
+
+/**
+ * Start with every pin as a low input.
+ */
+SimulatedGpioBackend::SimulatedGpioBackend()
+    : is_setup(false), output_pins(0), levels(0), write_count(0), is_recording(false), max_timeline_events(0) {
+}
+
+/**
+ * Set up the simulated GPIO. Always succeeds.
+ *
+ * @return true.
+ */
+bool SimulatedGpioBackend::setup() {
+    is_setup.store(true);
+    return true;
+}
+
+/**
+ * Set a pin to input or output mode.
+ *
+ * @param pin The pin number.
+ * @param mode The pin mode.
+ * @throws std::invalid_argument if the pin is out of range.
+ */
+void SimulatedGpioBackend::set_mode(const unsigned int pin, const PinMode mode) {
+    const uint64_t bit = pin_bit(pin);
+    if (mode == PinMode::output) {
+        output_pins.fetch_or(bit);
+    } else {
+        output_pins.fetch_and(~bit);
+    }
+}
+
+/**
+ * Set the level of a pin. Writes to input pins are counted but
+ * do not change the level, like on the real pins.
+ *
+ * @param pin The pin number.
+ * @param level true for high, false for low.
+ * @throws std::invalid_argument if the pin is out of range.
+ */
+void SimulatedGpioBackend::write(const unsigned int pin, const bool level) {
+    const uint64_t bit = pin_bit(pin);
+    write_count.fetch_add(1, std::memory_order_relaxed);
+    if ((output_pins.load() & bit) == 0) {
+        record(levels.load());
+        return;
+    }
+    if (level) {
+        record(levels.fetch_or(bit) | bit);
+    } else {
+        record(levels.fetch_and(~bit) & ~bit);
+    }
+}
+
+/**
+ * Set several pins in one update, counted as one write.
+ * Pins that are not outputs keep their level.
+ *
+ * @param pins The pins to write.
+ * @param count The number of pins, at most 32.
+ * @param new_levels Bit i is the level for pins[i].
+ * @throws std::invalid_argument if a pin is out of range.
+ */
+void SimulatedGpioBackend::write_outputs(const unsigned int* pins, const size_t count, const uint32_t new_levels) {
+    uint64_t mask = 0;
+    uint64_t bits = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t bit = pin_bit(pins[i]);
+        mask |= bit;
+        if ((new_levels >> i) & 1) {
+            bits |= bit;
+        }
+    }
+    write_count.fetch_add(1, std::memory_order_relaxed);
+    mask &= output_pins.load();
+    uint64_t current = levels.load();
+    while (!levels.compare_exchange_weak(current, (current & ~mask) | (bits & mask))) {
+    }
+    record((current & ~mask) | (bits & mask));
+}
+
+/**
+ * Get whether setup() was called.
+ *
+ * @return true if set up, else false.
+ */
+bool SimulatedGpioBackend::get_is_setup() const {
+    return is_setup.load();
+}
+
+/**
+ * Get the mode of a pin.
+ *
+ * @param pin The pin number.
+ * @return The pin mode.
+ */
+PinMode SimulatedGpioBackend::get_mode(const unsigned int pin) const {
+    return (output_pins.load() & pin_bit(pin)) != 0 ? PinMode::output : PinMode::input;
+}
+
+/**
+ * Get the level of a pin.
+ *
+ * @param pin The pin number.
+ * @return true if high, else false.
+ */
+bool SimulatedGpioBackend::get_level(const unsigned int pin) const {
+    return (levels.load() & pin_bit(pin)) != 0;
+}
+
+/**
+ * Get the levels of all pins.
+ *
+ * @return Bit n is the level of pin n.
+ */
+uint64_t SimulatedGpioBackend::get_levels() const {
+    return levels.load();
+}
+
+/**
+ * Get the number of device writes.
+ *
+ * @return The write count.
+ */
+uint64_t SimulatedGpioBackend::get_write_count() const {
+    return write_count.load();
+}
+
+/**
+ * Start adding an event to the timeline on every write. Recording
+ * stops by itself once the timeline holds max_events events.
+ *
+ * @param max_events The most events to keep.
+ */
+void SimulatedGpioBackend::start_recording(const size_t max_events) {
+    std::lock_guard<std::mutex> lock(timeline_mutex);
+    max_timeline_events = max_events;
+    timeline.reserve(std::min<size_t>(max_events, 1 << 16));
+    is_recording.store(true);
+}
+
+/**
+ * Stop adding events to the timeline. Keeps the recorded events.
+ */
+void SimulatedGpioBackend::stop_recording() {
+    is_recording.store(false);
+}
+
+/**
+ * Get whether writes are being recorded.
+ *
+ * @return true if recording, else false.
+ */
+bool SimulatedGpioBackend::get_is_recording() const {
+    return is_recording.load();
+}
+
+/**
+ * Get a copy of the recorded writes, oldest first.
+ *
+ * @return The timeline.
+ */
+std::vector<GpioEvent> SimulatedGpioBackend::get_timeline() const {
+    std::lock_guard<std::mutex> lock(timeline_mutex);
+    return timeline;
+}
+
+/**
+ * Drop the recorded writes.
+ */
+void SimulatedGpioBackend::clear_timeline() {
+    std::lock_guard<std::mutex> lock(timeline_mutex);
+    timeline.clear();
+}
+
+/**
+ * Add the levels after a write to the timeline if recording.
+ *
+ * @param new_levels Bit n is the level of pin n.
+ */
+void SimulatedGpioBackend::record(const uint64_t new_levels) {
+    if (!is_recording.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const int64_t timestamp_ns = monotonic_now_ns();
+    std::lock_guard<std::mutex> lock(timeline_mutex);
+    if (timeline.size() >= max_timeline_events) {
+        is_recording.store(false);
+        return;
+    }
+    timeline.push_back({timestamp_ns, new_levels});
+}
+
+/**
+ * Get the level mask bit of a pin.
+ *
+ * @param pin The pin number.
+ * @return The bit for the pin.
+ * @throws std::invalid_argument if the pin is out of range.
+ */
+uint64_t SimulatedGpioBackend::pin_bit(const unsigned int pin) {
+    if (pin >= pin_count) {
+        throw std::invalid_argument("Simulated GPIO pin out of range.");
+    }
+    return uint64_t{1} << pin;
+}
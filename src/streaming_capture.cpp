@@ -0,0 +1,152 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <chrono>
+#include "streaming_capture.h"
+
+using namespace std;
+
+/**
+ * Set up streaming from the given source. The ring is sized from
+ * the source, so the source configuration should not change while
+ * streaming.
+ *
+ * @param source The frame source.
+ * @param slot_count The number of frames the ring holds.
+ * @param policy What to do with new frames when the ring is full.
+ */
+StreamingCapture::StreamingCapture(unique_ptr<FrameSource> source, const size_t slot_count, const DropPolicy policy)
+    : source(std::move(source)), ring(slot_count, this->source->get_frame_size(), policy), running(false),
+      failed(0) {
+}
+
+/**
+ * Stop the capture thread if still running.
+ */
+StreamingCapture::~StreamingCapture() {
+    stop();
+}
+
+/**
+ * Start the capture thread. Does nothing if already running.
+ */
+void StreamingCapture::start() {
+    if (running.exchange(true)) {
+        return;
+    }
+    capture_thread = thread(&StreamingCapture::capture_loop, this);
+}
+
+/**
+ * Stop the capture thread after the frame in progress. Frames
+ * already in the ring can still be read.
+ */
+void StreamingCapture::stop() {
+    running.store(false);
+    if (capture_thread.joinable()) {
+        capture_thread.join();
+    }
+}
+
+/**
+ * Get whether the capture thread is running.
+ *
+ * @return true if running, else false.
+ */
+bool StreamingCapture::is_running() const {
+    return running.load();
+}
+
+/**
+ * Copy the oldest unread frame. Does not wait.
+ *
+ * @param frame The image to copy into.
+ * @return true if a frame was copied, else false.
+ */
+bool StreamingCapture::get_next_frame(Image& frame) {
+    return ring.pop_next(frame);
+}
+
+/**
+ * Copy the newest frame and skip older unread ones. Does not wait.
+ *
+ * @param frame The image to copy into.
+ * @return true if a frame was copied, else false.
+ */
+bool StreamingCapture::get_latest_frame(Image& frame) {
+    return ring.pop_latest(frame);
+}
+
+/**
+ * Copy the oldest unread frame, waiting for one up to the timeout.
+ * Polls the ring so the capture thread never waits on the consumer.
+ *
+ * @param frame The image to copy into.
+ * @param timeout_ms The longest time to wait in milliseconds.
+ * @return true if a frame was copied, else false.
+ */
+bool StreamingCapture::wait_next_frame(Image& frame, const unsigned int timeout_ms) {
+    const auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+    while (!ring.pop_next(frame)) {
+        if (chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        this_thread::sleep_for(chrono::microseconds(200));
+    }
+    return true;
+}
+
+/**
+ * Get the number of frames captured into the ring.
+ *
+ * @return The captured count.
+ */
+uint64_t StreamingCapture::get_captured_count() const {
+    return ring.get_written_count();
+}
+
+/**
+ * Get the number of frames lost because the ring was full.
+ *
+ * @return The dropped count.
+ */
+uint64_t StreamingCapture::get_dropped_count() const {
+    return ring.get_dropped_count();
+}
+
+/**
+ * Get the number of failed reads from the source.
+ *
+ * @return The failed count.
+ */
+uint64_t StreamingCapture::get_failed_count() const {
+    return failed.load();
+}
+
+/**
+ * Read frames from the source into the ring until stopped. When the ring
+ * drops new frames the source is still read, into a spare frame, so the
+ * stream keeps its pace.
+ */
+void StreamingCapture::capture_loop() {
+    Image spare(source->get_frame_size(), 0, 0, PixelFormat::none, false);
+    uint64_t sequence = 0;
+    while (running.load(memory_order_relaxed)) {
+        Image* frame = ring.begin_write();
+        if (frame == nullptr) {
+            source->read_frame(spare);
+            ++sequence;
+            continue;
+        }
+        if (!source->read_frame(*frame)) {
+            // Publish nothing, the slot is rewritten next time round.
+            ring.abort_write();
+            failed.fetch_add(1, memory_order_relaxed);
+            this_thread::sleep_for(chrono::milliseconds(1));
+            continue;
+        }
+        const auto now = chrono::steady_clock::now().time_since_epoch();
+        frame->set_frame_info({sequence++, chrono::duration_cast<chrono::nanoseconds>(now).count()});
+        ring.commit_write();
+    }
+}
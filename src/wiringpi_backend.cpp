@@ -0,0 +1,34 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <wiringPi.h>
+#include "wiringpi_backend.h"
+
+/**
+ * Set up wiringPi with wiringPi pin numbering.
+ *
+ * @return true if setup succeeded, else false.
+ */
+bool WiringPiBackend::setup() {
+    return wiringPiSetup() != -1;
+}
+
+/**
+ * Set a pin to input or output mode.
+ *
+ * @param pin The wiringPi pin number.
+ * @param mode The pin mode.
+ */
+void WiringPiBackend::set_mode(const unsigned int pin, const PinMode mode) {
+    pinMode(static_cast<int>(pin), mode == PinMode::output ? OUTPUT : INPUT);
+}
+
+/**
+ * Drive an output pin high or low.
+ *
+ * @param pin The wiringPi pin number.
+ * @param level true for high, false for low.
+ */
+void WiringPiBackend::write(const unsigned int pin, const bool level) {
+    digitalWrite(static_cast<int>(pin), level ? 1 : 0);
+}
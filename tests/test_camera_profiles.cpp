@@ -0,0 +1,190 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <memory>
+#include "camera_control.h"
+#include "simulated_camera_backend.h"
+#include "test_check.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Number of times each setting was sent to the camera.
+ */
+struct SettingCalls {
+    int width = 0;
+    int height = 0;
+    int encoding = 0;
+    int sharpness = 0;
+    int contrast = 0;
+    int brightness = 0;
+    int saturation = 0;
+    int iso = 0;
+
+    [[nodiscard]] int total() const {
+        return width + height + encoding + sharpness + contrast + brightness + saturation + iso;
+    }
+};
+
+/**
+ * Simulated camera that counts every setting it is sent.
+ */
+class CountingCameraBackend : public SimulatedCameraBackend {
+
+public:
+    SettingCalls calls;
+
+    void set_width(const unsigned int new_width) override {
+        ++calls.width;
+        SimulatedCameraBackend::set_width(new_width);
+    }
+
+    void set_height(const unsigned int new_height) override {
+        ++calls.height;
+        SimulatedCameraBackend::set_height(new_height);
+    }
+
+    void set_encoding(const PixelFormat new_encoding) override {
+        ++calls.encoding;
+        SimulatedCameraBackend::set_encoding(new_encoding);
+    }
+
+    void set_sharpness(int) override {
+        ++calls.sharpness;
+    }
+
+    void set_contrast(int) override {
+        ++calls.contrast;
+    }
+
+    void set_brightness(unsigned int) override {
+        ++calls.brightness;
+    }
+
+    void set_saturation(int) override {
+        ++calls.saturation;
+    }
+
+    void set_iso(int) override {
+        ++calls.iso;
+    }
+};
+
+/**
+ * Make a controller on the counting camera with a preview profile, the
+ * same preview at another iso and sharpness, and a full size profile.
+ *
+ * @param camera Set to the camera the controller sends settings to.
+ * @return The controller.
+ */
+unique_ptr<CameraController> make_controller(CountingCameraBackend*& camera) {
+    auto backend = make_unique<CountingCameraBackend>();
+    camera = backend.get();
+    auto controller = make_unique<CameraController>(std::move(backend));
+    CameraConfig preview;
+    preview.encoding = PixelFormat::rgb;
+    CameraConfig preview_low_light = preview;
+    preview_low_light.iso = 800;
+    preview_low_light.sharpness = 20;
+    CameraConfig full = preview;
+    full.image_width = 1280;
+    full.image_height = 960;
+    controller->add_profile("preview", preview, 0);
+    controller->add_profile("preview_low_light", preview_low_light, 0);
+    controller->add_profile("full", full, 0);
+    return controller;
+}
+
+/**
+ * The constructor sends every setting once, and a switch sends only
+ * the ones that differ from the current settings.
+ */
+void test_switch_sends_changed_settings() {
+    CountingCameraBackend* camera = nullptr;
+    const auto controller = make_controller(camera);
+    CHECK_EQ(8, camera->calls.total());
+
+    camera->calls = SettingCalls();
+    CHECK(controller->use_profile("preview"));
+    CHECK_EQ(1, camera->calls.encoding);
+    CHECK_EQ(1, camera->calls.total());
+
+    camera->calls = SettingCalls();
+    CHECK(controller->use_profile("preview_low_light"));
+    CHECK_EQ(1, camera->calls.iso);
+    CHECK_EQ(1, camera->calls.sharpness);
+    CHECK_EQ(2, camera->calls.total());
+
+    camera->calls = SettingCalls();
+    CHECK(controller->use_profile("preview_low_light"));
+    CHECK_EQ(0, camera->calls.total());
+
+    camera->calls = SettingCalls();
+    CHECK(controller->use_profile("full"));
+    CHECK_EQ(1, camera->calls.width);
+    CHECK_EQ(1, camera->calls.height);
+    CHECK_EQ(1, camera->calls.iso);
+    CHECK_EQ(1, camera->calls.sharpness);
+    CHECK_EQ(4, camera->calls.total());
+    CHECK_EQ(string("full"), controller->get_profile_name());
+    CHECK_EQ(1280u, controller->get_image_width());
+    CHECK_EQ(960u, controller->get_image_height());
+}
+
+/**
+ * An open camera is reopened only when the width, height or encoding
+ * changes, and a closed camera is never opened by a switch.
+ */
+void test_reopen_only_on_format_change() {
+    CountingCameraBackend* camera = nullptr;
+    const auto controller = make_controller(camera);
+    CHECK(controller->use_profile("preview"));
+    CHECK_EQ(0ul, camera->get_open_count());
+    CHECK(!camera->get_is_open());
+
+    controller->open_camera();
+    CHECK_EQ(1ul, camera->get_open_count());
+    CHECK(controller->use_profile("preview_low_light"));
+    CHECK(controller->use_profile("preview"));
+    CHECK_EQ(1ul, camera->get_open_count());
+
+    CHECK(controller->use_profile("full"));
+    CHECK_EQ(2ul, camera->get_open_count());
+    CHECK(controller->get_is_open());
+    CHECK(controller->use_profile("preview_low_light"));
+    CHECK_EQ(3ul, camera->get_open_count());
+
+    CameraConfig preview_png;
+    preview_png.iso = 800;
+    preview_png.sharpness = 20;
+    controller->add_profile("preview_png", preview_png, 0);
+    CHECK(controller->use_profile("preview_png"));
+    CHECK_EQ(4ul, camera->get_open_count());
+}
+
+/**
+ * Captures after a switch are the size worked out when the profile was added.
+ */
+void test_capture_after_switch() {
+    CountingCameraBackend* camera = nullptr;
+    const auto controller = make_controller(camera);
+    controller->open_camera();
+    for (const char* name : {"preview", "full", "preview_low_light"}) {
+        CHECK(controller->use_profile(name));
+        Image image;
+        CHECK(controller->capture_image(image));
+        CHECK_EQ(controller->get_profile_buffer_size(name), image.get_size());
+        CHECK(image.get_data() == camera->get_last_buffer());
+    }
+}
+
+}
+
+int main() {
+    test_switch_sends_changed_settings();
+    test_reopen_only_on_format_change();
+    test_capture_after_switch();
+    return check_result();
+}
@@ -0,0 +1,236 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "camera_control.h"
+#include "frame_buffer_pool.h"
+#include "simulated_camera_backend.h"
+#include "test_check.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Simulated camera that records whether exposure was locked for each
+ * capture and every lock change it is sent. Can fail a capture on purpose.
+ */
+class LockRecordingCameraBackend : public SimulatedCameraBackend {
+
+public:
+    vector<bool> locked_at_grab;
+    vector<bool> lock_calls;
+    size_t fail_at_grab = SIZE_MAX;
+
+    void set_exposure_locked(const bool locked) override {
+        lock_calls.push_back(locked);
+        SimulatedCameraBackend::set_exposure_locked(locked);
+    }
+
+    bool grab_retrieve(unsigned char* data, const size_t size) override {
+        if (locked_at_grab.size() == fail_at_grab) {
+            return false;
+        }
+        locked_at_grab.push_back(get_exposure_locked());
+        return SimulatedCameraBackend::grab_retrieve(data, size);
+    }
+};
+
+/**
+ * Make an open camera on a simulated backend.
+ *
+ * @param camera Set to the simulated backend the controller captures from.
+ * @return The controller.
+ */
+template <typename Backend>
+unique_ptr<CameraController> make_controller(Backend*& camera) {
+    auto backend = make_unique<Backend>();
+    camera = backend.get();
+    auto controller = make_unique<CameraController>(std::move(backend));
+    controller->set_image_width(320);
+    controller->set_image_height(240);
+    controller->open_camera();
+    return controller;
+}
+
+/**
+ * Get the number of buffers handed out by the pool, reused or new.
+ *
+ * @return Hits plus misses.
+ */
+unsigned long pool_acquisitions() {
+    const FrameBufferPoolStats stats = FrameBufferPool::instance().get_stats();
+    return stats.hits + stats.misses;
+}
+
+/**
+ * A returned image is filled in place: one buffer from the pool and
+ * the camera wrote straight into it.
+ */
+void test_capture_returns_camera_buffer() {
+    SimulatedCameraBackend* camera = nullptr;
+    const auto controller = make_controller(camera);
+    for (int capture = 0; capture < 3; ++capture) {
+        const unsigned long grabs = camera->get_grab_count();
+        const unsigned long acquisitions = pool_acquisitions();
+        Image image = controller->capture_image();
+        CHECK_EQ(grabs + 1, camera->get_grab_count());
+        CHECK_EQ(acquisitions + 1, pool_acquisitions());
+        CHECK(image.get_data() == camera->get_last_buffer());
+        CHECK_EQ(controller->get_image_buffer_size(), image.get_size());
+    }
+}
+
+/**
+ * Capturing again into the same image reuses its buffer, with no pool
+ * acquisition at all.
+ */
+void test_capture_into_image_reuses_buffer() {
+    SimulatedCameraBackend* camera = nullptr;
+    const auto controller = make_controller(camera);
+    Image image;
+    CHECK(controller->capture_image(image));
+    const unsigned char* data = image.get_data();
+    CHECK(data == camera->get_last_buffer());
+    const unsigned long acquisitions = pool_acquisitions();
+    for (int capture = 0; capture < 3; ++capture) {
+        const unsigned long grabs = camera->get_grab_count();
+        CHECK(controller->capture_image(image));
+        CHECK_EQ(grabs + 1, camera->get_grab_count());
+        CHECK(image.get_data() == data);
+        CHECK(camera->get_last_buffer() == data);
+    }
+    CHECK_EQ(acquisitions, pool_acquisitions());
+}
+
+/**
+ * Capturing into a caller's buffer writes there and leaves the pool alone.
+ */
+void test_capture_into_caller_buffer() {
+    SimulatedCameraBackend* camera = nullptr;
+    const auto controller = make_controller(camera);
+    vector<unsigned char> buffer(controller->get_image_buffer_size());
+    const unsigned long acquisitions = pool_acquisitions();
+    const unsigned long grabs = camera->get_grab_count();
+    CHECK(controller->capture_image(buffer.data(), buffer.size()));
+    CHECK_EQ(grabs + 1, camera->get_grab_count());
+    CHECK(camera->get_last_buffer() == buffer.data());
+    CHECK_EQ(acquisitions, pool_acquisitions());
+}
+
+/**
+ * A burst is one buffer from the pool, and each frame is a view into it
+ * at its own offset that the camera wrote straight into.
+ */
+void test_burst_frames_share_one_buffer() {
+    SimulatedCameraBackend* camera = nullptr;
+    const auto controller = make_controller(camera);
+    const size_t size = controller->get_image_buffer_size();
+    const unsigned long acquisitions = pool_acquisitions();
+    const unsigned long grabs = camera->get_grab_count();
+    const FrameBurst burst = controller->capture_burst(4);
+    CHECK_EQ(acquisitions + 1, pool_acquisitions());
+    CHECK_EQ(grabs + 4, camera->get_grab_count());
+    CHECK_EQ(size_t{4}, burst.frames.size());
+    CHECK_EQ(size, burst.frame_stride);
+    CHECK(burst.capacity >= 4 * size);
+    for (size_t i = 0; i < burst.frames.size(); ++i) {
+        const Image& frame = burst.frames[i];
+        CHECK(frame.get_data() == burst.buffer.get() + i * size);
+        CHECK_EQ(size, frame.get_size());
+        CHECK_EQ(uint64_t{i}, frame.get_frame_info().sequence);
+        CHECK(frame.is_shared());
+    }
+    CHECK(camera->get_last_buffer() == burst.frames.back().get_data());
+    // Each frame is a different capture of the moving gradient.
+    CHECK(memcmp(burst.frames[0].get_data(), burst.frames[1].get_data(), size) != 0);
+}
+
+/**
+ * Exposure and white balance are locked once the first frame is in,
+ * held for the rest and set back to auto afterwards, even when a
+ * capture fails partway.
+ */
+void test_burst_locks_exposure_after_first_frame() {
+    LockRecordingCameraBackend* camera = nullptr;
+    const auto controller = make_controller(camera);
+    FrameBurst burst;
+    CHECK(controller->capture_burst(4, burst));
+    CHECK_EQ(size_t{4}, camera->locked_at_grab.size());
+    CHECK(camera->locked_at_grab == vector<bool>({false, true, true, true}));
+    CHECK(camera->lock_calls == vector<bool>({true, false}));
+    CHECK(!camera->get_exposure_locked());
+
+    camera->locked_at_grab.clear();
+    camera->lock_calls.clear();
+    CHECK(controller->capture_burst(3, burst, false));
+    CHECK(camera->locked_at_grab == vector<bool>({false, false, false}));
+    CHECK(camera->lock_calls.empty());
+
+    // A single frame has nothing to match, so nothing is locked.
+    camera->lock_calls.clear();
+    CHECK(controller->capture_burst(1, burst));
+    CHECK(camera->lock_calls.empty());
+
+    camera->locked_at_grab.clear();
+    camera->fail_at_grab = 2;
+    CHECK(!controller->capture_burst(4, burst));
+    CHECK_EQ(size_t{2}, burst.frames.size());
+    CHECK(camera->lock_calls == vector<bool>({true, false}));
+    CHECK(!camera->get_exposure_locked());
+
+    bool threw = false;
+    try {
+        controller->capture_burst(0, burst);
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+/**
+ * Capturing again into a burst nothing else holds reuses its buffer
+ * with no pool acquisition. A frame kept from the last burst keeps
+ * its pixels, and the next burst gets a buffer of its own.
+ */
+void test_reused_burst_does_not_reallocate() {
+    SimulatedCameraBackend* camera = nullptr;
+    const auto controller = make_controller(camera);
+    FrameBurst burst;
+    CHECK(controller->capture_burst(3, burst));
+    const unsigned char* buffer = burst.buffer.get();
+    const unsigned long acquisitions = pool_acquisitions();
+    for (int repeat = 0; repeat < 3; ++repeat) {
+        CHECK(controller->capture_burst(3, burst));
+        CHECK(burst.buffer.get() == buffer);
+        CHECK(burst.frames.front().get_data() == buffer);
+    }
+    // Fewer frames fit in the same buffer.
+    CHECK(controller->capture_burst(2, burst));
+    CHECK(burst.buffer.get() == buffer);
+    CHECK_EQ(acquisitions, pool_acquisitions());
+
+    const Image kept = burst.frames[1];
+    const vector<unsigned char> kept_pixels(kept.get_data(), kept.get_data() + kept.get_size());
+    CHECK(controller->capture_burst(2, burst));
+    CHECK_EQ(acquisitions + 1, pool_acquisitions());
+    CHECK(burst.buffer.get() != buffer);
+    CHECK(kept.get_data() == buffer + burst.frame_stride);
+    CHECK(memcmp(kept.get_data(), kept_pixels.data(), kept_pixels.size()) == 0);
+}
+
+}
+
+int main() {
+    test_capture_returns_camera_buffer();
+    test_capture_into_image_reuses_buffer();
+    test_capture_into_caller_buffer();
+    test_burst_frames_share_one_buffer();
+    test_burst_locks_exposure_after_first_frame();
+    test_reused_burst_does_not_reallocate();
+    return check_result();
+}
@@ -0,0 +1,46 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <iostream>
+
+// Failed checks in this test executable. main() returns non zero when
+// there are any, so ctest reports the test as failed.
+inline int check_failures = 0;
+
+// Unlike assert, kept in release builds, and a failure does not stop the test.
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << '\n'; \
+            ++check_failures; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(expected, actual) \
+    do { \
+        const auto& check_expected = (expected); \
+        const auto& check_actual = (actual); \
+        if (!(check_expected == check_actual)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQ(" #expected ", " #actual ") failed, " \
+                      << check_expected << " != " << check_actual << '\n'; \
+            ++check_failures; \
+        } \
+    } while (0)
+
+/**
+ * Get the exit code of a test executable.
+ *
+ * @return 0 if every check passed, else 1.
+ */
+inline int check_result() {
+    if (check_failures != 0) {
+        std::cerr << check_failures << " check(s) failed" << '\n';
+        return 1;
+    }
+    return 0;
+}
+
+#endif //TEST_CHECK_H
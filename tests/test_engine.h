@@ -0,0 +1,21 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#ifndef TEST_ENGINE_H
+#define TEST_ENGINE_H
+
+#include "motion_engine.h"
+
+/**
+ * Motion thread settings that work without root: no pinning, no SCHED_FIFO.
+ *
+ * @return The engine config.
+ */
+inline MotionEngineConfig unprivileged_engine() {
+    MotionEngineConfig engine_config;
+    engine_config.pin_thread = false;
+    engine_config.realtime = false;
+    return engine_config;
+}
+
+#endif //TEST_ENGINE_H
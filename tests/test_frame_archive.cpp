@@ -0,0 +1,214 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "frame_archive.h"
+#include "test_check.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Get a path for an archive in the temp directory.
+ *
+ * @param name The file name.
+ * @return The path.
+ */
+string archive_path(const string& name) {
+    return (filesystem::temp_directory_path() / ("raspi_hw_" + name + ".rhwa")).string();
+}
+
+/**
+ * Make a frame whose pixels and frame info follow from a seed.
+ *
+ * @param width The width in pixels.
+ * @param height The height in rows.
+ * @param format The pixel format.
+ * @param seed The first pixel byte and the sequence number.
+ * @return The frame.
+ */
+Image make_frame(const unsigned int width, const unsigned int height, const PixelFormat format,
+                 const unsigned char seed) {
+    Image frame(pixel_format_frame_size(format, width, height), width, height, format, false);
+    for (size_t i = 0; i < frame.get_size(); ++i) {
+        frame.get_data()[i] = static_cast<unsigned char>(seed + i * 7);
+    }
+    FrameInfo info;
+    info.sequence = seed;
+    info.timestamp_ns = 1000000 * static_cast<int64_t>(seed);
+    frame.set_frame_info(info);
+    return frame;
+}
+
+/**
+ * Check if two images hold the same packed pixels, size and format.
+ * The source can be a crop view.
+ */
+bool same_pixels(const Image& expected, const Image& actual) {
+    if (expected.get_width() != actual.get_width() || expected.get_height() != actual.get_height() ||
+        expected.get_format() != actual.get_format()) {
+        return false;
+    }
+    const size_t row_size = pixel_format_row_size(expected.get_format(), expected.get_width());
+    for (unsigned int row = 0; row < expected.get_height(); ++row) {
+        if (memcmp(expected.get_data() + row * expected.get_stride(), actual.get_data() + row * actual.get_stride(),
+                   row_size) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Frames of different formats, a crop view among them, read back with
+ * their pixels and frame info, each on a page boundary.
+ */
+void test_round_trip() {
+    const string file_path = archive_path("round_trip");
+    Image with_motor = make_frame(17, 5, PixelFormat::rgb, 3);
+    FrameInfo info = with_motor.get_frame_info();
+    info.motor_position = -1234;
+    info.has_motor_position = true;
+    with_motor.set_frame_info(info);
+    const Image full = make_frame(40, 20, PixelFormat::rgba, 9);
+    const vector<Image> frames = {with_motor, make_frame(31, 7, PixelFormat::gray, 5), full.crop(3, 2, 21, 11),
+                                  make_frame(4, 4, PixelFormat::yuv420, 11)};
+    {
+        FrameArchiveWriter writer(file_path, 8);
+        CHECK_EQ(uint32_t{8}, writer.get_capacity());
+        for (const Image& frame : frames) {
+            CHECK(writer.append(frame));
+        }
+        CHECK_EQ(uint64_t{frames.size()}, writer.get_frame_count());
+    }
+
+    const FrameArchiveReader reader(file_path);
+    CHECK_EQ(uint64_t{frames.size()}, reader.get_frame_count());
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const Image frame = reader.get_frame(i);
+        CHECK(same_pixels(frames[i], frame));
+        CHECK(frame.is_contiguous());
+        CHECK(!frame.get_has_header());
+        CHECK_EQ(uint64_t{0}, reader.get_entry(i).offset % 4096);
+        CHECK_EQ(uintptr_t{0}, reinterpret_cast<uintptr_t>(frame.get_data()) % 4096);
+        const FrameInfo& expected_info = frames[i].get_frame_info();
+        const FrameInfo& actual_info = frame.get_frame_info();
+        CHECK_EQ(expected_info.sequence, actual_info.sequence);
+        CHECK_EQ(expected_info.timestamp_ns, actual_info.timestamp_ns);
+        CHECK_EQ(expected_info.has_motor_position, actual_info.has_motor_position);
+        CHECK_EQ(expected_info.motor_position, actual_info.motor_position);
+    }
+    CHECK_EQ(int64_t{-1234}, reader.get_frame(0).get_frame_info().motor_position);
+
+    bool threw = false;
+    try {
+        (void)reader.get_frame(frames.size());
+    } catch (const out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+    remove(file_path.c_str());
+}
+
+/**
+ * Appending past the capacity, or after close(), fails and leaves the
+ * frames already written alone.
+ */
+void test_capacity_limit() {
+    const string file_path = archive_path("capacity");
+    FrameArchiveWriter writer(file_path, 2);
+    CHECK(writer.append(make_frame(8, 8, PixelFormat::gray, 1)));
+    CHECK(writer.append(make_frame(8, 8, PixelFormat::gray, 2)));
+    CHECK(!writer.append(make_frame(8, 8, PixelFormat::gray, 3)));
+    CHECK_EQ(uint64_t{2}, writer.get_frame_count());
+    writer.close();
+    CHECK(!writer.append(make_frame(8, 8, PixelFormat::gray, 4)));
+
+    const FrameArchiveReader reader(file_path);
+    CHECK_EQ(uint64_t{2}, reader.get_frame_count());
+    CHECK_EQ(uint64_t{2}, reader.get_frame(1).get_frame_info().sequence);
+    remove(file_path.c_str());
+}
+
+/**
+ * A file cut short, as after a crash, shows only the frames whose data
+ * is all there. A file cut into its index is turned down.
+ */
+void test_truncated_file() {
+    const string file_path = archive_path("truncated");
+    const vector<Image> frames = {make_frame(64, 32, PixelFormat::rgb, 1), make_frame(64, 32, PixelFormat::rgb, 2),
+                                  make_frame(64, 32, PixelFormat::rgb, 3)};
+    uint64_t last_offset = 0;
+    {
+        FrameArchiveWriter writer(file_path, 4);
+        for (const Image& frame : frames) {
+            CHECK(writer.append(frame));
+        }
+        // A reader opened while the writer is still going sees every frame appended so far.
+        const FrameArchiveReader reader(file_path);
+        CHECK_EQ(uint64_t{3}, reader.get_frame_count());
+        last_offset = reader.get_entry(2).offset;
+    }
+
+    filesystem::resize_file(file_path, last_offset + frames[2].get_size() - 1);
+    {
+        const FrameArchiveReader reader(file_path);
+        CHECK_EQ(uint64_t{2}, reader.get_frame_count());
+        CHECK(same_pixels(frames[1], reader.get_frame(1)));
+    }
+    filesystem::resize_file(file_path, last_offset);
+    CHECK_EQ(uint64_t{2}, FrameArchiveReader(file_path).get_frame_count());
+
+    filesystem::resize_file(file_path, sizeof(FrameArchiveHeader) + sizeof(FrameArchiveEntry));
+    bool threw = false;
+    try {
+        FrameArchiveReader reader(file_path);
+    } catch (const runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+    remove(file_path.c_str());
+}
+
+/**
+ * A frame keeps the mapping alive after the reader is gone, and
+ * changing its pixels changes neither the file nor other readers.
+ */
+void test_frame_outlives_reader() {
+    const string file_path = archive_path("outlives");
+    const Image original = make_frame(33, 9, PixelFormat::rgb, 7);
+    {
+        FrameArchiveWriter writer(file_path, 1);
+        CHECK(writer.append(original));
+    }
+    Image frame;
+    {
+        const auto reader = make_unique<FrameArchiveReader>(file_path);
+        frame = reader->get_frame(0);
+    }
+    CHECK(same_pixels(original, frame));
+    frame.get_data()[0] ^= 0xff;
+    CHECK(!same_pixels(original, frame));
+
+    const FrameArchiveReader reader(file_path);
+    CHECK(same_pixels(original, reader.get_frame(0)));
+    remove(file_path.c_str());
+}
+
+}
+
+int main() {
+    test_round_trip();
+    test_capacity_limit();
+    test_truncated_file();
+    test_frame_outlives_reader();
+    return check_result();
+}
@@ -0,0 +1,103 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <memory>
+#include <vector>
+#include "frame_buffer_pool.h"
+#include "test_check.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Get whether the next acquire of a size is served from the pool.
+ * The buffer goes straight back.
+ *
+ * @param size The size in bytes.
+ * @return true if it was a pool hit, else false.
+ */
+bool is_pooled(const size_t size) {
+    FrameBufferPool& pool = FrameBufferPool::instance();
+    const unsigned long hits = pool.get_stats().hits;
+    pool.acquire(size).reset();
+    return pool.get_stats().hits == hits + 1;
+}
+
+/**
+ * Releasing buffers of many sizes keeps the free bytes under the cap.
+ */
+void test_many_sizes_stay_under_cap() {
+    FrameBufferPool& pool = FrameBufferPool::instance();
+    pool.clear();
+    pool.set_max_free_bytes(64 * 1024);
+    for (size_t size = 1000; size < 1000 + 500 * 7; size += 7) {
+        pool.acquire(size).reset();
+        CHECK(pool.get_stats().bytes_pooled <= 64 * 1024);
+    }
+    CHECK(pool.get_stats().bytes_pooled > 0);
+}
+
+/**
+ * The least recently used size goes first, and using a size keeps it.
+ */
+void test_least_recently_used_slab_evicted() {
+    FrameBufferPool& pool = FrameBufferPool::instance();
+    pool.clear();
+    pool.set_max_free_bytes(2500);
+    pool.acquire(1000).reset();
+    pool.acquire(1001).reset();
+    CHECK(is_pooled(1000));
+    pool.acquire(1002).reset();
+    CHECK(is_pooled(1000));
+    CHECK(is_pooled(1002));
+    CHECK(!is_pooled(1001));
+}
+
+/**
+ * A slab can be trimmed on its own once it is the only one over the cap,
+ * and a buffer bigger than the cap is never kept.
+ */
+void test_single_slab_trimmed() {
+    FrameBufferPool& pool = FrameBufferPool::instance();
+    pool.clear();
+    pool.set_max_free_bytes(2500);
+    pool.reserve(1000, 4);
+    CHECK_EQ(size_t{2000}, pool.get_stats().bytes_pooled);
+    const unsigned long frees = pool.get_stats().frees;
+    pool.acquire(4000).reset();
+    CHECK_EQ(frees + 1, pool.get_stats().frees);
+    CHECK_EQ(size_t{2000}, pool.get_stats().bytes_pooled);
+}
+
+/**
+ * Lowering the cap frees buffers right away, and buffers in use are left alone.
+ */
+void test_lower_cap_evicts_now() {
+    FrameBufferPool& pool = FrameBufferPool::instance();
+    pool.clear();
+    pool.set_max_free_bytes(size_t{1} << 20);
+    vector<shared_ptr<unsigned char>> held;
+    for (size_t size = 2000; size < 2010; ++size) {
+        held.push_back(pool.acquire(size));
+    }
+    held.resize(5);
+    CHECK(pool.get_stats().bytes_pooled > 0);
+    const size_t allocated = pool.get_stats().bytes_allocated;
+    const size_t pooled = pool.get_stats().bytes_pooled;
+    pool.set_max_free_bytes(0);
+    CHECK_EQ(size_t{0}, pool.get_stats().bytes_pooled);
+    CHECK_EQ(allocated - pooled, pool.get_stats().bytes_allocated);
+    held.clear();
+    CHECK_EQ(size_t{0}, pool.get_stats().bytes_pooled);
+}
+
+}
+
+int main() {
+    test_many_sizes_stay_under_cap();
+    test_least_recently_used_slab_evicted();
+    test_single_slab_trimmed();
+    test_lower_cap_evicts_now();
+    return check_result();
+}
@@ -0,0 +1,151 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include "frame_ring.h"
+#include "test_check.h"
+
+using namespace std;
+
+namespace {
+
+constexpr unsigned int frame_width = 16;
+constexpr unsigned int frame_height = 8;
+constexpr size_t frame_size = static_cast<size_t>(frame_width) * frame_height * 3;
+
+/**
+ * Write one frame whose bytes and sequence number both come from the position.
+ *
+ * @param ring The ring.
+ * @param sequence The frame number.
+ * @return true if the frame was published, false if the ring dropped it.
+ */
+bool write_frame(FrameRing& ring, const uint64_t sequence) {
+    Image* frame = ring.begin_write();
+    if (frame == nullptr) {
+        return false;
+    }
+    frame->reset(frame_size, frame_width, frame_height, PixelFormat::rgb, false);
+    memset(frame->get_data(), static_cast<unsigned char>(sequence), frame_size);
+    frame->set_frame_info({sequence, static_cast<int64_t>(sequence)});
+    ring.commit_write();
+    return true;
+}
+
+/**
+ * Check that a popped frame is whole: every byte matches its sequence number.
+ *
+ * @param frame The frame.
+ */
+void check_whole(const Image& frame) {
+    CHECK_EQ(frame_size, frame.get_size());
+    CHECK_EQ(frame_width, frame.get_width());
+    const auto expected = static_cast<unsigned char>(frame.get_frame_info().sequence);
+    for (size_t i = 0; i < frame.get_size(); ++i) {
+        if (frame.get_data()[i] != expected) {
+            CHECK(frame.get_data()[i] == expected);
+            return;
+        }
+    }
+}
+
+/**
+ * Frames come out in order with their description.
+ */
+void test_pop_in_order() {
+    FrameRing ring(4, frame_size, DropPolicy::drop_oldest);
+    for (uint64_t sequence = 0; sequence < 3; ++sequence) {
+        CHECK(write_frame(ring, sequence));
+    }
+    Image frame;
+    for (uint64_t sequence = 0; sequence < 3; ++sequence) {
+        CHECK(ring.pop_next(frame));
+        CHECK_EQ(sequence, frame.get_frame_info().sequence);
+        check_whole(frame);
+    }
+    CHECK(!ring.pop_next(frame));
+}
+
+/**
+ * An aborted write publishes nothing, and the frame it may have
+ * clobbered is dropped instead of read torn.
+ */
+void test_abort_write() {
+    FrameRing ring(2, frame_size, DropPolicy::drop_oldest);
+    CHECK(write_frame(ring, 0));
+    CHECK(write_frame(ring, 1));
+    Image* frame = ring.begin_write();
+    CHECK(frame != nullptr);
+    memset(frame->get_data(), 0xff, frame_size);
+    ring.abort_write();
+    CHECK_EQ(uint64_t{2}, ring.get_written_count());
+    Image popped;
+    CHECK(ring.pop_next(popped));
+    CHECK_EQ(uint64_t{1}, popped.get_frame_info().sequence);
+    CHECK_EQ(uint64_t{1}, ring.get_dropped_count());
+    CHECK(!ring.pop_next(popped));
+    // The slot is usable again after the abort.
+    CHECK(write_frame(ring, 2));
+    CHECK(ring.pop_next(popped));
+    CHECK_EQ(uint64_t{2}, popped.get_frame_info().sequence);
+    check_whole(popped);
+}
+
+/**
+ * A frame that outgrew its slot is dropped rather than published over
+ * a buffer the consumer does not read.
+ */
+void test_outgrown_frame_dropped() {
+    FrameRing ring(2, frame_size, DropPolicy::drop_oldest);
+    Image* frame = ring.begin_write();
+    frame->reset(frame_size * 2, frame_width * 2, frame_height, PixelFormat::rgb, false);
+    ring.commit_write();
+    CHECK_EQ(uint64_t{0}, ring.get_written_count());
+    CHECK_EQ(uint64_t{1}, ring.get_dropped_count());
+    CHECK(write_frame(ring, 7));
+    Image popped;
+    CHECK(ring.pop_next(popped));
+    check_whole(popped);
+}
+
+/**
+ * A consumer racing a producer that laps it only ever sees whole frames.
+ */
+void test_concurrent_frames_are_whole() {
+    for (const DropPolicy policy : {DropPolicy::drop_oldest, DropPolicy::drop_newest}) {
+        FrameRing ring(3, frame_size, policy);
+        atomic<bool> done(false);
+        thread producer([&ring, &done] {
+            for (uint64_t sequence = 0; sequence < 200000; ++sequence) {
+                write_frame(ring, sequence);
+            }
+            done.store(true);
+        });
+        Image frame;
+        uint64_t popped = 0;
+        uint64_t last_sequence = 0;
+        while (!done.load() || ring.get_available() > 0) {
+            const bool got = popped % 2 == 0 ? ring.pop_next(frame) : ring.pop_latest(frame);
+            if (got) {
+                check_whole(frame);
+                CHECK(popped == 0 || frame.get_frame_info().sequence > last_sequence);
+                last_sequence = frame.get_frame_info().sequence;
+                ++popped;
+            }
+        }
+        producer.join();
+        CHECK(popped > 0);
+    }
+}
+
+}
+
+int main() {
+    test_pop_in_order();
+    test_abort_write();
+    test_outgrown_frame_dropped();
+    test_concurrent_frames_are_whole();
+    return check_result();
+}
@@ -0,0 +1,142 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "image_ops.h"
+#include "test_check.h"
+
+using namespace std;
+
+namespace {
+
+// Widths on both sides of the 16 pixel vector step and the 32 pixel rotation
+// tiles, and odd heights, some of them past one tile.
+constexpr size_t widths[] = {1, 2, 3, 5, 7, 8, 15, 16, 17, 21, 31, 32, 33, 47, 63, 64, 65, 100, 129};
+constexpr size_t heights[] = {1, 2, 3, 5, 7, 9, 16, 17, 33, 65};
+// Extra bytes past each row, which the kernels must leave alone.
+constexpr size_t row_padding = 5;
+
+/**
+ * Fill a buffer with bytes from a fixed seed, so every run checks the same data.
+ *
+ * @param size The size in bytes.
+ * @param seed The seed.
+ * @return The buffer.
+ */
+vector<unsigned char> make_pattern(const size_t size, uint32_t seed) {
+    vector<unsigned char> data(size);
+    for (unsigned char& byte : data) {
+        seed = seed * 1664525u + 1013904223u;
+        byte = static_cast<unsigned char>(seed >> 24);
+    }
+    return data;
+}
+
+/**
+ * Count a failed check if a kernel result differs from its reference.
+ *
+ * @param name The kernel.
+ * @param width The width in pixels.
+ * @param height The height in rows.
+ * @param expected The scalar result.
+ * @param actual The kernel result.
+ */
+void check_same(const char* name, const size_t width, const size_t height, const vector<unsigned char>& expected,
+                const vector<unsigned char>& actual) {
+    if (expected != actual) {
+        cerr << name << " " << width << "x" << height << " differs from the scalar result" << '\n';
+        ++check_failures;
+    }
+}
+
+using InPlaceKernel = void (*)(unsigned char*, size_t, size_t, size_t);
+using OutOfPlaceKernel = void (*)(const unsigned char*, size_t, size_t, size_t, unsigned char*, size_t);
+
+/**
+ * Check an in place rgb kernel against its scalar reference at every size.
+ *
+ * @param name The kernel, for failure messages.
+ * @param kernel The kernel.
+ * @param scalar The reference.
+ * @param rows true if the kernel takes a row size in bytes instead of a width in pixels.
+ */
+void check_in_place(const char* name, const InPlaceKernel kernel, const InPlaceKernel scalar, const bool rows) {
+    for (const size_t width : widths) {
+        for (const size_t height : heights) {
+            const size_t stride = width * 3 + row_padding;
+            vector<unsigned char> expected = make_pattern(stride * height, static_cast<uint32_t>(width * 131 + height));
+            vector<unsigned char> actual = expected;
+            const size_t size = rows ? width * 3 : width;
+            scalar(expected.data(), size, height, stride);
+            kernel(actual.data(), size, height, stride);
+            check_same(name, width, height, expected, actual);
+        }
+    }
+}
+
+/**
+ * Check an out of place rgb kernel that swaps width and height against
+ * its scalar reference at every size.
+ *
+ * @param name The kernel, for failure messages.
+ * @param kernel The kernel.
+ * @param scalar The reference.
+ */
+void check_out_of_place(const char* name, const OutOfPlaceKernel kernel, const OutOfPlaceKernel scalar) {
+    for (const size_t width : widths) {
+        for (const size_t height : heights) {
+            const size_t src_stride = width * 3 + row_padding;
+            const size_t dst_stride = height * 3 + row_padding + 2;
+            const vector<unsigned char> src = make_pattern(src_stride * height, static_cast<uint32_t>(width + height));
+            vector<unsigned char> expected = make_pattern(dst_stride * width, 7);
+            vector<unsigned char> actual = expected;
+            scalar(src.data(), width, height, src_stride, expected.data(), dst_stride);
+            kernel(src.data(), width, height, src_stride, actual.data(), dst_stride);
+            check_same(name, width, height, expected, actual);
+        }
+    }
+}
+
+/**
+ * Mirroring each row matches the scalar flip.
+ */
+void test_flip_h() {
+    check_in_place("flip_rgb_h", flip_rgb_h_kernel, flip_rgb_h_scalar, false);
+}
+
+/**
+ * Swapping rows matches the scalar flip, including the middle row of odd heights.
+ */
+void test_flip_v() {
+    check_in_place("flip_rows_v", flip_rows_v_kernel, flip_rows_v_scalar, true);
+}
+
+/**
+ * Rotating in place matches the scalar rotation.
+ */
+void test_rotate_180() {
+    check_in_place("rotate_rgb_180", rotate_rgb_180_kernel, rotate_rgb_180_scalar, false);
+}
+
+/**
+ * The quarter turns and the transpose match their scalar versions,
+ * including the tiles cut short at the right and bottom edges.
+ */
+void test_rotate_90_270_transpose() {
+    check_out_of_place("rotate_rgb_90", rotate_rgb_90_kernel, rotate_rgb_90_scalar);
+    check_out_of_place("rotate_rgb_270", rotate_rgb_270_kernel, rotate_rgb_270_scalar);
+    check_out_of_place("transpose_rgb", transpose_rgb_kernel, transpose_rgb_scalar);
+}
+
+}
+
+int main() {
+    cout << "Checking " << get_simd_backend_name() << " kernels" << '\n';
+    test_flip_h();
+    test_flip_v();
+    test_rotate_180();
+    test_rotate_90_270_transpose();
+    return check_result();
+}
@@ -0,0 +1,124 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "image.h"
+#include "image_thread_pool.h"
+#include "test_check.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Make a packed rgb image with a pattern that differs per pixel.
+ *
+ * @param width The image width.
+ * @param height The image height.
+ * @return The image.
+ */
+Image make_rgb(const unsigned int width, const unsigned int height) {
+    Image image(static_cast<size_t>(width) * height * 3, width, height, PixelFormat::rgb, false);
+    for (size_t i = 0; i < image.get_size(); ++i) {
+        image.get_data()[i] = static_cast<unsigned char>(i * 31 + i / 7);
+    }
+    return image;
+}
+
+/**
+ * Check that two images have the same size and bytes.
+ *
+ * @param expected The serial result.
+ * @param actual The banded result.
+ */
+void check_same(const Image& expected, const Image& actual) {
+    CHECK_EQ(expected.get_width(), actual.get_width());
+    CHECK_EQ(expected.get_height(), actual.get_height());
+    CHECK_EQ(expected.get_size(), actual.get_size());
+    if (expected.get_size() == actual.get_size()) {
+        CHECK(memcmp(expected.get_data(), actual.get_data(), expected.get_size()) == 0);
+    }
+}
+
+/**
+ * Every row is in exactly one band, and no band is empty or past the
+ * end, for row counts that do not split evenly into 12 bands.
+ */
+void test_bands_cover_every_row_once() {
+    for (const size_t rows : {16, 17, 95, 98, 99, 101, 103, 109, 1079}) {
+        mutex band_mutex;
+        vector<pair<size_t, size_t>> bands;
+        ImageThreadPool::instance().run(rows, 1, 0, [&](const size_t first_row, const size_t last_row) {
+            lock_guard lock(band_mutex);
+            bands.emplace_back(first_row, last_row);
+        });
+        vector<int> seen(rows, 0);
+        for (const auto& [first_row, last_row] : bands) {
+            CHECK(first_row < last_row);
+            CHECK(last_row <= rows);
+            for (size_t row = first_row; row < min(last_row, rows); ++row) {
+                ++seen[row];
+            }
+        }
+        for (size_t row = 0; row < rows; ++row) {
+            CHECK_EQ(1, seen[row]);
+        }
+    }
+}
+
+/**
+ * Downscaling a 4k frame by factors that leave uneven bands matches
+ * the serial result.
+ */
+void test_downscale_matches_serial() {
+    const Image image = make_rgb(3840, 2160);
+    for (const unsigned int factor : {2u, 7u, 13u, 22u}) {
+        check_same(image.downscale(factor, 1), image.downscale(factor));
+    }
+}
+
+/**
+ * Resizing to a height that does not split evenly matches the serial result.
+ */
+void test_resize_matches_serial() {
+    const Image image = make_rgb(643, 487);
+    for (const ResizeFilter filter : {ResizeFilter::bilinear, ResizeFilter::area}) {
+        check_same(image.resize(211, 101, filter, 1), image.resize(211, 101, filter));
+    }
+}
+
+/**
+ * Flips and conversions of odd heights match the serial result.
+ */
+void test_flip_and_convert_match_serial() {
+    for (const unsigned int height : {101u, 109u, 487u}) {
+        const Image image = make_rgb(333, height);
+        Image serial = image.clone();
+        Image banded = image.clone();
+        serial.flip_rgb_h(1);
+        banded.flip_rgb_h();
+        check_same(serial, banded);
+        serial.flip_rgb_v(1);
+        banded.flip_rgb_v();
+        check_same(serial, banded);
+        CHECK(serial.convert_to(PixelFormat::gray, 1));
+        CHECK(banded.convert_to(PixelFormat::gray));
+        check_same(serial, banded);
+    }
+}
+
+}
+
+int main() {
+    // Split every operation, on more threads than most test machines have cores.
+    ImageThreadPool::instance().set_thread_count(12);
+    ImageThreadPool::instance().set_min_parallel_bytes(0);
+    test_bands_cover_every_row_once();
+    test_downscale_matches_serial();
+    test_resize_matches_serial();
+    test_flip_and_convert_match_serial();
+    return check_result();
+}
@@ -0,0 +1,251 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "image_writer.h"
+#include "test_check.h"
+
+using namespace std;
+
+namespace {
+
+constexpr unsigned int image_width = 33;
+constexpr unsigned int image_height = 7;
+
+/**
+ * Make a gray image whose bytes start from a seed, so each saved file can be told apart.
+ *
+ * @param seed The first byte.
+ * @return The image.
+ */
+Image make_image(const unsigned char seed) {
+    Image image(image_width * image_height, image_width, image_height, PixelFormat::gray, false);
+    for (size_t i = 0; i < image.get_size(); ++i) {
+        image.get_data()[i] = static_cast<unsigned char>(seed + i);
+    }
+    return image;
+}
+
+/**
+ * Check if a file holds exactly the bytes of an image.
+ *
+ * @param file_path The file.
+ * @param image The image that was saved to it.
+ * @return true if the contents match, else false.
+ */
+bool file_matches(const string& file_path, const Image& image) {
+    ifstream file(file_path, ios::binary);
+    const vector<char> contents((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    return contents.size() == image.get_size() &&
+           equal(contents.begin(), contents.end(), reinterpret_cast<const char*>(image.get_data()));
+}
+
+/**
+ * Make an empty directory to save into, removed again when it goes out of scope.
+ */
+class TempDirectory {
+
+public:
+    TempDirectory() {
+        string pattern = (filesystem::temp_directory_path() / "raspi_hw_writer_XXXXXX").string();
+        CHECK(mkdtemp(pattern.data()) != nullptr);
+        path = pattern;
+    }
+    ~TempDirectory() {
+        error_code error;
+        filesystem::remove_all(path, error);
+    }
+    [[nodiscard]] string file(const string& name) const {
+        return (filesystem::path(path) / name).string();
+    }
+
+private:
+    string path;
+};
+
+/**
+ * Wait until the writer thread has taken every queued job, or give up after a second.
+ *
+ * @param writer The writer.
+ * @return true if the queue emptied, else false.
+ */
+bool wait_until_taken(const ImageWriter& writer) {
+    for (int i = 0; i < 1000 && writer.get_queued_count() != 0; ++i) {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return writer.get_queued_count() == 0;
+}
+
+/**
+ * A full queue turns try_save_async() down and makes save_async() wait
+ * until a writer thread takes a job.
+ */
+void test_full_queue_pushes_back() {
+    const TempDirectory directory;
+    ImageWriterConfig config;
+    config.queue_capacity = 2;
+    config.max_batch = 1;
+    ImageWriter writer(config);
+    const Image image = make_image(1);
+
+    // The first job holds the only writer thread in its callback until released.
+    promise<void> release;
+    shared_future<void> released = release.get_future().share();
+    writer.save_async(image, directory.file("held.gray"), [released](bool) { released.wait(); });
+    CHECK(wait_until_taken(writer));
+
+    CHECK(writer.try_save_async(image, directory.file("queued_0.gray"), nullptr));
+    CHECK(writer.try_save_async(image, directory.file("queued_1.gray"), nullptr));
+    CHECK(!writer.try_save_async(image, directory.file("turned_down.gray"), nullptr));
+    CHECK_EQ(size_t{2}, writer.get_queued_count());
+
+    future<future<bool>> waiting = async(launch::async, [&] {
+        return writer.save_async(image, directory.file("waited.gray"));
+    });
+    CHECK(waiting.wait_for(chrono::milliseconds(50)) == future_status::timeout);
+    release.set_value();
+    CHECK(waiting.get().get());
+    writer.flush();
+
+    CHECK_EQ(0ul, writer.get_failed_count());
+    CHECK_EQ(4ul, writer.get_saved_count());
+    CHECK(!filesystem::exists(directory.file("turned_down.gray")));
+    CHECK(file_matches(directory.file("waited.gray"), image));
+}
+
+/**
+ * Futures and callbacks get true for a saved image and false for one
+ * that could not be saved, and the counters agree.
+ */
+void test_results_reach_future_and_callback() {
+    const TempDirectory directory;
+    ImageWriter writer;
+    const Image image = make_image(2);
+
+    CHECK(writer.save_async(image, directory.file("saved.gray")).get());
+    CHECK(!writer.save_async(image, directory.file("missing/saved.gray")).get());
+    CHECK(!writer.save_async(Image(), directory.file("empty.gray")).get());
+
+    promise<bool> saved_result;
+    promise<bool> failed_result;
+    writer.save_async(image, directory.file("callback.gray"), [&saved_result](const bool saved) {
+        saved_result.set_value(saved);
+    });
+    writer.save_async(image, directory.file("missing/callback.gray"), [&failed_result](const bool saved) {
+        failed_result.set_value(saved);
+    });
+    CHECK(saved_result.get_future().get());
+    CHECK(!failed_result.get_future().get());
+
+    // A callback that throws is logged and does not stop the writer.
+    writer.save_async(image, directory.file("throwing.gray"), [](bool) {
+        throw runtime_error("Simulated callback failure.");
+    });
+    writer.flush();
+    CHECK(writer.save_async(image, directory.file("after.gray")).get());
+
+    CHECK_EQ(4ul, writer.get_saved_count());
+    CHECK_EQ(3ul, writer.get_failed_count());
+    CHECK_EQ(4ull * image.get_size(), writer.get_bytes_written());
+    CHECK(file_matches(directory.file("saved.gray"), image));
+    CHECK(file_matches(directory.file("callback.gray"), image));
+}
+
+/**
+ * With per_batch, a writer thread writes every file of a batch before
+ * reporting any of them, and each one is saved whole.
+ */
+void test_per_batch_writes_whole_batch_first() {
+    const TempDirectory directory;
+    ImageWriterConfig config;
+    config.max_batch = 8;
+    config.fsync_policy = FsyncPolicy::per_batch;
+    ImageWriter writer(config);
+
+    promise<void> release;
+    shared_future<void> released = release.get_future().share();
+    writer.save_async(make_image(0), directory.file("held.gray"), [released](bool) { released.wait(); });
+    CHECK(wait_until_taken(writer));
+
+    // Queued while the writer is held, so they go out as one batch.
+    vector<Image> images;
+    vector<future<bool>> results;
+    images.reserve(config.max_batch);
+    atomic<bool> batch_written_first{false};
+    for (unsigned char i = 0; i < config.max_batch; ++i) {
+        images.push_back(make_image(static_cast<unsigned char>(10 + i)));
+        const string file_path = directory.file("batch_" + to_string(i) + ".gray");
+        if (i == 0) {
+            writer.save_async(images.back(), file_path, [&](bool) {
+                bool all_written = true;
+                for (unsigned char j = 0; j < config.max_batch; ++j) {
+                    all_written = all_written && file_matches(directory.file("batch_" + to_string(j) + ".gray"),
+                                                              images[j]);
+                }
+                batch_written_first = all_written;
+            });
+        } else {
+            results.push_back(writer.save_async(images.back(), file_path));
+        }
+    }
+    CHECK_EQ(config.max_batch, writer.get_queued_count());
+    release.set_value();
+    for (future<bool>& result : results) {
+        CHECK(result.get());
+    }
+    writer.flush();
+
+    CHECK(batch_written_first.load());
+    CHECK_EQ(0ul, writer.get_failed_count());
+    CHECK_EQ(static_cast<unsigned long>(config.max_batch + 1), writer.get_saved_count());
+}
+
+/**
+ * Every policy saves the same bytes, across several writer threads.
+ */
+void test_fsync_policies_save_files() {
+    for (const FsyncPolicy policy : {FsyncPolicy::none, FsyncPolicy::per_file, FsyncPolicy::per_batch}) {
+        const TempDirectory directory;
+        ImageWriterConfig config;
+        config.thread_count = 2;
+        config.queue_capacity = 4;
+        config.max_batch = 3;
+        config.fsync_policy = policy;
+        vector<Image> images;
+        {
+            ImageWriter writer(config);
+            for (unsigned char i = 0; i < 12; ++i) {
+                images.push_back(make_image(static_cast<unsigned char>(i * 7)));
+                writer.save_async(images.back(), directory.file(to_string(i) + ".gray"), nullptr);
+            }
+            writer.flush();
+            CHECK_EQ(12ul, writer.get_saved_count());
+            CHECK_EQ(0ul, writer.get_failed_count());
+            CHECK_EQ(12ull * images.front().get_size(), writer.get_bytes_written());
+        }
+        for (size_t i = 0; i < images.size(); ++i) {
+            CHECK(file_matches(directory.file(to_string(i) + ".gray"), images[i]));
+        }
+    }
+}
+
+}
+
+int main() {
+    test_full_queue_pushes_back();
+    test_results_reach_future_and_callback();
+    test_per_batch_writes_whole_batch_first();
+    test_fsync_policies_save_files();
+    return check_result();
+}
@@ -0,0 +1,141 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <memory>
+#include <vector>
+#include "motion_engine.h"
+#include "realtime_thread.h"
+#include "simulated_gpio_backend.h"
+#include "test_check.h"
+#include "test_engine.h"
+
+using namespace std;
+
+namespace {
+
+constexpr unsigned int step_pin = 0;
+constexpr uint32_t step_interval_us = 500;
+// How late a step may be on a loaded machine without realtime scheduling.
+constexpr int64_t late_limit_ns = 50'000'000;
+
+/**
+ * Make an engine whose steps toggle one pin of the simulated GPIO.
+ *
+ * @param gpio The simulated GPIO, recording.
+ * @return The engine.
+ */
+unique_ptr<MotionEngine> make_engine(SimulatedGpioBackend& gpio) {
+    gpio.setup();
+    gpio.set_mode(step_pin, PinMode::output);
+    gpio.start_recording();
+    return make_unique<MotionEngine>([&gpio](int, const uint64_t step_index) {
+        gpio.write(step_pin, step_index % 2 == 0);
+    }, unprivileged_engine());
+}
+
+/**
+ * Every step reaches the pins, none before its absolute deadline and
+ * none far after it, so lateness does not add up over a move.
+ */
+void test_steps_follow_deadlines() {
+    SimulatedGpioBackend gpio;
+    const auto engine = make_engine(gpio);
+    StepCommand command;
+    command.steps = 400;
+    command.step_interval_us = step_interval_us;
+    const int64_t queued_ns = monotonic_now_ns();
+    CHECK(engine->queue(command).get());
+
+    const vector<GpioEvent> timeline = gpio.get_timeline();
+    CHECK_EQ(size_t{400}, timeline.size());
+    CHECK_EQ(uint64_t{400}, engine->get_step_count());
+    CHECK_EQ(int64_t{400}, engine->get_position());
+    for (size_t i = 0; i < timeline.size(); ++i) {
+        const int64_t deadline_ns = queued_ns + static_cast<int64_t>(i) * step_interval_us * 1000;
+        CHECK(timeline[i].timestamp_ns >= deadline_ns);
+    }
+    const int64_t move_ns = timeline.back().timestamp_ns - timeline.front().timestamp_ns;
+    CHECK(move_ns < 399 * int64_t{step_interval_us} * 1000 + late_limit_ns);
+}
+
+/**
+ * The jitter statistics count every step after the first of each
+ * command and are cleared by reset_jitter_stats().
+ */
+void test_jitter_stats() {
+    SimulatedGpioBackend gpio;
+    const auto engine = make_engine(gpio);
+    StepCommand command;
+    command.steps = 100;
+    command.step_interval_us = step_interval_us;
+    CHECK(engine->queue(command).get());
+    const JitterStats stats = engine->get_jitter_stats();
+    CHECK_EQ(uint64_t{99}, stats.sample_count);
+    CHECK(stats.min_ns >= 0);
+    CHECK(stats.min_ns <= stats.max_ns);
+    CHECK(stats.mean_ns >= static_cast<double>(stats.min_ns));
+    CHECK(stats.mean_ns <= static_cast<double>(stats.max_ns));
+    CHECK(stats.overrun_count <= stats.sample_count);
+    engine->reset_jitter_stats();
+    CHECK_EQ(uint64_t{0}, engine->get_jitter_stats().sample_count);
+}
+
+/**
+ * Queued commands run in order without blocking the caller, keep the
+ * step spacing across the join, and count backward steps down.
+ */
+void test_back_to_back_commands() {
+    SimulatedGpioBackend gpio;
+    const auto engine = make_engine(gpio);
+    StepCommand forward;
+    forward.steps = 50;
+    forward.step_interval_us = step_interval_us;
+    StepCommand backward = forward;
+    backward.steps = 20;
+    backward.direction = -1;
+    backward.position_increment = 2;
+    future<bool> first = engine->queue(forward);
+    future<bool> second = engine->queue(backward);
+    CHECK(!engine->is_idle());
+    engine->wait_idle();
+    CHECK(first.get());
+    CHECK(second.get());
+
+    const vector<GpioEvent> timeline = gpio.get_timeline();
+    CHECK_EQ(size_t{70}, timeline.size());
+    CHECK_EQ(int64_t{50 - 40}, engine->get_position());
+    for (size_t i = 1; i < timeline.size(); ++i) {
+        CHECK(timeline[i].timestamp_ns - timeline[i - 1].timestamp_ns >= 0);
+    }
+    const int64_t join_ns = timeline[50].timestamp_ns - timeline[49].timestamp_ns;
+    CHECK(join_ns >= int64_t{step_interval_us} * 1000 / 2);
+    CHECK(join_ns < late_limit_ns);
+}
+
+/**
+ * Per step delays set the spacing of each step.
+ */
+void test_step_delays() {
+    SimulatedGpioBackend gpio;
+    const auto engine = make_engine(gpio);
+    StepCommand command;
+    command.steps = 4;
+    command.step_delays_us = {1000, 5000, 1000, 1000};
+    const int64_t queued_ns = monotonic_now_ns();
+    CHECK(engine->queue(command).get());
+    const vector<GpioEvent> timeline = gpio.get_timeline();
+    CHECK_EQ(size_t{4}, timeline.size());
+    CHECK(timeline[1].timestamp_ns >= queued_ns + 1'000'000);
+    CHECK(timeline[2].timestamp_ns >= queued_ns + 6'000'000);
+    CHECK(timeline[3].timestamp_ns >= queued_ns + 7'000'000);
+}
+
+}
+
+int main() {
+    test_steps_follow_deadlines();
+    test_jitter_stats();
+    test_back_to_back_commands();
+    test_step_delays();
+    return check_result();
+}
@@ -0,0 +1,536 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "motor_control.h"
+#include "multi_axis_control.h"
+#include "simulated_gpio_backend.h"
+#include "test_check.h"
+#include "test_engine.h"
+
+using namespace std;
+
+namespace {
+
+constexpr unsigned int motor_pins[] = {25, 24, 23, 22};
+
+/**
+ * Make a motor on the simulated GPIO with its pins set to output.
+ *
+ * @param gpio Set to the simulated backend the motor writes to.
+ * @return The motor.
+ */
+unique_ptr<MotorController> make_motor(SimulatedGpioBackend*& gpio) {
+    auto backend = make_unique<SimulatedGpioBackend>();
+    gpio = backend.get();
+    auto motor = make_unique<MotorController>(std::move(backend), unprivileged_engine());
+    motor->set_to_output_mode();
+    return motor;
+}
+
+/**
+ * Get where the coil pattern of a write sits in the half step table.
+ * Wave and full step patterns are in it too. The pins are 25, 24, 23,
+ * 22, so the pattern follows from the levels of those pins.
+ *
+ * @param levels The pin levels after the write.
+ * @return The table index, or -1 for a pattern not in the table.
+ */
+int64_t half_step_index(const uint64_t levels) {
+    const StepSequence half_steps = step_sequence_for(DriveMode::half_step);
+    uint8_t mask = 0;
+    for (unsigned int i = 0; i < 4; ++i) {
+        mask |= static_cast<uint8_t>(((levels >> motor_pins[i]) & 1) << i);
+    }
+    for (uint32_t index = 0; index <= half_steps.index_mask; ++index) {
+        if (half_steps.forward[index] == mask) {
+            return static_cast<int64_t>(index);
+        }
+    }
+    return -1;
+}
+
+/**
+ * Net half steps the rotor turned in the write log, in any drive mode,
+ * from how far the coil pattern moved on each write. The motor starts
+ * at coil phase 0, the first entry of the table.
+ *
+ * @param timeline The recorded writes.
+ * @return Half steps forward minus half steps backward.
+ */
+int64_t net_half_steps(const vector<GpioEvent>& timeline) {
+    int64_t half_steps = 0;
+    int64_t previous = 0;
+    for (const GpioEvent& event : timeline) {
+        const int64_t current = half_step_index(event.levels);
+        CHECK(current >= 0);
+        // Patterns repeat every 8 half steps, so a move of 3 or less either way is unambiguous.
+        const int64_t change = (current - previous + 8) % 8;
+        CHECK(change != 4);
+        half_steps += change < 4 ? change : change - 8;
+        previous = current;
+    }
+    return half_steps;
+}
+
+/**
+ * Check that every write in the log moves the coil pattern exactly one
+ * step of the given size from the write before, so no step was skipped
+ * or repeated between moves.
+ *
+ * @param timeline The recorded writes.
+ * @param start_index The table index the coils were at before the first write.
+ * @param half_steps_per_step The step size of the drive mode, in half steps.
+ */
+void check_continuous(const vector<GpioEvent>& timeline, const int64_t start_index,
+                      const int64_t half_steps_per_step) {
+    int64_t previous = start_index;
+    for (const GpioEvent& event : timeline) {
+        const int64_t current = half_step_index(event.levels);
+        const int64_t change = (current - previous + 8) % 8;
+        CHECK(change == half_steps_per_step || change == 8 - half_steps_per_step);
+        previous = current;
+    }
+}
+
+/**
+ * Stopping a rotation partway leaves the position at the steps that reached the pins.
+ */
+void test_stop_during_rotate() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto motor = make_motor(gpio);
+    gpio->start_recording();
+    future<bool> moved = motor->rotate_async(90, 1);
+    this_thread::sleep_for(chrono::milliseconds(60));
+    motor->stop();
+    CHECK(!moved.get());
+    CHECK(!motor->is_moving());
+    const uint64_t writes = gpio->get_write_count();
+    CHECK(writes > 0);
+    CHECK(writes < 1024);
+    CHECK_EQ(static_cast<int64_t>(writes), motor->get_position());
+    CHECK_EQ(static_cast<int64_t>(writes), static_cast<int64_t>(gpio->get_timeline().size()));
+
+    // Nothing steps after stop() returns.
+    this_thread::sleep_for(chrono::milliseconds(10));
+    CHECK_EQ(writes, gpio->get_write_count());
+}
+
+/**
+ * Stopping move_to partway in full step mode counts two half steps per
+ * write, backward, and the next move_to still lands on its target.
+ */
+void test_stop_during_move_to() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto motor = make_motor(gpio);
+    motor->set_drive_mode(DriveMode::full_step);
+    gpio->start_recording();
+    future<bool> moved = motor->move_to_async(-90);
+    this_thread::sleep_for(chrono::milliseconds(60));
+    motor->stop();
+    CHECK(!moved.get());
+    const vector<GpioEvent> timeline = gpio->get_timeline();
+    CHECK(!timeline.empty());
+    CHECK_EQ(-static_cast<int64_t>(timeline.size()) * 2, motor->get_position());
+    CHECK_EQ(motor->get_position(), net_half_steps(timeline));
+
+    // The next move starts from where the motor stopped.
+    motor->move_to(0);
+    CHECK_EQ(int64_t{0}, motor->get_position());
+    CHECK_EQ(int64_t{0}, net_half_steps(gpio->get_timeline()));
+}
+
+/**
+ * Stopping drops queued moves as well, so they never reach the pins.
+ */
+void test_stop_drops_queued_moves() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto motor = make_motor(gpio);
+    future<bool> first = motor->move_by_async(45);
+    future<bool> second = motor->move_by_async(45);
+    this_thread::sleep_for(chrono::milliseconds(30));
+    motor->stop();
+    CHECK(!first.get());
+    CHECK(!second.get());
+    const int64_t stopped_at = motor->get_position();
+    CHECK_EQ(static_cast<int64_t>(gpio->get_write_count()), stopped_at);
+    CHECK(stopped_at < 512);
+    this_thread::sleep_for(chrono::milliseconds(10));
+    CHECK_EQ(stopped_at, motor->get_position());
+}
+
+/**
+ * Changing the pins and drive mode while a move runs leaves that move
+ * on the pins and step size it was queued with. The next move uses
+ * the new ones.
+ */
+void test_changes_apply_to_next_move() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto motor = make_motor(gpio);
+    for (unsigned int pin = 0; pin < 4; ++pin) {
+        gpio->set_mode(pin, PinMode::output);
+    }
+    gpio->start_recording();
+    future<bool> moved = motor->rotate_async(90, 1);
+    this_thread::sleep_for(chrono::milliseconds(20));
+    motor->set_pins(0, 1, 2, 3);
+    motor->set_drive_mode(DriveMode::full_step);
+    this_thread::sleep_for(chrono::milliseconds(20));
+    motor->stop();
+    CHECK(!moved.get());
+    const vector<GpioEvent> running = gpio->get_timeline();
+    CHECK(!running.empty());
+    CHECK_EQ(static_cast<int64_t>(running.size()), motor->get_position());
+    for (const GpioEvent& event : running) {
+        CHECK_EQ(uint64_t{0}, event.levels & 0xf);
+    }
+
+    gpio->clear_timeline();
+    const int64_t start = motor->get_position();
+    motor->rotate(1, 1);
+    const vector<GpioEvent> next = gpio->get_timeline();
+    CHECK(!next.empty());
+    CHECK_EQ(start + static_cast<int64_t>(next.size()) * 2, motor->get_position());
+    CHECK(next.back().levels & 0xf);
+}
+
+/**
+ * Switching between drive modes keeps the position equal to how far the
+ * rotor turned, including the half step that puts the coils on the grid
+ * of wave or full steps.
+ */
+void test_drive_mode_changes_keep_position() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto motor = make_motor(gpio);
+    gpio->start_recording();
+    constexpr double half_step_degrees = 360.0 / 4096;
+    const auto check_in_line = [&] {
+        const vector<GpioEvent> timeline = gpio->get_timeline();
+        CHECK_EQ(motor->get_position(), net_half_steps(timeline));
+        CHECK_EQ(int64_t{0}, ((half_step_index(timeline.back().levels) - motor->get_position()) % 8 + 8) % 8);
+    };
+
+    motor->move_by(4 * half_step_degrees);
+    CHECK_EQ(int64_t{4}, motor->get_position());
+    check_in_line();
+
+    // Coil phase 4 is a full step position, so wave mode first takes a half step.
+    motor->set_drive_mode(DriveMode::wave);
+    motor->move_by(10 * half_step_degrees);
+    CHECK_EQ(int64_t{15}, motor->get_position());
+    check_in_line();
+    motor->move_by(-6 * half_step_degrees);
+    CHECK_EQ(int64_t{7}, motor->get_position());
+    check_in_line();
+
+    motor->set_drive_mode(DriveMode::full_step);
+    motor->move_by(-20 * half_step_degrees);
+    CHECK_EQ(int64_t{-12}, motor->get_position());
+    check_in_line();
+
+    motor->set_drive_mode(DriveMode::half_step);
+    motor->move_by(3 * half_step_degrees);
+    CHECK_EQ(int64_t{-9}, motor->get_position());
+    check_in_line();
+
+    // Back to wave from an odd phase needs no extra half step, and a move of nothing moves nothing.
+    motor->set_drive_mode(DriveMode::wave);
+    const size_t writes = gpio->get_timeline().size();
+    motor->move_by(0);
+    CHECK_EQ(writes, gpio->get_timeline().size());
+    motor->move_to(0);
+    CHECK_EQ(int64_t{1}, motor->get_position());
+    check_in_line();
+}
+
+/**
+ * move_to() turns the short way round, across 0 and 360 both ways,
+ * without stepping back and forth on the way.
+ */
+void test_move_to_takes_shortest_path() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto motor = make_motor(gpio);
+    gpio->start_recording();
+    const auto check_move = [&](const double angle, const int64_t expected_position) {
+        const int64_t start = motor->get_position();
+        const size_t writes = gpio->get_timeline().size();
+        motor->move_to(angle);
+        CHECK_EQ(expected_position, motor->get_position());
+        // In half step mode every write is one half step, so as many writes as half steps means no back and forth.
+        CHECK_EQ(static_cast<size_t>(llabs(expected_position - start)), gpio->get_timeline().size() - writes);
+        CHECK_EQ(motor->get_position(), net_half_steps(gpio->get_timeline()));
+    };
+
+    // 350 is 10 degrees back across 0. 10 degrees is 113.8 half steps.
+    check_move(350, -114);
+    check_move(10, 114);
+    check_move(-20, -228);
+    // Whole turns in the target do not make the motor spin round.
+    check_move(725, 57);
+    check_move(-355, 57);
+    check_move(180 + 90, -1024);
+}
+
+/**
+ * Many moves smaller than a half step add up to the half steps of their
+ * total instead of each being rounded away.
+ */
+void test_small_moves_accumulate() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto motor = make_motor(gpio);
+    gpio->start_recording();
+    // 0.03 degrees is a third of a half step, and 300 of them are 9 degrees, 102.4 half steps.
+    for (int i = 0; i < 300; ++i) {
+        motor->move_by(0.03);
+    }
+    CHECK_EQ(int64_t{102}, motor->get_position());
+    CHECK_EQ(size_t{102}, gpio->get_timeline().size());
+    for (int i = 0; i < 300; ++i) {
+        motor->move_by(-0.03);
+    }
+    CHECK_EQ(int64_t{0}, motor->get_position());
+    CHECK_EQ(size_t{204}, gpio->get_timeline().size());
+    CHECK_EQ(int64_t{0}, net_half_steps(gpio->get_timeline()));
+
+    // In full step mode the remainder carries over until it is worth a whole step.
+    motor->set_drive_mode(DriveMode::full_step);
+    for (int i = 0; i < 40; ++i) {
+        motor->move_by(0.5);
+    }
+    // 20 degrees is 227.6 half steps, 113.8 full steps.
+    CHECK_EQ(int64_t{228}, motor->get_position());
+    CHECK_EQ(motor->get_position(), net_half_steps(gpio->get_timeline()));
+}
+
+/**
+ * The coils carry on from where the last move, including a stopped
+ * one, left them, whichever way the next move turns.
+ */
+void test_phase_continues_across_moves() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto motor = make_motor(gpio);
+    gpio->start_recording();
+    constexpr double half_step_degrees = 360.0 / 4096;
+    motor->move_by(5 * half_step_degrees);
+    motor->move_by(-3 * half_step_degrees);
+    motor->rotate(1, 1);
+    motor->rotate(2, -1);
+    future<bool> moved = motor->rotate_async(90, 1);
+    this_thread::sleep_for(chrono::milliseconds(15));
+    motor->stop();
+    CHECK(!moved.get());
+    motor->move_to(0);
+    motor->move_by(7 * half_step_degrees);
+    const vector<GpioEvent> timeline = gpio->get_timeline();
+    check_continuous(timeline, 0, 1);
+    CHECK_EQ(int64_t{7}, motor->get_position());
+    CHECK_EQ(motor->get_position(), net_half_steps(timeline));
+
+    // Full steps carry on from the phase the half steps left too.
+    motor->set_drive_mode(DriveMode::full_step);
+    gpio->clear_timeline();
+    motor->move_by(-4 * 2 * half_step_degrees);
+    motor->move_by(3 * 2 * half_step_degrees);
+    const vector<GpioEvent> full_steps = gpio->get_timeline();
+    CHECK(!full_steps.empty());
+    // Position 7 is off the full step grid, so the first write is the half step onto it.
+    check_continuous({full_steps.front()}, 7, 1);
+    check_continuous(vector<GpioEvent>(full_steps.begin() + 1, full_steps.end()), 6, 2);
+}
+
+/**
+ * home() steps until the switch closes and makes that position 0, and
+ * gives up after max_degrees when the switch never closes.
+ */
+void test_home_with_switch() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto motor = make_motor(gpio);
+    motor->rotate(4, 1);
+    const int64_t start = motor->get_position();
+    gpio->start_recording();
+    // The switch closes 37 half steps back from where the motor started.
+    int checks = 0;
+    const auto switch_closed = [&] {
+        ++checks;
+        return motor->get_position() <= -37;
+    };
+    CHECK(motor->home(switch_closed));
+    CHECK_EQ(int64_t{0}, motor->get_position());
+    check_continuous(gpio->get_timeline(), start % 8, 1);
+    CHECK_EQ(static_cast<size_t>(start + 37), gpio->get_timeline().size());
+    CHECK_EQ(static_cast<int>(start + 38), checks);
+
+    // Moves after homing measure from the switch.
+    gpio->clear_timeline();
+    motor->move_by(1);
+    CHECK_EQ(int64_t{11}, motor->get_position());
+    CHECK_EQ(size_t{11}, gpio->get_timeline().size());
+
+    // 5 degrees is 56 half steps, after which home() gives up where it got to.
+    gpio->clear_timeline();
+    CHECK(!motor->home([] { return false; }, 5, 1));
+    CHECK_EQ(int64_t{11 + 56}, motor->get_position());
+    CHECK_EQ(size_t{56}, gpio->get_timeline().size());
+}
+
+/**
+ * A saved position and coil phase load into a new motor, which then
+ * steps on from the coil pattern the old one was left at.
+ */
+void test_save_and_load_position() {
+    const string file_path = (filesystem::temp_directory_path() / "raspi_hw_motor_position.txt").string();
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto motor = make_motor(gpio);
+    gpio->start_recording();
+    constexpr double half_step_degrees = 360.0 / 4096;
+    motor->move_by(-29 * half_step_degrees);
+    CHECK_EQ(int64_t{-29}, motor->get_position());
+    const int64_t left_at = half_step_index(gpio->get_timeline().back().levels);
+    CHECK(motor->save_position(file_path));
+
+    SimulatedGpioBackend* next_gpio = nullptr;
+    const auto next_motor = make_motor(next_gpio);
+    CHECK(next_motor->load_position(file_path));
+    CHECK_EQ(int64_t{-29}, next_motor->get_position());
+    next_gpio->start_recording();
+    next_motor->move_to(0);
+    CHECK_EQ(int64_t{0}, next_motor->get_position());
+    const vector<GpioEvent> timeline = next_gpio->get_timeline();
+    CHECK_EQ(size_t{29}, timeline.size());
+    check_continuous(timeline, left_at, 1);
+    CHECK_EQ(int64_t{0}, half_step_index(timeline.back().levels));
+
+    // A file that does not parse leaves the position alone.
+    ofstream(file_path, ios::trunc) << "not a position" << endl;
+    CHECK(!next_motor->load_position(file_path));
+    CHECK_EQ(int64_t{0}, next_motor->get_position());
+    remove(file_path.c_str());
+    CHECK(!next_motor->load_position(file_path));
+}
+
+/**
+ * A constant profile steps at start_velocity, and
+ * a profile that could not start is turned down when set.
+ */
+void test_constant_profile_runs_at_start_velocity() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto motor = make_motor(gpio);
+    MotionProfileConfig profile = motor->get_motion_profile();
+    CHECK(profile.shape == ProfileShape::constant);
+    // The default keeps the 2 ms step of the fixed delay loop.
+    CHECK_EQ(uint32_t{2000}, get_step_interval_us(profile));
+    profile.start_velocity = 20000;
+    profile.max_velocity = 20000;
+    motor->set_motion_profile(profile);
+    CHECK_EQ(20000.0, motor->get_motion_profile().start_velocity);
+    gpio->start_recording();
+    motor->rotate(90, 1);
+    const vector<GpioEvent> timeline = gpio->get_timeline();
+    CHECK_EQ(size_t{1024}, timeline.size());
+    // 1023 intervals of 50 us, give or take when each write was stamped. The default profile takes about 2 s.
+    const uint64_t elapsed_ns = timeline.back().timestamp_ns - timeline.front().timestamp_ns;
+    CHECK(elapsed_ns >= 1000 * 50000ull);
+    CHECK(elapsed_ns < 1000000000ull);
+
+    profile.start_velocity = 30000;
+    bool threw = false;
+    try {
+        motor->set_motion_profile(profile);
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK_EQ(20000.0, motor->get_motion_profile().start_velocity);
+}
+
+/**
+ * Bad pins are turned down on the caller's thread, and the old pins stay.
+ */
+void test_bad_pins_rejected() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto motor = make_motor(gpio);
+    bool threw = false;
+    try {
+        motor->set_pins(25, 24, 23, 40);
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    gpio->start_recording();
+    motor->rotate(1, 1);
+    const vector<GpioEvent> timeline = gpio->get_timeline();
+    CHECK(!timeline.empty());
+    CHECK_EQ(static_cast<int64_t>(timeline.size()), motor->get_position());
+
+    MultiAxisController axes(make_unique<SimulatedGpioBackend>(), unprivileged_engine());
+    AxisConfig axis_config;
+    axis_config.w_pi_pins = {0, 1, 2, 32};
+    threw = false;
+    try {
+        axes.add_axis(axis_config);
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK_EQ(size_t{0}, axes.get_axis_count());
+}
+
+/**
+ * A step function that throws ends its command with the exception in
+ * the future, and the motion thread carries on with the next command.
+ */
+void test_step_error_is_recorded() {
+    MotionEngine engine(nullptr, unprivileged_engine());
+    StepCommand failing;
+    failing.steps = 10;
+    failing.step_interval_us = 100;
+    failing.on_step = [](int, const uint64_t step_index) {
+        if (step_index == 3) {
+            throw invalid_argument("Simulated GPIO pin out of range.");
+        }
+    };
+    future<bool> failed = engine.queue(std::move(failing));
+    StepCommand next;
+    next.steps = 5;
+    next.step_interval_us = 100;
+    next.on_step = [](int, uint64_t) {};
+    future<bool> ran = engine.queue(std::move(next));
+
+    bool threw = false;
+    try {
+        failed.get();
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+    CHECK(ran.get());
+    CHECK_EQ(uint64_t{1}, engine.get_error_count());
+    CHECK_EQ(int64_t{8}, engine.get_position());
+}
+
+}
+
+int main() {
+    test_stop_during_rotate();
+    test_stop_during_move_to();
+    test_stop_drops_queued_moves();
+    test_changes_apply_to_next_move();
+    test_drive_mode_changes_keep_position();
+    test_move_to_takes_shortest_path();
+    test_small_moves_accumulate();
+    test_phase_continues_across_moves();
+    test_home_with_switch();
+    test_save_and_load_position();
+    test_constant_profile_runs_at_start_velocity();
+    test_bad_pins_rejected();
+    test_step_error_is_recorded();
+    return check_result();
+}
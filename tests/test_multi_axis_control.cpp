@@ -0,0 +1,154 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "multi_axis_control.h"
+#include "simulated_gpio_backend.h"
+#include "test_check.h"
+#include "test_engine.h"
+
+using namespace std;
+
+namespace {
+
+constexpr size_t axis_count = 3;
+
+/**
+ * Make three half step axes on pins 0-3, 4-7 and 8-11 of the simulated
+ * GPIO, stepping fast so moves take a few milliseconds.
+ *
+ * @param gpio Set to the simulated backend the axes write to.
+ * @return The controller.
+ */
+unique_ptr<MultiAxisController> make_controller(SimulatedGpioBackend*& gpio) {
+    auto backend = make_unique<SimulatedGpioBackend>();
+    gpio = backend.get();
+    auto controller = make_unique<MultiAxisController>(std::move(backend), unprivileged_engine());
+    for (unsigned int axis = 0; axis < axis_count; ++axis) {
+        AxisConfig axis_config;
+        axis_config.w_pi_pins = {axis * 4, axis * 4 + 1, axis * 4 + 2, axis * 4 + 3};
+        controller->add_axis(axis_config);
+    }
+    MotionProfileConfig profile;
+    profile.start_velocity = 20000;
+    profile.max_velocity = 20000;
+    controller->set_motion_profile(profile);
+    controller->set_to_output_mode();
+    return controller;
+}
+
+/**
+ * Get the timeline events at which an axis took a step, that is where
+ * its four pins changed.
+ *
+ * @param timeline The recorded writes.
+ * @param axis The axis index.
+ * @return The event indexes.
+ */
+vector<size_t> axis_steps(const vector<GpioEvent>& timeline, const size_t axis) {
+    vector<size_t> steps;
+    uint64_t previous = 0;
+    for (size_t i = 0; i < timeline.size(); ++i) {
+        const uint64_t coils = (timeline[i].levels >> (axis * 4)) & 0xf;
+        if (coils != previous) {
+            steps.push_back(i);
+        }
+        previous = coils;
+    }
+    return steps;
+}
+
+/**
+ * A linear move steps every axis on the leading axis ticks, spreads the
+ * other axes evenly, and ends all of them on the same final tick.
+ */
+void test_axes_finish_together() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto controller = make_controller(gpio);
+    gpio->start_recording();
+    CHECK(controller->move_linear_async({90, 30, -45}).get());
+
+    const vector<int64_t> positions = controller->get_positions();
+    CHECK_EQ(int64_t{1024}, positions[0]);
+    CHECK_EQ(int64_t{341}, positions[1]);
+    CHECK_EQ(int64_t{-512}, positions[2]);
+
+    // One write per tick of the leading axis.
+    const vector<GpioEvent> timeline = gpio->get_timeline();
+    CHECK_EQ(size_t{1024}, timeline.size());
+    for (size_t axis = 0; axis < axis_count; ++axis) {
+        const vector<size_t> steps = axis_steps(timeline, axis);
+        CHECK_EQ(static_cast<size_t>(llabs(positions[axis])), steps.size());
+        CHECK_EQ(timeline.size() - 1, steps.back());
+        // Bresenham spacing: gaps between steps differ by at most one tick.
+        const size_t short_gap = timeline.size() / steps.size();
+        for (size_t i = 1; i < steps.size(); ++i) {
+            const size_t gap = steps[i] - steps[i - 1];
+            CHECK(gap == short_gap || gap == short_gap + 1);
+        }
+    }
+}
+
+/**
+ * With a ramped profile the ticks are uneven, but the axes still end
+ * on the same write, at the same time.
+ */
+void test_ramped_move_finishes_together() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto controller = make_controller(gpio);
+    MotionProfileConfig profile;
+    profile.shape = ProfileShape::trapezoidal;
+    profile.start_velocity = 5000;
+    profile.max_velocity = 20000;
+    profile.max_acceleration = 200000;
+    controller->set_motion_profile(profile);
+    gpio->start_recording();
+    controller->move_linear({-20, 45, 10});
+    const vector<GpioEvent> timeline = gpio->get_timeline();
+    const vector<int64_t> positions = controller->get_positions();
+    CHECK_EQ(int64_t{-228}, positions[0]);
+    CHECK_EQ(int64_t{512}, positions[1]);
+    CHECK_EQ(int64_t{114}, positions[2]);
+    CHECK_EQ(size_t{512}, timeline.size());
+    for (size_t axis = 0; axis < axis_count; ++axis) {
+        const vector<size_t> steps = axis_steps(timeline, axis);
+        CHECK_EQ(static_cast<size_t>(llabs(positions[axis])), steps.size());
+        CHECK_EQ(timeline.size() - 1, steps.back());
+    }
+}
+
+/**
+ * Stopping partway keeps each axis position equal to the steps it wrote.
+ */
+void test_stop_keeps_positions() {
+    SimulatedGpioBackend* gpio = nullptr;
+    const auto controller = make_controller(gpio);
+    MotionProfileConfig profile;
+    profile.start_velocity = 2000;
+    profile.max_velocity = 2000;
+    controller->set_motion_profile(profile);
+    gpio->start_recording();
+    future<bool> moved = controller->move_linear_async({360, -180, 90});
+    this_thread::sleep_for(chrono::milliseconds(50));
+    controller->stop();
+    CHECK(!moved.get());
+    const vector<GpioEvent> timeline = gpio->get_timeline();
+    CHECK(!timeline.empty());
+    CHECK(timeline.size() < 4096);
+    const vector<int64_t> positions = controller->get_positions();
+    CHECK_EQ(static_cast<int64_t>(axis_steps(timeline, 0).size()), positions[0]);
+    CHECK_EQ(-static_cast<int64_t>(axis_steps(timeline, 1).size()), positions[1]);
+    CHECK_EQ(static_cast<int64_t>(axis_steps(timeline, 2).size()), positions[2]);
+}
+
+}
+
+int main() {
+    test_axes_finish_together();
+    test_ramped_move_finishes_together();
+    test_stop_keeps_positions();
+    return check_result();
+}
@@ -0,0 +1,180 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "image_ops.h"
+#include "pixel_convert.h"
+#include "test_check.h"
+
+using namespace std;
+
+namespace {
+
+constexpr PixelFormat formats[] = {PixelFormat::rgb, PixelFormat::bgr, PixelFormat::rgba, PixelFormat::gray,
+                                   PixelFormat::yuv420};
+// Odd sizes on both sides of the 16 pixel vector step, so every kernel has a scalar tail
+// and yuv420 has a last chroma column and row covering one pixel.
+constexpr size_t widths[] = {1, 3, 5, 7, 15, 17, 31, 33, 47, 65};
+constexpr size_t heights[] = {1, 3, 5, 7, 9, 17};
+// Bytes past each frame, which a conversion must leave alone.
+constexpr size_t guard_size = 19;
+
+/**
+ * Fill a buffer with bytes from a fixed seed, so every run checks the same data.
+ *
+ * @param size The size in bytes.
+ * @param seed The seed.
+ * @return The buffer.
+ */
+vector<unsigned char> make_pattern(const size_t size, uint32_t seed) {
+    vector<unsigned char> data(size);
+    for (unsigned char& byte : data) {
+        seed = seed * 1664525u + 1013904223u;
+        byte = static_cast<unsigned char>(seed >> 24);
+    }
+    return data;
+}
+
+/**
+ * Count a failed check if a conversion result differs from the scalar one.
+ *
+ * @param how In place or out of place, for the failure message.
+ * @param src_format The source format.
+ * @param dst_format The destination format.
+ * @param width The width in pixels.
+ * @param height The height in rows.
+ * @param expected The scalar result.
+ * @param actual The result being checked.
+ */
+void check_same(const char* how, const PixelFormat src_format, const PixelFormat dst_format, const size_t width,
+                const size_t height, const vector<unsigned char>& expected, const vector<unsigned char>& actual) {
+    if (expected != actual) {
+        cerr << pixel_format_name(src_format) << " to " << pixel_format_name(dst_format) << " " << how << " "
+             << width << "x" << height << " differs from the scalar result" << '\n';
+        ++check_failures;
+    }
+}
+
+/**
+ * Every pair of formats converts out of place to the same bytes as the
+ * scalar conversion, from aligned and unaligned buffers, and leaves the
+ * bytes after the frame alone.
+ */
+void test_out_of_place_matches_scalar() {
+    for (const PixelFormat src_format : formats) {
+        for (const PixelFormat dst_format : formats) {
+            for (const size_t width : widths) {
+                for (const size_t height : heights) {
+                    const size_t src_size = pixel_format_frame_size(src_format, width, height);
+                    const size_t dst_size = pixel_format_frame_size(dst_format, width, height);
+                    const auto seed = static_cast<uint32_t>(width * 131 + height);
+                    for (const size_t offset : {size_t{0}, size_t{1}}) {
+                        vector<unsigned char> src = make_pattern(src_size + offset, seed);
+                        vector<unsigned char> expected = make_pattern(dst_size + offset + guard_size, 7);
+                        vector<unsigned char> actual = expected;
+                        CHECK(convert_pixels_scalar(src.data() + offset, src_format, expected.data() + offset,
+                                                    dst_format, width, height));
+                        CHECK(convert_pixels(src.data() + offset, src_format, actual.data() + offset, dst_format,
+                                             width, height));
+                        check_same("out of place", src_format, dst_format, width, height, expected, actual);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Every pair that can run in place, including packed to yuv420 with
+ * its chroma in a scratch buffer, gives the same frame as converting
+ * out of place with the scalar code.
+ */
+void test_in_place_matches_out_of_place() {
+    size_t pairs = 0;
+    for (const PixelFormat src_format : formats) {
+        for (const PixelFormat dst_format : formats) {
+            if (!can_convert_in_place(src_format, dst_format, 17, 9)) {
+                continue;
+            }
+            ++pairs;
+            for (const size_t width : widths) {
+                for (const size_t height : heights) {
+                    CHECK(can_convert_in_place(src_format, dst_format, width, height));
+                    const size_t src_size = pixel_format_frame_size(src_format, width, height);
+                    const size_t dst_size = pixel_format_frame_size(dst_format, width, height);
+                    const vector<unsigned char> src = make_pattern(src_size, static_cast<uint32_t>(width + height));
+                    vector<unsigned char> expected(dst_size);
+                    CHECK(convert_pixels_scalar(src.data(), src_format, expected.data(), dst_format, width, height));
+
+                    vector<unsigned char> actual = make_pattern(src_size + guard_size, 0);
+                    copy(src.begin(), src.end(), actual.begin());
+                    const vector<unsigned char> guard(actual.begin() + static_cast<ptrdiff_t>(src_size),
+                                                      actual.end());
+                    CHECK(convert_pixels(actual.data(), src_format, actual.data(), dst_format, width, height));
+                    check_same("in place", src_format, dst_format, width, height, expected,
+                               vector<unsigned char>(actual.begin(), actual.begin() + static_cast<ptrdiff_t>(dst_size)));
+                    CHECK(equal(guard.begin(), guard.end(), actual.begin() + static_cast<ptrdiff_t>(src_size)));
+
+                    vector<unsigned char> scalar = src;
+                    CHECK(convert_pixels_scalar(scalar.data(), src_format, scalar.data(), dst_format, width, height));
+                    scalar.resize(dst_size);
+                    check_same("scalar in place", src_format, dst_format, width, height, expected, scalar);
+                }
+            }
+        }
+    }
+    // Same format, rgb and bgr both ways, rgba to rgb or bgr, packed to gray and to yuv420, yuv420 to gray.
+    CHECK_EQ(size_t{5 + 2 + 2 + 3 + 3 + 1}, pairs);
+}
+
+/**
+ * A few results worked out by hand, so the scalar reference itself is
+ * checked as well.
+ */
+void test_known_values() {
+    constexpr size_t width = 17;
+    const vector<unsigned char> rgb = make_pattern(width * 3, 3);
+    vector<unsigned char> bgr(width * 3);
+    CHECK(convert_pixels(rgb.data(), PixelFormat::rgb, bgr.data(), PixelFormat::bgr, width, 1));
+    vector<unsigned char> rgba(width * 4);
+    CHECK(convert_pixels(bgr.data(), PixelFormat::bgr, rgba.data(), PixelFormat::rgba, width, 1));
+    for (size_t i = 0; i < width; ++i) {
+        CHECK_EQ(+rgb[i * 3], +bgr[i * 3 + 2]);
+        CHECK_EQ(+rgb[i * 3 + 1], +bgr[i * 3 + 1]);
+        CHECK_EQ(+rgb[i * 3 + 2], +bgr[i * 3]);
+        CHECK_EQ(+rgb[i * 3], +rgba[i * 4]);
+        CHECK_EQ(+rgb[i * 3 + 2], +rgba[i * 4 + 2]);
+        CHECK_EQ(255, +rgba[i * 4 + 3]);
+    }
+
+    // Gray to rgb and back is lossless, and white and black stay white and black in yuv420.
+    const vector<unsigned char> gray = make_pattern(width, 5);
+    vector<unsigned char> through_rgb(width * 3);
+    CHECK(convert_pixels(gray.data(), PixelFormat::gray, through_rgb.data(), PixelFormat::rgb, width, 1));
+    CHECK(convert_pixels(through_rgb.data(), PixelFormat::rgb, through_rgb.data(), PixelFormat::gray, width, 1));
+    CHECK(equal(gray.begin(), gray.end(), through_rgb.begin()));
+
+    const unsigned char white_black[] = {255, 255, 255, 0, 0, 0};
+    unsigned char yuv[4] = {};
+    CHECK(convert_pixels(white_black, PixelFormat::rgb, yuv, PixelFormat::yuv420, 2, 1));
+    CHECK_EQ(235, +yuv[0]);
+    CHECK_EQ(16, +yuv[1]);
+    CHECK_EQ(128, +yuv[2]);
+    CHECK_EQ(128, +yuv[3]);
+
+    unsigned char jpeg[3] = {};
+    CHECK(!convert_pixels(white_black, PixelFormat::rgb, jpeg, PixelFormat::jpeg, 1, 1));
+}
+
+}
+
+int main() {
+    cout << "Checking " << get_simd_backend_name() << " conversions" << '\n';
+    test_out_of_place_matches_scalar();
+    test_in_place_matches_out_of_place();
+    test_known_values();
+    return check_result();
+}
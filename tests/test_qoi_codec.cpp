@@ -0,0 +1,226 @@
+//
+// Created by Joe Pettinelli on 10/17/26.
+//
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "qoi_codec.h"
+#include "test_check.h"
+
+using namespace std;
+
+namespace {
+
+/**
+ * Make an image from a function of the pixel position and channel.
+ *
+ * @param width The width in pixels.
+ * @param height The height in pixels.
+ * @param format rgb or rgba.
+ * @param value Returns the byte for x, y and channel.
+ * @return The image.
+ */
+template <typename Value>
+Image make_image(const unsigned int width, const unsigned int height, const PixelFormat format, Value value) {
+    const unsigned int channels = pixel_format_info(format).bytes_per_pixel;
+    Image image(pixel_format_frame_size(format, width, height), width, height, format, false);
+    unsigned char* p = image.get_data();
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            for (unsigned int c = 0; c < channels; ++c) {
+                *p++ = value(x, y, c);
+            }
+        }
+    }
+    return image;
+}
+
+/**
+ * A byte that looks random but is the same on every run.
+ */
+unsigned char noise(const unsigned int x, const unsigned int y, const unsigned int c) {
+    uint32_t seed = x * 73856093u ^ y * 19349663u ^ c * 83492791u;
+    seed = seed * 1664525u + 1013904223u;
+    return static_cast<unsigned char>(seed >> 24);
+}
+
+/**
+ * Count a failed check if a decoded image does not hold the pixels of
+ * its source. The source can be a crop view.
+ *
+ * @param name What is being checked.
+ * @param source The image that was encoded.
+ * @param decoded The decoded image.
+ */
+void check_same_pixels(const string& name, const Image& source, const Image& decoded) {
+    if (decoded.get_data() == nullptr || decoded.get_width() != source.get_width() ||
+        decoded.get_height() != source.get_height() || decoded.get_format() != source.get_format() ||
+        !decoded.is_contiguous()) {
+        cerr << name << ": decoded image has the wrong size or format" << '\n';
+        ++check_failures;
+        return;
+    }
+    const size_t row_size = pixel_format_row_size(source.get_format(), source.get_width());
+    for (unsigned int y = 0; y < source.get_height(); ++y) {
+        if (memcmp(source.get_data() + y * source.get_stride(), decoded.get_data() + y * row_size, row_size) != 0) {
+            cerr << name << ": row " << y << " differs" << '\n';
+            ++check_failures;
+            return;
+        }
+    }
+}
+
+/**
+ * Encode in memory, decode again and compare.
+ */
+void check_round_trip(const string& name, const Image& source) {
+    const Image encoded = encode_qoi(source);
+    CHECK(encoded.get_format() == PixelFormat::qoi);
+    check_same_pixels(name, source, decode_qoi(encoded));
+}
+
+/**
+ * rgb and rgba images of noise, gradients and repeated colors, which
+ * between them use every chunk type, decode to the same pixels.
+ */
+void test_rgb_and_rgba_round_trip() {
+    for (const PixelFormat format : {PixelFormat::rgb, PixelFormat::rgba}) {
+        const string name = pixel_format_name(format);
+        check_round_trip(name + " noise", make_image(37, 11, format, noise));
+        check_round_trip(name + " gradient", make_image(64, 9, format, [](auto x, auto y, auto c) {
+            return static_cast<unsigned char>(c == 3 ? 255 : x * (c + 1) + y * 3);
+        }));
+        check_round_trip(name + " palette", make_image(45, 13, format, [](auto x, auto y, auto c) {
+            return static_cast<unsigned char>(c == 3 ? 255 : ((x + y) % 5) * 50 + c * 7);
+        }));
+        check_round_trip(name + " one pixel", make_image(1, 1, format, noise));
+    }
+}
+
+/**
+ * Runs longer than one run chunk holds, across rows and across the
+ * chunks the encoder hands out, and a run that ends the image.
+ */
+void test_long_runs() {
+    check_round_trip("rows of one color", make_image(200, 7, PixelFormat::rgb, [](auto, auto y, auto c) {
+        return static_cast<unsigned char>(y / 2 * 40 + c);
+    }));
+    check_round_trip("run of exactly 62", make_image(63, 2, PixelFormat::rgba, [](auto x, auto y, auto c) {
+        return static_cast<unsigned char>(x == 0 && y == 1 ? 9 : c);
+    }));
+    // Big enough that the encoder hands the output to the sink in more than one chunk.
+    check_round_trip("large", make_image(300, 500, PixelFormat::rgb, [](auto x, auto y, auto c) {
+        return y % 50 == 0 ? noise(x, y, c) : static_cast<unsigned char>(c);
+    }));
+
+    const Image solid = make_image(1000, 10, PixelFormat::rgb, [](auto, auto, auto) {
+        return static_cast<unsigned char>(0x80);
+    });
+    const Image encoded = encode_qoi(solid);
+    // One rgb chunk, then 9999 pixels in 62 pixel runs.
+    CHECK_EQ(QoiEncoder::header_size + 4 + (9999 + 61) / 62 + QoiEncoder::end_size, encoded.get_size());
+    check_same_pixels("solid", solid, decode_qoi(encoded));
+}
+
+/**
+ * Alpha changes with and without the color changing, including pixels
+ * that only differ in alpha from the one before.
+ */
+void test_alpha_changes() {
+    check_round_trip("alpha steps", make_image(50, 6, PixelFormat::rgba, [](auto x, auto y, auto c) {
+        return static_cast<unsigned char>(c == 3 ? (x / 3 % 4) * 85 : 100 + y);
+    }));
+    check_round_trip("alpha noise", make_image(29, 17, PixelFormat::rgba, [](auto x, auto y, auto c) {
+        return c == 3 ? noise(x, y, c) : static_cast<unsigned char>(x + c);
+    }));
+    check_round_trip("alpha back and forth", make_image(64, 3, PixelFormat::rgba, [](auto x, auto, auto c) {
+        return static_cast<unsigned char>(c == 3 ? (x % 2 == 0 ? 255 : 0) : 10);
+    }));
+}
+
+/**
+ * A crop view is encoded from its rows, skipping the stride between
+ * them, and decodes to packed pixels.
+ */
+void test_crop_view() {
+    for (const PixelFormat format : {PixelFormat::rgb, PixelFormat::rgba}) {
+        const Image full = make_image(41, 23, format, noise);
+        const Image view = full.crop(5, 3, 29, 17);
+        CHECK(!view.is_contiguous());
+        CHECK(can_encode_qoi(view));
+        check_round_trip(string("crop ") + pixel_format_name(format), view);
+        check_round_trip(string("bottom right crop ") + pixel_format_name(format), full.crop(40, 22, 1, 1));
+    }
+}
+
+/**
+ * Cutting encoded data short anywhere gives an empty image, not a
+ * partly decoded one. So do data that is not QOI and images that
+ * cannot be encoded.
+ */
+void test_truncated_input() {
+    const Image source = make_image(23, 9, PixelFormat::rgba, [](auto x, auto y, auto c) {
+        return y % 3 == 0 ? noise(x, y, c) : static_cast<unsigned char>(x / 4 + c);
+    });
+    const Image encoded = encode_qoi(source);
+    CHECK(encoded.get_size() > QoiEncoder::header_size + QoiEncoder::end_size);
+    for (size_t size = 0; size < encoded.get_size(); ++size) {
+        if (decode_qoi(encoded.get_data(), size).get_data() != nullptr) {
+            cerr << "decoded " << size << " of " << encoded.get_size() << " bytes" << '\n';
+            ++check_failures;
+        }
+    }
+    CHECK(decode_qoi(nullptr, 0).get_data() == nullptr);
+    CHECK(decode_qoi(source).get_data() == nullptr);
+    vector<unsigned char> not_qoi(encoded.get_data(), encoded.get_data() + encoded.get_size());
+    not_qoi[0] = 'x';
+    CHECK(decode_qoi(not_qoi.data(), not_qoi.size()).get_data() == nullptr);
+
+    const Image gray(16, 4, 4, PixelFormat::gray, false);
+    CHECK(!can_encode_qoi(gray));
+    CHECK(encode_qoi(gray).get_data() == nullptr);
+}
+
+/**
+ * Image::save() to a .qoi path writes the same bytes as encode_qoi(),
+ * and load_qoi() reads them back.
+ */
+void test_save_matches_load() {
+    const string directory = filesystem::temp_directory_path().string();
+    for (const PixelFormat format : {PixelFormat::rgb, PixelFormat::rgba}) {
+        const Image full = make_image(35, 19, format, noise);
+        for (const Image& source : {full, full.crop(2, 1, 30, 15)}) {
+            const string file_path = directory + "/raspi_hw_qoi_test." + pixel_format_name(format) + ".qoi";
+            CHECK(has_qoi_extension(file_path));
+            CHECK(source.save(file_path));
+
+            ifstream file(file_path, ios::binary);
+            const vector<unsigned char> saved((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+            const Image encoded = encode_qoi(source);
+            CHECK_EQ(encoded.get_size(), saved.size());
+            CHECK(saved.size() == encoded.get_size() && memcmp(saved.data(), encoded.get_data(), saved.size()) == 0);
+
+            check_same_pixels(file_path, source, load_qoi(file_path));
+            remove(file_path.c_str());
+        }
+    }
+    CHECK(load_qoi(directory + "/raspi_hw_qoi_missing.qoi").get_data() == nullptr);
+}
+
+}
+
+int main() {
+    test_rgb_and_rgba_round_trip();
+    test_long_runs();
+    test_alpha_changes();
+    test_crop_view();
+    test_truncated_input();
+    test_save_matches_load();
+    return check_result();
+}